@@ -2,14 +2,17 @@
 
 
 #include "BoostPad.h"
+#include "SkylineShredder.h"
 #include "SkylineShredderCharacter.h"
+#include "MovementModifierComponent.h"
+#include "ParkourTelemetry.h"
 #include <GameFramework/CharacterMovementComponent.h>
 
 // Sets default values
 ABoostPad::ABoostPad()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	//The boost is timed by the player's movement modifiers, so the pad never needs to tick
+	PrimaryActorTick.bCanEverTick = false;
 
 }
 
@@ -22,34 +25,18 @@ void ABoostPad::BeginPlay()
 
 void ABoostPad::NotifyActorBeginOverlap(AActor* OtherActor)
 {
-	Player = dynamic_cast<ASkylineShredderCharacter*>(OtherActor);
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourPadCallbacks);
 
-	if (!CurrentlyBoosting && Player != nullptr)
-	{
-		Player->BaseSpeed += BoostAmount;
-
-		Player->SetMomentum(Player->GetMomentum() + 200.0f);
-
-		CurrentlyBoosting = true;
-	}
-}
-
-// Called every frame
-void ABoostPad::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
+	ASkylineShredderCharacter* player = dynamic_cast<ASkylineShredderCharacter*>(OtherActor);
 
-	if (CurrentlyBoosting)
+	//Every player gets their own boost, but a player already boosted by this pad can't stack it
+	if (player != nullptr && !player->GetMovementModifiers()->HasModifierFromSource(this))
 	{
-		CurrentBoostDuration += GetWorld()->DeltaTimeSeconds;
-
-		if (CurrentBoostDuration >= BoostDuration && Player)
-		{
-			CurrentlyBoosting = false;
-			Player->BaseSpeed -= BoostAmount;
-			Player = nullptr;
-			CurrentBoostDuration = 0.0f;
-		}
+		player->GetMovementModifiers()->AddModifier(EMovementModifierAttribute::Speed, EMovementModifierOp::Additive, BoostAmount, BoostDuration, this);
+		PARKOUR_COUNTER_ADD(ParkourPadActivations, 1);
+		player->AddTelemetryEvent(FParkourTelemetrySample::EVENT_PadHit);
+
+		player->SetMomentum(player->GetMomentum() + 200.0f);
 	}
 }
 
@@ -21,18 +21,11 @@ protected:
 
 	virtual void NotifyActorBeginOverlap(AActor* OtherActor) override;
 
-public:	 
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 private:
 	UPROPERTY(EditAnywhere)
 	float BoostAmount = 2000.0f;
 
-	bool CurrentlyBoosting = false;
+	UPROPERTY(EditAnywhere)
 	float BoostDuration = 2.5f;
-	float CurrentBoostDuration = 0.0f;
-
-	class ASkylineShredderCharacter* Player = nullptr;
 
 };
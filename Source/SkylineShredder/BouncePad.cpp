@@ -2,14 +2,18 @@
 
 
 #include "BouncePad.h"
+#include "SkylineShredder.h"
 #include "SkylineShredderCharacter.h"
+#include "PadSchedulerSubsystem.h"
+#include "MovementModifierComponent.h"
+#include "ParkourTelemetry.h"
 #include <GameFramework/CharacterMovementComponent.h>
 
 // Sets default values
 ABouncePad::ABouncePad()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	//The cooldown runs on the pad scheduler, so the pad never needs to tick
+	PrimaryActorTick.bCanEverTick = false;
 
 }
 
@@ -22,32 +26,22 @@ void ABouncePad::BeginPlay()
 
 void ABouncePad::NotifyHit(UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
 {
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourPadCallbacks);
+
 	if (CanInteract)
 	{
 		ASkylineShredderCharacter* player = dynamic_cast<ASkylineShredderCharacter*>(Other);
 
-		player->GetCharacterMovement()->AddImpulse(LaunchVelocity, true);
+		player->GetMovementModifiers()->AddImpulse(LaunchVelocity, true);
 
 		player->NumberOfJumps = 1;
+		PARKOUR_COUNTER_ADD(ParkourPadActivations, 1);
+		player->AddTelemetryEvent(FParkourTelemetrySample::EVENT_PadHit);
 
 		CanInteract = false;
-	}
-}
-
-// Called every frame
-void ABouncePad::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-	if (!CanInteract)
-	{
-		CurrentTimeUntilCanInteract += GetWorld()->DeltaTimeSeconds;
 
-		if (CurrentTimeUntilCanInteract >= TimeUntilCanInteract)
-		{
-			CanInteract = true;
-			CurrentTimeUntilCanInteract = 0.0f;
-		}
+		//Let the pad be used again once the cooldown is over
+		GetWorld()->GetSubsystem<UPadSchedulerSubsystem>()->SetTimer(TimeUntilCanInteract, FSimpleDelegate::CreateUObject(this, &ABouncePad::ToggleCanInteract));
 	}
 }
 
@@ -22,9 +22,6 @@ protected:
 	virtual void NotifyHit(class UPrimitiveComponent* MyComp, AActor* Other, class UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit);
 
 	void ToggleCanInteract() { CanInteract = !CanInteract; }
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 
 private:
 	UPROPERTY(EditAnywhere)
@@ -33,6 +30,5 @@ private:
 	bool CanInteract = true;
 
 	float TimeUntilCanInteract = 0.5f;
-	float CurrentTimeUntilCanInteract = 0.0f;
 
 };
@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CameraRigComponent.h"
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "Engine/World.h"
+
+UCameraRigComponent::UCameraRigComponent()
+{
+	TargetArmLength = MinArmLength;
+}
+
+void UCameraRigComponent::OnRegister()
+{
+	//Registering places the arm straight away, so start at the length for standing still
+	SpeedArmLength = MinArmLength;
+	CollisionArmLength = MinArmLength;
+	ProbeArmDirection = -FVector::ForwardVector;
+	ClearLength = TNumericLimits<float>::Max();
+	TargetArmLength = MinArmLength;
+	Lead = FVector::ZeroVector;
+	ProbeTrace = FTraceHandle();
+
+	Super::OnRegister();
+}
+
+void UCameraRigComponent::UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime)
+{
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourCameraRig);
+
+	UpdateSpeed(DeltaTime);
+
+	if (bDoTrace)
+		ReadProbe();
+	else
+		ClearLength = TNumericLimits<float>::Max();
+
+	//Pull in quickly so the camera doesn't go through anything, and let out slowly so it doesn't pop back
+	const float DesiredLength = FMath::Min(ClearLength, SpeedArmLength);
+	const float InterpSpeed = DesiredLength < CollisionArmLength ? CollisionPullInSpeed : CollisionRecoverSpeed;
+	CollisionArmLength = FMath::Min(FMath::FInterpTo(CollisionArmLength, DesiredLength, DeltaTime, InterpSpeed), SpeedArmLength);
+	bBlocked = ClearLength < SpeedArmLength;
+
+	//The spring arm places the camera without its own sweep, the rig's sweep has already been taken into account
+	TargetArmLength = CollisionArmLength;
+	TargetOffset = Lead;
+	Super::UpdateDesiredArmLocation(false, bDoLocationLag, bDoRotationLag, DeltaTime);
+
+	if (bDoTrace)
+		StartProbe(DeltaTime);
+}
+
+void UCameraRigComponent::UpdateSpeed(float DeltaTime)
+{
+	const AActor* Owner = GetOwner();
+	const FVector Velocity = Owner ? Owner->GetVelocity() : FVector::ZeroVector;
+
+	//Only Skyline runners have momentum, anything else gets the arm for its speed alone
+	const ASkylineShredderCharacter* Runner = Cast<ASkylineShredderCharacter>(Owner);
+	const float Momentum = Runner ? Runner->GetInterpolatedMomentum() : 0.0f;
+
+	const float SpeedAlpha = FMath::Clamp(Velocity.Size() / FMath::Max(SpeedForMaxArm, 1.0f), 0.0f, 1.0f);
+	const float MomentumAlpha = FMath::Clamp(Momentum / FMath::Max(MomentumForMaxArm, 1.0f), 0.0f, 1.0f);
+	const float DesiredLength = FMath::Lerp(MinArmLength, MaxArmLength, 0.5f * (SpeedAlpha + MomentumAlpha));
+	SpeedArmLength = FMath::FInterpTo(SpeedArmLength, DesiredLength, DeltaTime, SpeedInterpSpeed);
+
+	//Look ahead along the ground, not up or down, so jumps and falls don't swing the camera
+	const FVector DesiredLead = (FVector(Velocity.X, Velocity.Y, 0.0f) * LeadPerSpeed).GetClampedToMaxSize(MaxLead);
+	Lead = FMath::VInterpTo(Lead, DesiredLead, DeltaTime, SpeedInterpSpeed);
+}
+
+void UCameraRigComponent::ReadProbe()
+{
+	UWorld* World = GetWorld();
+	FTraceDatum ProbeData;
+	if (!ProbeTrace.IsValid() || !World || !World->QueryTraceData(ProbeTrace, ProbeData))
+		return;
+
+	ProbeTrace = FTraceHandle();
+
+	//Clear as far along the arm as the sweep got. The sweep also covers the owner's movement and the socket offset,
+	//so only the part of it along the arm counts. A sweep that starts inside something says nothing about the arm,
+	//so it doesn't pull the camera in
+	const FHitResult* Hit = ProbeData.OutHits.Num() > 0 && ProbeData.OutHits[0].bBlockingHit && !ProbeData.OutHits[0].bStartPenetrating ? &ProbeData.OutHits[0] : nullptr;
+	ClearLength = Hit ? FMath::Max(FVector::DotProduct(Hit->Location - Hit->TraceStart, ProbeArmDirection), 0.0f) : TNumericLimits<float>::Max();
+}
+
+void UCameraRigComponent::StartProbe(float DeltaTime)
+{
+	UWorld* World = GetWorld();
+	const AActor* Owner = GetOwner();
+	if (!World || !Owner)
+		return;
+
+	//The result is used next frame, so sweep towards where the camera will be by then. The sweep starts at the pivot,
+	//which is inside the owner's capsule, since starting ahead of the owner can start inside a wall
+	const FRotator Rotation = GetTargetRotation();
+	const FVector Origin = GetComponentLocation() + TargetOffset;
+	const FVector End = Origin + Owner->GetVelocity() * DeltaTime - Rotation.Vector() * SpeedArmLength + Rotation.RotateVector(SocketOffset);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CameraRig), false, Owner);
+	ProbeTrace = World->AsyncSweepByChannel(EAsyncTraceType::Single, Origin, End, FQuat::Identity, ProbeChannel, FCollisionShape::MakeSphere(ProbeSize), QueryParams);
+	ProbeArmDirection = -Rotation.Vector();
+
+	PARKOUR_SCENE_QUERIES(1);
+}
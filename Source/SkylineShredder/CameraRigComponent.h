@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/SpringArmComponent.h"
+#include "WorldCollision.h"
+#include "CameraRigComponent.generated.h"
+
+/// <summary>
+/// The camera boom of a runner. Instead of the spring arm sweeping for collision on the game thread every
+/// frame, the sweep is sent off async and its result used the frame after. The sweep starts from where the
+/// runner will be by then, so the one frame of lag doesn't let the camera through walls at speed, and the arm
+/// pulls in quickly and lets out slowly so it doesn't pop. The arm gets longer and leads further ahead of the
+/// runner the faster it goes and the more momentum it has.
+/// The rig sets TargetArmLength and TargetOffset itself, set the lengths and lead on the rig instead.
+/// </summary>
+UCLASS(ClassGroup = Camera, meta = (BlueprintSpawnableComponent))
+class SKYLINESHREDDER_API UCameraRigComponent : public USpringArmComponent
+{
+	GENERATED_BODY()
+
+public:
+	UCameraRigComponent();
+
+	//The arm length standing still, and at full speed with full momentum
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float MinArmLength = 300.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float MaxArmLength = 550.0f;
+
+	//The speed in cm/s and the momentum at which the arm is longest, each counts for half
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float SpeedForMaxArm = 3000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float MomentumForMaxArm = 1500.0f;
+
+	//How far ahead of the runner the camera looks for each cm/s it moves along the ground, and the furthest it looks ahead
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float LeadPerSpeed = 0.05f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float MaxLead = 150.0f;
+
+	//How quickly the arm length and lead follow the speed
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float SpeedInterpSpeed = 3.0f;
+
+	//How quickly the arm pulls in when something is in the way and lets back out when it is clear, 0 snaps
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float CollisionPullInSpeed = 30.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Camera Rig")
+	float CollisionRecoverSpeed = 4.0f;
+
+	UFUNCTION(BlueprintCallable, Category = "Camera Rig")
+	float GetSpeedArmLength() const { return SpeedArmLength; }
+
+	UFUNCTION(BlueprintCallable, Category = "Camera Rig")
+	bool IsCameraBlocked() const { return bBlocked; }
+
+protected:
+	virtual void OnRegister() override;
+	virtual void UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime) override;
+
+private:
+	//The arm length and lead for the speed, before collision
+	float SpeedArmLength = 0.0f;
+	FVector Lead = FVector::ZeroVector;
+
+	//The arm length after collision, what the spring arm is given
+	float CollisionArmLength = 0.0f;
+	bool bBlocked = false;
+
+	//The sweep sent last frame, the direction of the arm it was sent for and how far along the arm it was clear
+	FTraceHandle ProbeTrace;
+	FVector ProbeArmDirection = -FVector::ForwardVector;
+	float ClearLength = TNumericLimits<float>::Max();
+
+	//Sets the arm length and lead from the owner's velocity and momentum
+	void UpdateSpeed(float DeltaTime);
+
+	//Takes how far it is clear from the sweep sent last frame, if it is back
+	void ReadProbe();
+
+	//Sends the sweep for next frame from where the owner will be
+	void StartProbe(float DeltaTime);
+};
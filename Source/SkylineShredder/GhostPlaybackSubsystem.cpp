@@ -0,0 +1,282 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GhostPlaybackSubsystem.h"
+#include "SkylineShredder.h"
+#include "Async/Async.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInterface.h"
+
+UGhostPlaybackSubsystem::UGhostPlaybackSubsystem()
+{
+	GhostMesh = TSoftObjectPtr<UStaticMesh>(FSoftObjectPath(TEXT("/Engine/BasicShapes/Cylinder.Cylinder")));
+}
+
+void UGhostPlaybackSubsystem::Deinitialize()
+{
+	//Reads still running hold their own stream, so they can finish on their own
+	Ghosts.Empty();
+	InstanceTransforms.Empty();
+	NumPlaying = 0;
+	GhostActor = nullptr;
+	GhostInstances = nullptr;
+
+	Super::Deinitialize();
+}
+
+TStatId UGhostPlaybackSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UGhostPlaybackSubsystem, STATGROUP_Parkour);
+}
+
+int32 UGhostPlaybackSubsystem::PlayGhost(const FString& GhostName, bool bLoop)
+{
+	return PlayGhostFile(FGhostFile::GetGhostPath(GhostName), bLoop);
+}
+
+int32 UGhostPlaybackSubsystem::PlayGhostFile(const FString& Path, bool bLoop)
+{
+	if (!EnsureInstances())
+		return INDEX_NONE;
+
+	//Reuse the instance of a stopped ghost if there is one
+	int32 Index = Ghosts.IndexOfByPredicate([](const FGhost& Ghost) { return Ghost.Id == INDEX_NONE; });
+	if (Index == INDEX_NONE)
+	{
+		Index = Ghosts.AddDefaulted();
+		InstanceTransforms.Add(FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector));
+		GhostInstances->AddInstance(InstanceTransforms[Index], true);
+	}
+
+	FGhost& Ghost = Ghosts[Index];
+	Ghost.Id = NextGhostId++;
+	Ghost.bLoop = bLoop;
+	StartStream(Ghost, Path);
+	NumPlaying++;
+
+	return Ghost.Id;
+}
+
+void UGhostPlaybackSubsystem::StopGhost(int32 GhostId)
+{
+	FGhost* Ghost = Ghosts.FindByPredicate([GhostId](const FGhost& Other) { return Other.Id == GhostId; });
+	if (!Ghost)
+		return;
+
+	FreeGhost(*Ghost);
+
+	//Hide the instance straight away since nothing ticks once the last ghost stops
+	if (GhostInstances)
+		GhostInstances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+}
+
+void UGhostPlaybackSubsystem::StopAllGhosts()
+{
+	for (FGhost& Ghost : Ghosts)
+	{
+		if (Ghost.Id != INDEX_NONE)
+			FreeGhost(Ghost);
+	}
+
+	if (GhostInstances)
+		GhostInstances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+}
+
+bool UGhostPlaybackSubsystem::GetGhostFrame(int32 GhostId, FGhostFrame& OutFrame) const
+{
+	const FGhost* Ghost = Ghosts.FindByPredicate([GhostId](const FGhost& Other) { return Other.Id == GhostId; });
+	if (!Ghost || !Ghost->bHasFrame)
+		return false;
+
+	OutFrame = Ghost->Current;
+	return true;
+}
+
+void UGhostPlaybackSubsystem::Tick(float DeltaTime)
+{
+	if (!GhostInstances)
+		return;
+
+	for (int32 Index = 0; Index < Ghosts.Num(); Index++)
+	{
+		FGhost& Ghost = Ghosts[Index];
+		if (Ghost.Id == INDEX_NONE)
+			continue;
+
+		if (!AdvanceGhost(Ghost, DeltaTime))
+		{
+			FreeGhost(Ghost);
+			continue;
+		}
+
+		//Ghosts still waiting for their first chunk stay hidden
+		if (Ghost.bHasFrame)
+			InstanceTransforms[Index] = FTransform(FRotator(0.0f, Ghost.Current.Yaw, 0.0f), Ghost.Current.Location, GhostMeshScale);
+	}
+
+	//Every instance is updated in one go
+	GhostInstances->BatchUpdateInstancesTransforms(0, InstanceTransforms, true, true, true);
+}
+
+bool UGhostPlaybackSubsystem::EnsureInstances()
+{
+	if (GhostInstances)
+		return true;
+
+	UStaticMesh* Mesh = GhostMesh.LoadSynchronous();
+	if (!Mesh)
+	{
+		UE_LOG(LogSkylineShredder, Warning, TEXT("Can't play ghosts, the ghost mesh %s didn't load"), *GhostMesh.ToString());
+		return false;
+	}
+
+	FActorSpawnParameters Params;
+	Params.ObjectFlags |= RF_Transient;
+	GhostActor = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, Params);
+	if (!GhostActor)
+		return false;
+
+	GhostInstances = NewObject<UInstancedStaticMeshComponent>(GhostActor, TEXT("GhostInstances"));
+	GhostInstances->SetStaticMesh(Mesh);
+	if (UMaterialInterface* Material = GhostMaterial.LoadSynchronous())
+		GhostInstances->SetMaterial(0, Material);
+
+	//Ghosts are only there to be seen
+	GhostInstances->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	GhostInstances->SetCanEverAffectNavigation(false);
+	GhostInstances->CastShadow = false;
+	GhostInstances->SetMobility(EComponentMobility::Movable);
+
+	GhostActor->SetRootComponent(GhostInstances);
+	GhostInstances->RegisterComponent();
+	return true;
+}
+
+void UGhostPlaybackSubsystem::StartStream(FGhost& Ghost, const FString& Path)
+{
+	Ghost.Stream = MakeShared<FGhostStream, ESPMode::ThreadSafe>();
+	Ghost.Stream->Path = Path;
+	Ghost.PendingRead = TFuture<FGhostChunk>();
+	Ghost.Frames.Reset();
+	Ghost.FirstFrame = 0;
+	Ghost.bEndOfFile = false;
+	Ghost.SampleRate = 0;
+	Ghost.Time = 0.0f;
+
+	//Even opening the file happens on a worker
+	ReadNextChunk(Ghost);
+}
+
+void UGhostPlaybackSubsystem::ReadNextChunk(FGhost& Ghost)
+{
+	Ghost.PendingRead = Async(EAsyncExecution::ThreadPool, [Stream = Ghost.Stream]()
+	{
+		FGhostChunk Chunk;
+		if (!Stream->bOpened)
+		{
+			Stream->bOpened = true;
+			if (!Stream->File.Open(Stream->Path))
+				return Chunk;
+		}
+
+		Chunk.SampleRate = Stream->File.GetHeader().SampleRate;
+		Chunk.bValid = Stream->File.ReadNextChunk(Chunk.Frames);
+		Chunk.bEndOfFile = !Chunk.bValid || Stream->File.IsAtEnd();
+		return Chunk;
+	});
+}
+
+void UGhostPlaybackSubsystem::ReceiveChunk(FGhost& Ghost)
+{
+	FGhostChunk Chunk = Ghost.PendingRead.Get();
+	Ghost.PendingRead = TFuture<FGhostChunk>();
+
+	if (!Chunk.bValid)
+	{
+		Ghost.bEndOfFile = true;
+		return;
+	}
+
+	Ghost.SampleRate = Chunk.SampleRate;
+	Ghost.Frames.Append(MoveTemp(Chunk.Frames));
+	Ghost.bEndOfFile = Chunk.bEndOfFile;
+}
+
+bool UGhostPlaybackSubsystem::AdvanceGhost(FGhost& Ghost, float DeltaTime)
+{
+	if (Ghost.PendingRead.IsValid() && Ghost.PendingRead.IsReady())
+		ReceiveChunk(Ghost);
+
+	//Still opening, or the file couldn't be read at all
+	if (Ghost.SampleRate == 0)
+		return !Ghost.bEndOfFile;
+
+	Ghost.Time += DeltaTime;
+	const float FramePosition = Ghost.Time * Ghost.SampleRate;
+	const int32 Frame = FMath::FloorToInt(FramePosition);
+
+	//Let go of the frames that have been played
+	const int32 Played = FMath::Min(Frame - Ghost.FirstFrame, Ghost.Frames.Num() - 1);
+	if (Played > 0)
+	{
+		Ghost.Frames.RemoveAt(0, Played, false);
+		Ghost.FirstFrame += Played;
+	}
+
+	//Keep about a second read ahead
+	const int32 FramesAhead = Ghost.Frames.Num() - (Frame - Ghost.FirstFrame);
+	if (FramesAhead < Ghost.SampleRate && !Ghost.PendingRead.IsValid() && !Ghost.bEndOfFile)
+		ReadNextChunk(Ghost);
+
+	const int32 Local = Frame - Ghost.FirstFrame;
+	if (Ghost.Frames.IsValidIndex(Local + 1))
+	{
+		//Interpolate between the two frames either side of the playback time
+		const FGhostFrame& From = Ghost.Frames[Local];
+		const FGhostFrame& To = Ghost.Frames[Local + 1];
+		const float Alpha = FramePosition - Frame;
+
+		Ghost.Current = From;
+		Ghost.Current.Location = FMath::Lerp(From.Location, To.Location, Alpha);
+		Ghost.Current.Velocity = FMath::Lerp(From.Velocity, To.Velocity, Alpha);
+		Ghost.Current.Yaw = From.Yaw + FRotator::NormalizeAxis(To.Yaw - From.Yaw) * Alpha;
+		Ghost.bHasFrame = true;
+		return true;
+	}
+
+	if (Ghost.Frames.Num() > 0)
+	{
+		Ghost.Current = Ghost.Frames.Last();
+		Ghost.bHasFrame = true;
+	}
+
+	//Waiting on the next chunk, hold the last frame until it comes in
+	if (!Ghost.bEndOfFile || Ghost.PendingRead.IsValid())
+		return true;
+
+	//Played to the end
+	if (Ghost.bLoop)
+	{
+		StartStream(Ghost, Ghost.Stream->Path);
+		return true;
+	}
+
+	return false;
+}
+
+void UGhostPlaybackSubsystem::FreeGhost(FGhost& Ghost)
+{
+	const int32 Index = &Ghost - Ghosts.GetData();
+
+	Ghost.Id = INDEX_NONE;
+	Ghost.Stream.Reset();
+	Ghost.PendingRead = TFuture<FGhostChunk>();
+	Ghost.Frames.Empty();
+	Ghost.bHasFrame = false;
+	NumPlaying--;
+
+	//Stopped ghosts are scaled to nothing until their instance is reused
+	InstanceTransforms[Index] = FTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+}
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GhostRecording.h"
+#include "GhostPlaybackSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UMaterialInterface;
+class UStaticMesh;
+
+/// <summary>
+/// Plays recorded ghosts back as instances of one instanced mesh instead of a character each. Ghost files
+/// are streamed from disk a chunk at a time on worker threads, so the game thread only interpolates between
+/// two frames per ghost and updates all the instances in one batch. Only ticks while a ghost is playing.
+/// </summary>
+UCLASS(config = Game)
+class SKYLINESHREDDER_API UGhostPlaybackSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UGhostPlaybackSubsystem();
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return NumPlaying > 0; }
+	virtual TStatId GetStatId() const override;
+
+	/// <summary>
+	/// Starts playing a ghost saved in Saved/Ghosts
+	/// </summary>
+	/// <param name="GhostName">the name the ghost was saved as</param>
+	/// <param name="bLoop">if the ghost starts again when it gets to the end</param>
+	/// <returns>the id of the ghost, used to stop it or get its state</returns>
+	UFUNCTION(BlueprintCallable, Category = "Ghost")
+	int32 PlayGhost(const FString& GhostName, bool bLoop = false);
+
+	/// <summary>
+	/// Starts playing a ghost file
+	/// </summary>
+	int32 PlayGhostFile(const FString& Path, bool bLoop = false);
+
+	UFUNCTION(BlueprintCallable, Category = "Ghost")
+	void StopGhost(int32 GhostId);
+
+	UFUNCTION(BlueprintCallable, Category = "Ghost")
+	void StopAllGhosts();
+
+	/// <summary>
+	/// Gets where a ghost is and what it is doing
+	/// </summary>
+	/// <returns>false if the ghost isn't playing or hasn't loaded yet</returns>
+	bool GetGhostFrame(int32 GhostId, FGhostFrame& OutFrame) const;
+
+	int32 GetNumPlaying() const { return NumPlaying; }
+
+	//The mesh every ghost is drawn with, and its scale
+	UPROPERTY(Config, EditAnywhere, Category = "Ghost")
+	TSoftObjectPtr<UStaticMesh> GhostMesh;
+
+	UPROPERTY(Config, EditAnywhere, Category = "Ghost")
+	FVector GhostMeshScale = FVector(0.84f, 0.84f, 1.92f);
+
+	UPROPERTY(Config, EditAnywhere, Category = "Ghost")
+	TSoftObjectPtr<UMaterialInterface> GhostMaterial;
+
+private:
+	//Reads one ghost file on worker threads, only one read is ever running for a stream
+	struct FGhostStream
+	{
+		FString Path;
+		FGhostFile File;
+		bool bOpened = false;
+	};
+
+	//The frames a read brought back
+	struct FGhostChunk
+	{
+		bool bValid = false;
+		bool bEndOfFile = false;
+		uint16 SampleRate = 0;
+		TArray<FGhostFrame> Frames;
+	};
+
+	//A playing ghost, its index is the index of its instance
+	struct FGhost
+	{
+		int32 Id = INDEX_NONE;
+		bool bLoop = false;
+		TSharedPtr<FGhostStream, ESPMode::ThreadSafe> Stream;
+		TFuture<FGhostChunk> PendingRead;
+
+		//The frames read ahead, and the index in the whole ghost of the first one
+		TArray<FGhostFrame> Frames;
+		int32 FirstFrame = 0;
+		bool bEndOfFile = false;
+
+		uint16 SampleRate = 0;
+		float Time = 0.0f;
+		FGhostFrame Current;
+		bool bHasFrame = false;
+	};
+
+	TArray<FGhost> Ghosts;
+	int32 NumPlaying = 0;
+	int32 NextGhostId = 1;
+
+	UPROPERTY()
+	AActor* GhostActor;
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* GhostInstances;
+
+	TArray<FTransform> InstanceTransforms;
+
+	bool EnsureInstances();
+	void StartStream(FGhost& Ghost, const FString& Path);
+	void ReadNextChunk(FGhost& Ghost);
+	void ReceiveChunk(FGhost& Ghost);
+	bool AdvanceGhost(FGhost& Ghost, float DeltaTime);
+	void FreeGhost(FGhost& Ghost);
+};
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GhostRecorderComponent.h"
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "GrappleComponent.h"
+
+// Sets default values for this component's properties
+UGhostRecorderComponent::UGhostRecorderComponent()
+{
+	//Only ticks while recording
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	//Sample after the character has moved for the frame
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UGhostRecorderComponent::StartRecording()
+{
+	SampleRate = FMath::Clamp(SampleRate, 1, (int32)MAX_uint16);
+
+	//A chunk holds about a second of the run
+	Encoder = MakeUnique<FGhostEncoder>(SampleRate);
+	SampleAccumulator = 0.0f;
+	RecordFrame();
+	SetComponentTickEnabled(true);
+}
+
+FString UGhostRecorderComponent::StopRecording(const FString& GhostName)
+{
+	SetComponentTickEnabled(false);
+	if (!Encoder.IsValid())
+		return FString();
+
+	TUniquePtr<FGhostEncoder> Finished = MoveTemp(Encoder);
+	Finished->Finish();
+	if (Finished->GetNumFrames() == 0)
+		return FString();
+
+	const FString Path = FGhostFile::GetGhostPath(GhostName);
+	FGhostFile::SaveAsync(Path, (uint16)SampleRate, *Finished);
+
+	UE_LOG(LogSkylineShredder, Log, TEXT("Saving ghost %s, %d frames in %d bytes (%.0f bytes a second)"), *Path, Finished->GetNumFrames(),
+		Finished->GetData().Num(), Finished->GetData().Num() * SampleRate / (float)Finished->GetNumFrames());
+	return Path;
+}
+
+void UGhostRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//A recording that was never stopped is thrown away
+	Encoder.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UGhostRecorderComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (!Encoder.IsValid())
+		return;
+
+	//Sample at the fixed rate so the ghost plays back at the right speed whatever the framerate was
+	const float SampleTime = 1.0f / SampleRate;
+	SampleAccumulator += DeltaTime;
+	while (SampleAccumulator >= SampleTime)
+	{
+		SampleAccumulator -= SampleTime;
+		RecordFrame();
+	}
+}
+
+void UGhostRecorderComponent::RecordFrame()
+{
+	const AActor* Owner = GetOwner();
+	if (!Owner)
+		return;
+
+	FGhostFrame Frame;
+	Frame.Location = Owner->GetActorLocation();
+	Frame.Velocity = Owner->GetVelocity();
+	Frame.Yaw = Owner->GetActorRotation().Yaw;
+
+	if (const ASkylineShredderCharacter* Character = Cast<ASkylineShredderCharacter>(Owner))
+	{
+		Frame.Flags = (Character->IsWallRunning() ? FGhostFrame::FLAG_WallRunning : 0)
+			| (Character->IsVaulting() ? FGhostFrame::FLAG_Vaulting : 0)
+			| (Character->IsClimbing() ? FGhostFrame::FLAG_Climbing : 0)
+			| (Character->GetGrapple()->IsHookAttached() ? FGhostFrame::FLAG_GrappleAttached : 0);
+		Frame.HookLocation = Character->GetGrapple()->GetHookLocation();
+	}
+
+	Encoder->AddFrame(Frame);
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "GhostRecording.h"
+#include "GhostRecorderComponent.generated.h"
+
+/// <summary>
+/// Records the run of the character it is on into a ghost that can be raced against. The character is
+/// sampled at a fixed rate into the compact ghost stream, which is saved on a worker thread when the
+/// recording stops. Only ticks while recording.
+/// </summary>
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class SKYLINESHREDDER_API UGhostRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UGhostRecorderComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	//Samples a second that are recorded
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Ghost")
+	int32 SampleRate = 30;
+
+	/// <summary>
+	/// Starts a new recording, throwing away any recording that wasn't saved
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Ghost")
+	void StartRecording();
+
+	/// <summary>
+	/// Stops recording and saves the ghost to Saved/Ghosts
+	/// </summary>
+	/// <param name="GhostName">the name to save the ghost as</param>
+	/// <returns>the path the ghost is saved to, empty if nothing was recorded</returns>
+	UFUNCTION(BlueprintCallable, Category = "Ghost")
+	FString StopRecording(const FString& GhostName);
+
+	UFUNCTION(BlueprintCallable, Category = "Ghost")
+	bool IsRecording() const { return Encoder.IsValid(); }
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	TUniquePtr<FGhostEncoder> Encoder;
+
+	//Time since the last sample
+	float SampleAccumulator = 0.0f;
+
+	void RecordFrame();
+};
@@ -0,0 +1,304 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GhostRecording.h"
+#include "SkylineShredder.h"
+#include "Async/Async.h"
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace GhostStream
+{
+	//Set on frames that carry a new hook location, stored in the top bit of the flags
+	static constexpr uint8 FLAG_HookChanged = 1 << 7;
+
+	//Chunks bigger than this can only come from a corrupt file
+	static constexpr uint32 MaxChunkSize = 1024 * 1024;
+
+	//Small differences of either sign become small unsigned numbers, which pack into one or two bytes
+	static void WritePacked(FArchive& Ar, int32 Value)
+	{
+		uint32 ZigZag = (uint32)((Value << 1) ^ (Value >> 31));
+		Ar.SerializeIntPacked(ZigZag);
+	}
+
+	static int32 ReadPacked(FArchive& Ar)
+	{
+		uint32 ZigZag = 0;
+		Ar.SerializeIntPacked(ZigZag);
+		return (int32)(ZigZag >> 1) ^ -(int32)(ZigZag & 1);
+	}
+
+	static void WritePacked(FArchive& Ar, const FIntVector& Value)
+	{
+		WritePacked(Ar, Value.X);
+		WritePacked(Ar, Value.Y);
+		WritePacked(Ar, Value.Z);
+	}
+
+	static FIntVector ReadPackedVector(FArchive& Ar)
+	{
+		FIntVector Value;
+		Value.X = ReadPacked(Ar);
+		Value.Y = ReadPacked(Ar);
+		Value.Z = ReadPacked(Ar);
+		return Value;
+	}
+
+	static FIntVector QuantizeVector(const FVector& Vector)
+	{
+		return FIntVector(FMath::RoundToInt(Vector.X), FMath::RoundToInt(Vector.Y), FMath::RoundToInt(Vector.Z));
+	}
+
+	//Where the location would be if it kept moving the way it did over the last two frames
+	static FIntVector PredictLocation(const FGhostQuantizedFrame& Previous, const FGhostQuantizedFrame& BeforePrevious, int32 FrameInChunk)
+	{
+		if (FrameInChunk < 2)
+			return Previous.Location;
+
+		return Previous.Location + (Previous.Location - BeforePrevious.Location);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FGhostQuantizedFrame
+
+FGhostQuantizedFrame FGhostQuantizedFrame::Quantize(const FGhostFrame& Frame)
+{
+	FGhostQuantizedFrame Quantized;
+	Quantized.Location = GhostStream::QuantizeVector(Frame.Location);
+	Quantized.Velocity = GhostStream::QuantizeVector(Frame.Velocity);
+	Quantized.Yaw = FRotator::CompressAxisToShort(Frame.Yaw);
+	Quantized.Flags = Frame.Flags & ~GhostStream::FLAG_HookChanged;
+	Quantized.Hook = Frame.HasFlag(FGhostFrame::FLAG_GrappleAttached) ? GhostStream::QuantizeVector(Frame.HookLocation) : FIntVector::ZeroValue;
+	return Quantized;
+}
+
+FGhostFrame FGhostQuantizedFrame::Dequantize() const
+{
+	FGhostFrame Frame;
+	Frame.Location = FVector(Location);
+	Frame.Velocity = FVector(Velocity);
+	Frame.Yaw = FRotator::DecompressAxisFromShort(Yaw);
+	Frame.Flags = Flags;
+	Frame.HookLocation = FVector(Hook);
+	return Frame;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FGhostEncoder
+
+FGhostEncoder::FGhostEncoder(int32 InFramesPerChunk)
+	: FramesPerChunk(FMath::Max(InFramesPerChunk, 1))
+{
+}
+
+void FGhostEncoder::AddFrame(const FGhostFrame& Frame)
+{
+	using namespace GhostStream;
+
+	const FGhostQuantizedFrame Quantized = FGhostQuantizedFrame::Quantize(Frame);
+	const bool bKeyFrame = FramesInChunk == 0;
+	const bool bHookChanged = (Quantized.Flags & FGhostFrame::FLAG_GrappleAttached) && (bKeyFrame || Quantized.Hook != Previous.Hook);
+
+	FMemoryWriter Writer(Chunk, false, true);
+
+	uint8 Flags = Quantized.Flags | (bHookChanged ? FLAG_HookChanged : 0);
+	Writer << Flags;
+
+	//The first frame of a chunk is stored whole, the rest as differences
+	if (bKeyFrame)
+	{
+		WritePacked(Writer, Quantized.Location);
+		WritePacked(Writer, Quantized.Velocity);
+		uint16 Yaw = Quantized.Yaw;
+		Writer << Yaw;
+	}
+	else
+	{
+		WritePacked(Writer, Quantized.Location - PredictLocation(Previous, BeforePrevious, FramesInChunk));
+		WritePacked(Writer, Quantized.Velocity - Previous.Velocity);
+		WritePacked(Writer, (int32)(int16)(Quantized.Yaw - Previous.Yaw));
+	}
+
+	if (bHookChanged)
+		WritePacked(Writer, Quantized.Hook);
+
+	BeforePrevious = Previous;
+	Previous = Quantized;
+	FramesInChunk++;
+	NumFrames++;
+
+	if (FramesInChunk >= FramesPerChunk)
+		CloseChunk();
+}
+
+void FGhostEncoder::Finish()
+{
+	if (FramesInChunk > 0)
+		CloseChunk();
+}
+
+void FGhostEncoder::CloseChunk()
+{
+	//Each chunk is its size, then the number of frames in it, then the frames
+	TArray<uint8> Payload;
+	FMemoryWriter Writer(Payload);
+	uint32 Frames = FramesInChunk;
+	Writer.SerializeIntPacked(Frames);
+	Payload.Append(Chunk);
+
+	FMemoryWriter DataWriter(Data, false, true);
+	uint32 Size = Payload.Num();
+	DataWriter << Size;
+	Data.Append(Payload);
+
+	Chunk.Reset();
+	FramesInChunk = 0;
+	NumChunks++;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FGhostDecoder
+
+bool FGhostDecoder::DecodeChunk(const TArray<uint8>& ChunkData, TArray<FGhostFrame>& OutFrames)
+{
+	using namespace GhostStream;
+
+	FMemoryReader Reader(ChunkData);
+	uint32 NumFrames = 0;
+	Reader.SerializeIntPacked(NumFrames);
+
+	//Every frame is at least a byte, so more frames than bytes means the chunk is corrupt
+	if (Reader.IsError() || NumFrames > (uint32)ChunkData.Num())
+		return false;
+
+	FGhostQuantizedFrame Previous;
+	FGhostQuantizedFrame BeforePrevious;
+	OutFrames.Reserve(OutFrames.Num() + NumFrames);
+
+	for (uint32 Index = 0; Index < NumFrames; Index++)
+	{
+		FGhostQuantizedFrame Frame;
+		uint8 Flags = 0;
+		Reader << Flags;
+		Frame.Flags = Flags & ~FLAG_HookChanged;
+
+		if (Index == 0)
+		{
+			Frame.Location = ReadPackedVector(Reader);
+			Frame.Velocity = ReadPackedVector(Reader);
+			Reader << Frame.Yaw;
+		}
+		else
+		{
+			Frame.Location = PredictLocation(Previous, BeforePrevious, Index) + ReadPackedVector(Reader);
+			Frame.Velocity = Previous.Velocity + ReadPackedVector(Reader);
+			Frame.Yaw = (uint16)(Previous.Yaw + ReadPacked(Reader));
+		}
+
+		//The hook only comes with the frames it changed on
+		if (Flags & FLAG_HookChanged)
+			Frame.Hook = ReadPackedVector(Reader);
+		else if (Frame.Flags & FGhostFrame::FLAG_GrappleAttached)
+			Frame.Hook = Previous.Hook;
+
+		if (Reader.IsError())
+			return false;
+
+		OutFrames.Add(Frame.Dequantize());
+		BeforePrevious = Previous;
+		Previous = Frame;
+	}
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FGhostFile
+
+FGhostFile::FGhostFile() = default;
+FGhostFile::~FGhostFile() = default;
+
+FString FGhostFile::GetGhostDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Ghosts");
+}
+
+FString FGhostFile::GetGhostPath(const FString& GhostName)
+{
+	return GetGhostDirectory() / (FPaths::MakeValidFileName(GhostName) + TEXT(".ghost"));
+}
+
+void FGhostFile::SaveAsync(const FString& Path, uint16 SampleRate, const FGhostEncoder& Encoder)
+{
+	TArray<uint8> Bytes;
+	Bytes.Reserve(FGhostFileHeader::Size + Encoder.GetData().Num());
+
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = FGhostFileHeader::Magic;
+	FGhostFileHeader Header;
+	Header.SampleRate = SampleRate;
+	Header.NumFrames = Encoder.GetNumFrames();
+	Header.NumChunks = Encoder.GetNumChunks();
+	Writer << Magic << Header.Version << Header.SampleRate << Header.NumFrames << Header.NumChunks;
+	Bytes.Append(Encoder.GetData());
+
+	Async(EAsyncExecution::ThreadPool, [Path, Bytes = MoveTemp(Bytes)]()
+	{
+		if (!FFileHelper::SaveArrayToFile(Bytes, *Path))
+			UE_LOG(LogSkylineShredder, Warning, TEXT("Couldn't save ghost %s"), *Path);
+	});
+}
+
+bool FGhostFile::Open(const FString& Path)
+{
+	File.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenRead(*Path));
+	ChunksRead = 0;
+	if (!File)
+		return false;
+
+	uint8 Bytes[FGhostFileHeader::Size];
+	if (!File->Read(Bytes, FGhostFileHeader::Size))
+		return false;
+
+	TArray<uint8> HeaderBytes(Bytes, FGhostFileHeader::Size);
+	FMemoryReader Reader(HeaderBytes);
+	uint32 Magic = 0;
+	Reader << Magic << Header.Version << Header.SampleRate << Header.NumFrames << Header.NumChunks;
+
+	if (Magic != FGhostFileHeader::Magic || Header.Version != FGhostFileHeader::CurrentVersion || Header.SampleRate == 0)
+	{
+		UE_LOG(LogSkylineShredder, Warning, TEXT("%s isn't a ghost this version can play"), *Path);
+		File.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool FGhostFile::ReadNextChunk(TArray<FGhostFrame>& OutFrames)
+{
+	if (!File || ChunksRead >= Header.NumChunks)
+		return false;
+
+	uint32 Size = 0;
+	if (!File->Read(reinterpret_cast<uint8*>(&Size), sizeof(Size)))
+		return false;
+
+	//The file is written little endian
+	Size = INTEL_ORDER32(Size);
+	if (Size == 0 || Size > GhostStream::MaxChunkSize)
+		return false;
+
+	ChunkBuffer.SetNumUninitialized(Size, false);
+	if (!File->Read(ChunkBuffer.GetData(), Size))
+		return false;
+
+	ChunksRead++;
+	return FGhostDecoder::DecodeChunk(ChunkBuffer, OutFrames);
+}
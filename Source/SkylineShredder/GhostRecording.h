@@ -0,0 +1,147 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class IFileHandle;
+
+//One sample of a recorded run
+struct SKYLINESHREDDER_API FGhostFrame
+{
+	enum : uint8
+	{
+		FLAG_WallRunning = 1 << 0,
+		FLAG_Vaulting = 1 << 1,
+		FLAG_Climbing = 1 << 2,
+		FLAG_GrappleAttached = 1 << 3
+	};
+
+	FVector Location = FVector::ZeroVector;
+	FVector Velocity = FVector::ZeroVector;
+	float Yaw = 0.0f;
+	uint8 Flags = 0;
+	FVector HookLocation = FVector::ZeroVector;
+
+	bool HasFlag(uint8 Flag) const { return (Flags & Flag) != 0; }
+};
+
+//A ghost frame as it is stored, in centimeters, centimeters per second and 1/65536ths of a turn
+struct SKYLINESHREDDER_API FGhostQuantizedFrame
+{
+	FIntVector Location = FIntVector::ZeroValue;
+	FIntVector Velocity = FIntVector::ZeroValue;
+	uint16 Yaw = 0;
+	uint8 Flags = 0;
+	FIntVector Hook = FIntVector::ZeroValue;
+
+	static FGhostQuantizedFrame Quantize(const FGhostFrame& Frame);
+	FGhostFrame Dequantize() const;
+};
+
+/// <summary>
+/// Encodes ghost frames into the compact ghost stream. Locations and velocities are quantized to
+/// centimeters, yaw to 16 bits, and written as zigzag packed differences from the frames before,
+/// so a runner moving smoothly takes a few bytes a frame. The stream is split into chunks of about a
+/// second that each start with a full frame, so playback can read and decode them one at a time.
+/// </summary>
+class SKYLINESHREDDER_API FGhostEncoder
+{
+public:
+	explicit FGhostEncoder(int32 InFramesPerChunk);
+
+	void AddFrame(const FGhostFrame& Frame);
+
+	//Closes the last chunk, call before saving
+	void Finish();
+
+	const TArray<uint8>& GetData() const { return Data; }
+	int32 GetNumFrames() const { return NumFrames; }
+	int32 GetNumChunks() const { return NumChunks; }
+
+private:
+	int32 FramesPerChunk;
+	int32 NumFrames = 0;
+	int32 NumChunks = 0;
+
+	//Finished chunks, each with its size in front, and the chunk being written
+	TArray<uint8> Data;
+	TArray<uint8> Chunk;
+	int32 FramesInChunk = 0;
+
+	FGhostQuantizedFrame Previous;
+	FGhostQuantizedFrame BeforePrevious;
+
+	void CloseChunk();
+};
+
+//Decodes the chunks written by FGhostEncoder
+class SKYLINESHREDDER_API FGhostDecoder
+{
+public:
+	/// <summary>
+	/// Decodes a chunk and adds its frames to the end of an array
+	/// </summary>
+	/// <returns>false if the chunk is corrupt</returns>
+	static bool DecodeChunk(const TArray<uint8>& ChunkData, TArray<FGhostFrame>& OutFrames);
+};
+
+//The ghost file is this header followed by the encoder's chunks
+struct SKYLINESHREDDER_API FGhostFileHeader
+{
+	static constexpr uint32 Magic = 0x54534847; // "GHST"
+	static constexpr uint16 CurrentVersion = 1;
+
+	uint16 Version = CurrentVersion;
+	uint16 SampleRate = 30;
+	uint32 NumFrames = 0;
+	uint32 NumChunks = 0;
+
+	float GetDuration() const { return SampleRate > 0 ? (float)NumFrames / SampleRate : 0.0f; }
+
+	static constexpr int64 Size = 16;
+};
+
+/// <summary>
+/// Ghost file reading and writing. Saving is done on a worker thread, and files are read a chunk at a
+/// time so playing a ghost only ever keeps a couple of seconds of it in memory.
+/// </summary>
+class SKYLINESHREDDER_API FGhostFile
+{
+public:
+	//The folder ghosts are saved in, Saved/Ghosts
+	static FString GetGhostDirectory();
+
+	//The path of a ghost saved with a name
+	static FString GetGhostPath(const FString& GhostName);
+
+	/// <summary>
+	/// Writes a finished recording to disk on a worker thread
+	/// </summary>
+	static void SaveAsync(const FString& Path, uint16 SampleRate, const FGhostEncoder& Encoder);
+
+	/// <summary>
+	/// Opens a ghost file and reads its header
+	/// </summary>
+	/// <returns>false if the file is missing or isn't a ghost</returns>
+	bool Open(const FString& Path);
+
+	/// <summary>
+	/// Reads the next chunk and decodes its frames onto the end of an array
+	/// </summary>
+	/// <returns>false at the end of the file or if the chunk is corrupt</returns>
+	bool ReadNextChunk(TArray<FGhostFrame>& OutFrames);
+
+	const FGhostFileHeader& GetHeader() const { return Header; }
+
+	bool IsAtEnd() const { return ChunksRead >= Header.NumChunks; }
+
+	FGhostFile();
+	~FGhostFile();
+
+private:
+	TUniquePtr<IFileHandle> File;
+	FGhostFileHeader Header;
+	uint32 ChunksRead = 0;
+	TArray<uint8> ChunkBuffer;
+};
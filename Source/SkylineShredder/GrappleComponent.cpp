@@ -2,57 +2,213 @@
 
 
 #include "GrappleComponent.h"
+#include "SkylineShredder.h"
 #include "SkylineShredderCharacter.h"
-#include "Camera/CameraComponent.h"
-#include <Components/SphereComponent.h>
-#include <GameFramework/SpringArmComponent.h>
-#include <Kismet/KismetSystemLibrary.h>
+#include "SkylineMovementComponent.h"
+#include "MovementModifierComponent.h"
+#include "GrapplePointSubsystem.h"
+#include "GrappleTargetingComponent.h"
+#include "ParkourTelemetry.h"
+#include "GameFramework/Controller.h"
 
 // Sets default values for this component's properties
 UGrappleComponent::UGrappleComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
+	//Only ticks while hooked, turned on by attaching and off by letting go
 	PrimaryComponentTick.bCanEverTick = true;
-
-	HandPointCollider = CreateDefaultSubobject<USphereComponent>(TEXT("HandPointCollider"));
-	UPROPERTY(EditAnywhere, BlueprintCallable, Category = "Grapple")
-	HandPointCollider->SetSphereRadius(10.0f);
-	UPROPERTY(EditAnywhere)
-	HandPointCollider->SetRelativeLocation(FVector(0.0f, 40.0f, 0.0f));
-	
-
-	
-
-	// ...
+	PrimaryComponentTick.bStartWithTickEnabled = false;
 }
 
-
 // Called when the game starts
 void UGrappleComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
-	
+	Character = Cast<ACharacter>(GetOwner());
+	if (!Character)
+		return;
+
+	SkylineMovement = Cast<USkylineMovementComponent>(Character->GetCharacterMovement());
+	MovementModifiers = Character->FindComponentByClass<UMovementModifierComponent>();
+	Targeting = Character->FindComponentByClass<UGrappleTargetingComponent>();
+	Character->LandedDelegate.AddDynamic(this, &UGrappleComponent::HandleOwnerLanded);
 }
 
-// Called every frame
 void UGrappleComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
 {
 	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
 
-	// ...
+	//The boost can be used again once it has cooled down
+	if (bHasAppliedBoost && GetWorld()->TimeSeconds - LastBoostTime > BoostCooldownTime)
+		bHasAppliedBoost = false;
 }
 
+//Checks to see if the runner is able to do a grapple and hooks onto the grapple point it is aiming at, called when grapple is pressed
 void UGrappleComponent::CheckForGrapple()
 {
-	
-	
-	
-	
-	
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourCheckForGrapple);
+
+	if (!SkylineMovement)
+		return;
+
+	//If already in action return
+	const ASkylineShredderCharacter* Runner = Cast<ASkylineShredderCharacter>(Character);
+	if (Runner && Runner->IsInAction())
+		return;
+
+	//Only hooks while in the air and not already hooked, pressing it otherwise lets go without the push
+	if (!SkylineMovement->IsMovingOnGround() && !bHookAttached)
+	{
+		FVector NewHookLocation;
+		AActor* HitActor = nullptr;
+		if (FindHook(NewHookLocation, HitActor))
+		{
+			PARKOUR_COUNTER_ADD(ParkourGrappleAttaches, 1);
+			Attach(NewHookLocation, HitActor);
+		}
+	}
+	else
+	{
+		Release();
+		SkylineMovement->StopGrappleSwing();
+	}
+}
+
+//Lets go of the grapple and pushes the runner forward, called when grapple is released
+void UGrappleComponent::EndGrapple()
+{
+	if (!bHookAttached || !SkylineMovement)
+		return;
+
+	Release();
+	SkylineMovement->StopGrappleSwing();
+
+	if (ASkylineShredderCharacter* Runner = Cast<ASkylineShredderCharacter>(Character))
+		Runner->SetMomentum(Runner->GetMomentum() + ReleaseMomentum);
+
+	const FVector Force = Character->GetActorForwardVector() * ReleaseImpulse;
+	AddImpulse(FVector(Force.X, Force.Y, ReleaseLift));
+}
+
+//Gives the runner a push forward once per grapple, called when boost is pressed during the grapple
+void UGrappleComponent::GrappleBoost()
+{
+	if (!bHookAttached || bHasAppliedBoost || !SkylineMovement || SkylineMovement->IsMovingOnGround())
+		return;
+
+	const FVector Force = Character->GetActorForwardVector() * BoostImpulse;
+	AddImpulse(FVector(Force.X, Force.Y, 0.0f));
+	bHasAppliedBoost = true;
+	LastBoostTime = GetWorld()->TimeSeconds;
+}
+
+void UGrappleComponent::ApplyNetworkGrapple(bool bAttached, const FVector& InHookLocation)
+{
+	if (!bAttached)
+	{
+		EndGrapple();
+		return;
+	}
+
+	const ASkylineShredderCharacter* Runner = Cast<ASkylineShredderCharacter>(Character);
+	if (!SkylineMovement || (Runner && Runner->IsInAction()))
+		return;
+
+	//The furthest a grapple point can be hooked from is the aim length plus the aim radius, with or without targeting
+	float Reach = Range + AimRadius;
+	if (Targeting)
+		Reach = FMath::Max(Reach, Targeting->Range + Targeting->AimRadius);
+
+	if (FVector::DistSquared(InHookLocation, Character->GetActorLocation()) > FMath::Square(Reach))
+		return;
+
+	//The hook has to be on a grapple point, the server corrects the client otherwise
+	const UGrapplePointSubsystem* GrapplePoints = GetWorld()->GetSubsystem<UGrapplePointSubsystem>();
+	AActor* HitActor = nullptr;
+	if (!GrapplePoints || !GrapplePoints->FindGrapplePointAt(InHookLocation, NetworkHookTolerance, HitActor))
+		return;
+
+	PARKOUR_COUNTER_ADD(ParkourGrappleAttaches, 1);
+	Attach(InHookLocation, HitActor);
+}
+
+void UGrappleComponent::CorrectGrapple(bool bAttached, const FVector& InHookLocation, float RopeMaxLength)
+{
+	if (!bAttached)
+	{
+		Release();
+		return;
+	}
+
+	bHookAttached = true;
+	HookLocation = InHookLocation;
+	SetComponentTickEnabled(true);
+
+	if (SkylineMovement)
+		SkylineMovement->SetGrappleHookLocation(InHookLocation, RopeMaxLength);
+}
+
+void UGrappleComponent::SetReplicatedGrapple(bool bAttached, const FVector& InHookLocation)
+{
+	bHookAttached = bAttached;
+	HookLocation = InHookLocation;
+}
+
+bool UGrappleComponent::FindHook(FVector& OutHookLocation, AActor*& OutActor) const
+{
+	const FVector Start = Character->GetActorLocation();
+
+	//The best grapple point in sight is kept up to date in the background, so there is nothing to look for here
+	if (Targeting && Targeting->HasScored())
+		return Targeting->GetTarget(Start, OutHookLocation, OutActor);
+
+	//Otherwise find the first grapple point a sphere swept along where the controller is looking would touch,
+	//the camera for players and the eyes for AI. The grapple points are kept in a grid so this doesn't need a physics sweep
+	FVector ViewLocation;
+	FRotator ViewRotation = Character->GetActorRotation();
+	if (const AController* Controller = Character->GetController())
+		Controller->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	const UGrapplePointSubsystem* GrapplePoints = GetWorld()->GetSubsystem<UGrapplePointSubsystem>();
+	return GrapplePoints && GrapplePoints->FindGrapplePoint(Start, ViewRotation.Vector(), Range, AimRadius, OutHookLocation, OutActor);
+}
+
+void UGrappleComponent::Attach(const FVector& InHookLocation, AActor* HitActor)
+{
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourDoGrapple);
 
+	bHookAttached = true;
+	HookLocation = InHookLocation;
+	HookHitActor = HitActor;
+	SetComponentTickEnabled(true);
 
+	if (ASkylineShredderCharacter* Runner = Cast<ASkylineShredderCharacter>(Character))
+		Runner->AddTelemetryEvent(FParkourTelemetrySample::EVENT_GrappleAttach);
+
+	//The swing itself is simulated by the grapple swing movement mode on a rope as long as the distance
+	//to the hook, which can be reeled out to the hook length, and lands the runner when they touch the ground
+	if (!SkylineMovement->IsGrappleSwinging())
+		SkylineMovement->StartGrappleSwing(HookLocation, HookLength);
 }
 
+void UGrappleComponent::Release()
+{
+	bHookAttached = false;
+	bHasAppliedBoost = false;
+	HookHitActor = nullptr;
+	SetComponentTickEnabled(false);
+}
+
+void UGrappleComponent::AddImpulse(const FVector& Impulse)
+{
+	if (MovementModifiers)
+		MovementModifiers->AddImpulse(Impulse);
+	else
+		Character->GetCharacterMovement()->AddImpulse(Impulse);
+}
+
+void UGrappleComponent::HandleOwnerLanded(const FHitResult& Hit)
+{
+	if (bHookAttached)
+		EndGrapple();
+}
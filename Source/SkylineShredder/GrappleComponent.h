@@ -6,39 +6,145 @@
 #include "Components/ActorComponent.h"
 #include "GrappleComponent.generated.h"
 
+/// <summary>
+/// The grapple of a runner, the player or an AI. Hooks onto the grapple point the grapple targeting picked,
+/// or the first one along where the controller is looking if the runner has no targeting, swings from it in the
+/// grapple swing movement mode and lets go with a push forward. The component only ticks while hooked, so
+/// runners that aren't grappling cost nothing for it each frame.
+/// </summary>
 UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent), Blueprintable)
 class SKYLINESHREDDER_API UGrappleComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
 public:
-	
-
-public:	
 	// Sets default values for this component's properties
 	UGrappleComponent();
 
-	UPROPERTY()
-	class USphereComponent* HandPointCollider;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	//How far along the aim a grapple point can be hooked, and how far either side of it, when there is no grapple targeting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float Range = 6000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float AimRadius = 2500.0f;
+
+	//The longest the rope can be reeled out to
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float HookLength = 3000.0f;
+
+	//Seconds after boosting before the boost can be used again
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float BoostCooldownTime = 2.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float BoostImpulse = 150000.0f;
+
+	//The push forward and up when letting go, and the momentum it gives a Skyline runner
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float ReleaseImpulse = 200000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float ReleaseLift = 450.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float ReleaseMomentum = 300.0f;
+
+	//How far off a grapple point the hook a client sent can be, for the quantization of the hook location
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float NetworkHookTolerance = 10.0f;
+
+	/// <summary>
+	/// Hooks onto a grapple point if the runner is in the air and not already hooked, or lets go if it is
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	void CheckForGrapple();
+
+	/// <summary>
+	/// Lets go of the grapple with a push forward
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	void EndGrapple();
+
+	/// <summary>
+	/// Pushes the runner forward, once per grapple or cooldown
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	void GrappleBoost();
+
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	bool IsHookAttached() const { return bHookAttached; }
+
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	FVector GetHookLocation() const { return HookLocation; }
+
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	bool HasAppliedBoost() const { return bHasAppliedBoost; }
 
-	
+	/// <summary>
+	/// Attaches or lets go of the grapple on the server to match the owning client. The client picks the
+	/// grapple point, so the server checks it is in reach and on a registered grapple point
+	/// </summary>
+	/// <param name="bAttached">if the client has the grapple attached</param>
+	/// <param name="InHookLocation">where the client hooked onto</param>
+	void ApplyNetworkGrapple(bool bAttached, const FVector& InHookLocation);
+
+	/// <summary>
+	/// Sets the grapple to what the server corrected it to. The movement mode comes with the correction,
+	/// so only the grapple state, hook and rope length are set, without the impulses of attaching or letting go
+	/// </summary>
+	void CorrectGrapple(bool bAttached, const FVector& InHookLocation, float RopeMaxLength);
+
+	/// <summary>
+	/// Shows the grapple the server sent for another player, nothing is simulated for it
+	/// </summary>
+	void SetReplicatedGrapple(bool bAttached, const FVector& InHookLocation);
 
 protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+private:
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Grapple", meta = (AllowPrivateAccess = "true"))
+	bool bHookAttached = false;
 
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Grapple", meta = (AllowPrivateAccess = "true"))
+	FVector HookLocation = FVector::ZeroVector;
 
-	virtual void CheckForGrapple();
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Grapple", meta = (AllowPrivateAccess = "true"))
+	AActor* HookHitActor = nullptr;
 
-	
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Grapple", meta = (AllowPrivateAccess = "true"))
+	bool bHasAppliedBoost = false;
 
-	
-	
-private:
-	
-		
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, Category = "Grapple", meta = (AllowPrivateAccess = "true"))
+	float LastBoostTime = 0.0f;
+
+	UPROPERTY()
+	class ACharacter* Character;
+
+	UPROPERTY()
+	class USkylineMovementComponent* SkylineMovement;
+
+	UPROPERTY()
+	class UMovementModifierComponent* MovementModifiers;
+
+	UPROPERTY()
+	class UGrappleTargetingComponent* Targeting;
+
+	//Finds the grapple point to hook onto
+	bool FindHook(FVector& OutHookLocation, AActor*& OutActor) const;
+
+	//Sets the hook and swings from it in the grapple swing movement mode
+	void Attach(const FVector& InHookLocation, AActor* HitActor);
+
+	//Clears the hook and stops ticking
+	void Release();
+
+	void AddImpulse(const FVector& Impulse);
+
+	//Landing while swinging lets go of the grapple
+	UFUNCTION()
+	void HandleOwnerLanded(const FHitResult& Hit);
 };
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+//Compares the grapple point grid against the sphere sweep the character used to run.
+//Run "Parkour.GrappleBenchmark [NumQueries]" from the console while playing a level.
+
+#include "SkylineShredder.h"
+#include "GrapplePointSubsystem.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "TimerManager.h"
+
+namespace GrapplePointBenchmark
+{
+	//The same sweep the character used for grappling
+	static const float SweepLength = 6000.0f;
+	static const float SweepRadius = 2500.0f;
+
+	//The size of the box the grapple points are scattered in
+	static const float Extent = 40000.0f;
+
+	static const int32 PointCounts[] = { 100, 1000, 10000 };
+
+	struct FQuery
+	{
+		FVector Start;
+		FVector Direction;
+	};
+
+	static void RunStep(TWeakObjectPtr<UWorld> WeakWorld, int32 Step, int32 NumQueries, TArray<AActor*> Points);
+
+	/// <summary>
+	/// Spawns the grapple points for a step, then measures them on the next frame once physics has picked them up
+	/// </summary>
+	static void SpawnStep(TWeakObjectPtr<UWorld> WeakWorld, int32 Step, int32 NumQueries)
+	{
+		UWorld* World = WeakWorld.Get();
+		if (!World || Step >= UE_ARRAY_COUNT(PointCounts))
+			return;
+
+		UGrapplePointSubsystem* Subsystem = World->GetSubsystem<UGrapplePointSubsystem>();
+		FRandomStream Random(Step);
+
+		TArray<AActor*> Points;
+		for (int32 i = 0; i < PointCounts[Step]; i++)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			AActor* Point = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+
+			//Give the point a small sphere on the GrapplePoint channel, like the grapple point blueprints
+			USphereComponent* Sphere = NewObject<USphereComponent>(Point);
+			Sphere->InitSphereRadius(50.0f);
+			Sphere->SetCollisionObjectType(ECC_GameTraceChannel2);
+			Sphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+			Point->SetRootComponent(Sphere);
+			Sphere->RegisterComponent();
+			Sphere->SetWorldLocation(FVector(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), Random.FRandRange(0.0f, 10000.0f)));
+
+			Subsystem->RegisterGrapplePoint(Point);
+			Points.Add(Point);
+		}
+
+		World->GetTimerManager().SetTimerForNextTick([WeakWorld, Step, NumQueries, Points]()
+		{
+			RunStep(WeakWorld, Step, NumQueries, Points);
+		});
+	}
+
+	/// <summary>
+	/// Times the sweep and the grid on the same queries, then moves on to the next point count
+	/// </summary>
+	static void RunStep(TWeakObjectPtr<UWorld> WeakWorld, int32 Step, int32 NumQueries, TArray<AActor*> Points)
+	{
+		UWorld* World = WeakWorld.Get();
+		if (!World)
+			return;
+
+		UGrapplePointSubsystem* Subsystem = World->GetSubsystem<UGrapplePointSubsystem>();
+		FRandomStream Random(Step + 100);
+
+		TArray<FQuery> Queries;
+		for (int32 i = 0; i < NumQueries; i++)
+			Queries.Add({ FVector(Random.FRandRange(-Extent, Extent), Random.FRandRange(-Extent, Extent), Random.FRandRange(0.0f, 10000.0f)), Random.GetUnitVector() });
+
+		TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesArray;
+		ObjectTypesArray.Add(UEngineTypes::ConvertToObjectType(ECollisionChannel::ECC_GameTraceChannel2));
+		TArray<AActor*> ActorsToIgnore;
+
+		//Time the sphere sweep
+		TArray<AActor*> SweepActors;
+		SweepActors.SetNum(NumQueries);
+		double StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumQueries; i++)
+		{
+			FHitResult HitResult;
+			UKismetSystemLibrary::SphereTraceSingleForObjects(World, Queries[i].Start, Queries[i].Start + Queries[i].Direction * SweepLength, SweepRadius,
+				ObjectTypesArray, false, ActorsToIgnore, EDrawDebugTrace::None, HitResult, true);
+			SweepActors[i] = HitResult.GetActor();
+		}
+		const double SweepTime = FPlatformTime::Seconds() - StartTime;
+
+		//Time the grid
+		TArray<AActor*> GridActors;
+		GridActors.SetNum(NumQueries);
+		StartTime = FPlatformTime::Seconds();
+		for (int32 i = 0; i < NumQueries; i++)
+		{
+			FVector ImpactPoint;
+			Subsystem->FindGrapplePoint(Queries[i].Start, Queries[i].Direction, SweepLength, SweepRadius, ImpactPoint, GridActors[i]);
+		}
+		const double GridTime = FPlatformTime::Seconds() - StartTime;
+
+		int32 NumAgree = 0;
+		for (int32 i = 0; i < NumQueries; i++)
+		{
+			if (SweepActors[i] == GridActors[i])
+				NumAgree++;
+		}
+
+		UE_LOG(LogSkylineShredder, Display, TEXT("Grapple benchmark: %5d points, sweep %8.2f us/query, grid %8.2f us/query, %d/%d queries picked the same point"),
+			PointCounts[Step], SweepTime * 1000000.0 / NumQueries, GridTime * 1000000.0 / NumQueries, NumAgree, NumQueries);
+
+		for (AActor* Point : Points)
+		{
+			if (IsValid(Point))
+				Point->Destroy();
+		}
+
+		World->GetTimerManager().SetTimerForNextTick([WeakWorld, Step, NumQueries]()
+		{
+			SpawnStep(WeakWorld, Step + 1, NumQueries);
+		});
+	}
+
+	static void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || !World->IsGameWorld())
+			return;
+
+		const int32 NumQueries = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000;
+		SpawnStep(World, 0, NumQueries);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GrappleBenchmarkCommand(
+	TEXT("Parkour.GrappleBenchmark"),
+	TEXT("Compares the grapple point grid against the grapple sphere sweep at 100, 1000 and 10000 points. Usage: Parkour.GrappleBenchmark [NumQueries]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&GrapplePointBenchmark::Run));
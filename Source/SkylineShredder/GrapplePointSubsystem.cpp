@@ -0,0 +1,337 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GrapplePointSubsystem.h"
+#include "SkylineShredder.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+
+void UGrapplePointSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	//Listen for levels streaming in and out so their grapple points are picked up
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UGrapplePointSubsystem::HandleLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UGrapplePointSubsystem::HandleLevelRemoved);
+}
+
+void UGrapplePointSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	if (UWorld* World = GetWorld())
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	Points.Empty();
+	PointActors.Empty();
+	PointKeys.Empty();
+	Cells.Empty();
+	ActorToPoint.Empty();
+
+	Super::Deinitialize();
+}
+
+void UGrapplePointSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//Register every grapple point that was placed in the level
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+	{
+		if (IsGrapplePointActor(*It))
+			RegisterGrapplePoint(*It);
+	}
+
+	//Register grapple points spawned at runtime
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UGrapplePointSubsystem::HandleActorSpawned));
+}
+
+bool UGrapplePointSubsystem::IsGrapplePointActor(const AActor* Actor)
+{
+	if (!Actor)
+		return false;
+
+	//A grapple point is any actor with a queryable primitive on the GrapplePoint object channel
+	for (const UActorComponent* Component : Actor->GetComponents())
+	{
+		const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+		if (Primitive && Primitive->GetCollisionObjectType() == ECC_GameTraceChannel2 && Primitive->IsQueryCollisionEnabled())
+			return true;
+	}
+
+	return false;
+}
+
+FIntVector UGrapplePointSubsystem::GetCell(const FVector& Location)
+{
+	return FIntVector(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize), FMath::FloorToInt(Location.Z / CellSize));
+}
+
+void UGrapplePointSubsystem::RegisterGrapplePoint(AActor* Actor)
+{
+	if (!Actor)
+		return;
+
+	//Use the bounds of the grapple point primitive, since that is what the sweep used to hit
+	FBoxSphereBounds Bounds(ForceInit);
+	bool bHasBounds = false;
+	for (const UActorComponent* Component : Actor->GetComponents())
+	{
+		const UPrimitiveComponent* Primitive = Cast<UPrimitiveComponent>(Component);
+		if (Primitive && Primitive->GetCollisionObjectType() == ECC_GameTraceChannel2)
+		{
+			Bounds = bHasBounds ? Bounds + Primitive->Bounds : Primitive->Bounds;
+			bHasBounds = true;
+		}
+	}
+
+	if (!bHasBounds)
+		return;
+
+	const FIntVector Cell = GetCell(Bounds.Origin);
+
+	//If the point is already registered just move it to its new cell
+	if (const int32* ExistingIndex = ActorToPoint.Find(Actor))
+	{
+		FGrapplePoint& Point = Points[*ExistingIndex];
+		if (Point.Cell != Cell)
+		{
+			TArray<int32>& OldCell = Cells.FindChecked(Point.Cell);
+			OldCell.RemoveSingleSwap(*ExistingIndex);
+			if (OldCell.Num() == 0)
+				Cells.Remove(Point.Cell);
+			Cells.FindOrAdd(Cell).Add(*ExistingIndex);
+		}
+		Point.Location = Bounds.Origin;
+		Point.Radius = Bounds.SphereRadius;
+		Point.Cell = Cell;
+		return;
+	}
+
+	const int32 Index = Points.Add({ Bounds.Origin, (float)Bounds.SphereRadius, Cell });
+	PointActors.Add(Actor);
+	PointKeys.Add(Actor);
+	ActorToPoint.Add(Actor, Index);
+	Cells.FindOrAdd(Cell).Add(Index);
+
+	Actor->OnEndPlay.AddUniqueDynamic(this, &UGrapplePointSubsystem::HandleActorEndPlay);
+
+	//A point that can move has to follow its actor into new cells, static and stationary points never leave theirs
+	USceneComponent* Root = Actor->GetRootComponent();
+	if (Root && Root->Mobility == EComponentMobility::Movable)
+		Root->TransformUpdated.AddUObject(this, &UGrapplePointSubsystem::HandleTransformUpdated);
+}
+
+void UGrapplePointSubsystem::UnregisterGrapplePoint(AActor* Actor)
+{
+	if (const int32* Index = ActorToPoint.Find(Actor))
+		RemovePointAt(*Index);
+}
+
+void UGrapplePointSubsystem::RemovePointAt(int32 Index)
+{
+	//Stop listening to the actor if it is still around, it may be in a level that is only being unloaded
+	if (AActor* Actor = PointActors[Index].Get())
+	{
+		Actor->OnEndPlay.RemoveDynamic(this, &UGrapplePointSubsystem::HandleActorEndPlay);
+		if (USceneComponent* Root = Actor->GetRootComponent())
+			Root->TransformUpdated.RemoveAll(this);
+	}
+
+	//Remove the point from its cell
+	TArray<int32>& Cell = Cells.FindChecked(Points[Index].Cell);
+	Cell.RemoveSingleSwap(Index);
+	if (Cell.Num() == 0)
+		Cells.Remove(Points[Index].Cell);
+
+	ActorToPoint.Remove(PointKeys[Index]);
+
+	//Move the last point into the freed slot so the arrays stay packed
+	const int32 LastIndex = Points.Num() - 1;
+	if (Index != LastIndex)
+	{
+		Points[Index] = Points[LastIndex];
+		PointActors[Index] = PointActors[LastIndex];
+		PointKeys[Index] = PointKeys[LastIndex];
+
+		TArray<int32>& MovedCell = Cells.FindChecked(Points[Index].Cell);
+		MovedCell.RemoveSingleSwap(LastIndex);
+		MovedCell.Add(Index);
+		ActorToPoint.Add(PointKeys[Index], Index);
+	}
+
+	Points.RemoveAt(LastIndex, 1, false);
+	PointActors.RemoveAt(LastIndex, 1, false);
+	PointKeys.RemoveAt(LastIndex, 1, false);
+}
+
+bool UGrapplePointSubsystem::FindGrapplePoint(const FVector& Start, const FVector& Direction, float Length, float Radius, FVector& OutImpactPoint, AActor*& OutActor) const
+{
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourFindGrapplePoint);
+
+	OutActor = nullptr;
+
+	const FVector End = Start + Direction * Length;
+	const FIntVector MinCell = GetCell(Start.ComponentMin(End) - FVector(Radius));
+	const FIntVector MaxCell = GetCell(Start.ComponentMax(End) + FVector(Radius));
+
+	float BestTime = TNumericLimits<float>::Max();
+	int32 BestIndex = INDEX_NONE;
+
+	//Walk every cell the swept sphere could touch
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				const TArray<int32>* Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (!Cell)
+					continue;
+
+				for (const int32 Index : *Cell)
+				{
+					const FGrapplePoint& Point = Points[Index];
+					const float ContactRadius = Radius + Point.Radius;
+
+					//Distance along and away from the sweep
+					const FVector ToPoint = Point.Location - Start;
+					const float Along = FVector::DotProduct(ToPoint, Direction);
+					const float DistanceSquared = ToPoint.SizeSquared();
+					const float AwaySquared = DistanceSquared - Along * Along;
+					if (AwaySquared > ContactRadius * ContactRadius)
+						continue;
+
+					//The time the sphere first touches the point, points already inside the sphere are hit immediately
+					float Time = Along - FMath::Sqrt(ContactRadius * ContactRadius - AwaySquared);
+					if (DistanceSquared <= ContactRadius * ContactRadius)
+						Time = 0.0f;
+					else if (Time < 0.0f || Time > Length)
+						continue;
+
+					if (Time < BestTime && PointActors[Index].IsValid())
+					{
+						BestTime = Time;
+						BestIndex = Index;
+					}
+				}
+			}
+		}
+	}
+
+	if (BestIndex == INDEX_NONE)
+		return false;
+
+	//The impact point is on the surface of the grapple point facing the sphere
+	const FGrapplePoint& Best = Points[BestIndex];
+	const FVector SphereCenter = Start + Direction * BestTime;
+	OutImpactPoint = Best.Location + (SphereCenter - Best.Location).GetSafeNormal() * Best.Radius;
+	OutActor = PointActors[BestIndex].Get();
+	return true;
+}
+
+bool UGrapplePointSubsystem::FindGrapplePointAt(const FVector& Location, float Tolerance, AActor*& OutActor) const
+{
+	OutActor = nullptr;
+
+	//Points are in the cell of their center, so look a cell around the location for hooks on the edge of a big point
+	const FIntVector MinCell = GetCell(Location - FVector(CellSize));
+	const FIntVector MaxCell = GetCell(Location + FVector(CellSize));
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				const TArray<int32>* Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (!Cell)
+					continue;
+
+				for (const int32 Index : *Cell)
+				{
+					const FGrapplePoint& Point = Points[Index];
+					if (FVector::DistSquared(Location, Point.Location) <= FMath::Square(Point.Radius + Tolerance) && PointActors[Index].IsValid())
+					{
+						OutActor = PointActors[Index].Get();
+						return true;
+					}
+				}
+			}
+		}
+	}
+
+	return false;
+}
+
+void UGrapplePointSubsystem::GatherGrapplePoints(const FVector& Center, float Range, TArray<FGrapplePointCandidate>& OutCandidates) const
+{
+	const FIntVector MinCell = GetCell(Center - FVector(Range));
+	const FIntVector MaxCell = GetCell(Center + FVector(Range));
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+			{
+				const TArray<int32>* Cell = Cells.Find(FIntVector(X, Y, Z));
+				if (!Cell)
+					continue;
+
+				for (const int32 Index : *Cell)
+					OutCandidates.Add({ Points[Index].Location, Points[Index].Radius, PointActors[Index] });
+			}
+		}
+	}
+}
+
+void UGrapplePointSubsystem::RegisterLevel(ULevel* Level)
+{
+	for (AActor* Actor : Level->Actors)
+	{
+		if (IsGrapplePointActor(Actor))
+			RegisterGrapplePoint(Actor);
+	}
+}
+
+void UGrapplePointSubsystem::HandleActorSpawned(AActor* Actor)
+{
+	if (IsGrapplePointActor(Actor))
+		RegisterGrapplePoint(Actor);
+}
+
+void UGrapplePointSubsystem::HandleTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateFlags, ETeleportType Teleport)
+{
+	//Registering again moves the point to the cell it is in now
+	if (Component)
+		RegisterGrapplePoint(Component->GetOwner());
+}
+
+void UGrapplePointSubsystem::HandleLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (Level && World == GetWorld())
+		RegisterLevel(Level);
+}
+
+void UGrapplePointSubsystem::HandleLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld())
+		return;
+
+	//Drop every stale point and every point owned by the level, a null level means every level is going away
+	for (int32 Index = Points.Num() - 1; Index >= 0; Index--)
+	{
+		const AActor* Actor = PointActors[Index].Get();
+		if (!Actor || !Level || Actor->GetLevel() == Level)
+			RemovePointAt(Index);
+	}
+}
+
+void UGrapplePointSubsystem::HandleActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason)
+{
+	UnregisterGrapplePoint(Actor);
+}
@@ -0,0 +1,117 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SceneComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "GrapplePointSubsystem.generated.h"
+
+//A grapple point near the player, copied out of the subsystem so it can be scored off the game thread
+struct FGrapplePointCandidate
+{
+	FVector Location = FVector::ZeroVector;
+	float Radius = 0.0f;
+	TWeakObjectPtr<AActor> Actor;
+};
+
+/// <summary>
+/// Keeps every grapple point in the world in a uniform grid so the grapple check
+/// can be answered without a physics sweep. Actors are registered automatically when
+/// they spawn or stream in if they own a primitive on the GrapplePoint object channel.
+/// Points with a movable root are moved to their new cell whenever the root moves.
+/// </summary>
+UCLASS()
+class SKYLINESHREDDER_API UGrapplePointSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/// <summary>
+	/// Adds an actor as a grapple point, or refreshes its location if it is already registered
+	/// </summary>
+	/// <param name="Actor">the grapple point actor</param>
+	void RegisterGrapplePoint(AActor* Actor);
+
+	/// <summary>
+	/// Removes an actor from the grapple points
+	/// </summary>
+	/// <param name="Actor">the grapple point actor</param>
+	void UnregisterGrapplePoint(AActor* Actor);
+
+	/// <summary>
+	/// Finds the grapple point a sphere swept from Start along Direction would touch first.
+	/// Matches the sphere trace the character used to do, including points that start inside the sphere.
+	/// </summary>
+	/// <param name="Start">start of the sweep</param>
+	/// <param name="Direction">normalized sweep direction</param>
+	/// <param name="Length">length of the sweep</param>
+	/// <param name="Radius">radius of the swept sphere</param>
+	/// <param name="OutImpactPoint">the point on the grapple point that was touched</param>
+	/// <param name="OutActor">the grapple point actor that was touched</param>
+	/// <returns>true if a grapple point was found</returns>
+	bool FindGrapplePoint(const FVector& Start, const FVector& Direction, float Length, float Radius, FVector& OutImpactPoint, AActor*& OutActor) const;
+
+	/// <summary>
+	/// Finds the grapple point a hook location is on, used by the server to check the hook a client sent
+	/// </summary>
+	/// <param name="Location">the hook location</param>
+	/// <param name="Tolerance">how far outside a grapple point the location can be</param>
+	/// <param name="OutActor">the grapple point actor the location is on</param>
+	/// <returns>true if the location is on a registered grapple point</returns>
+	bool FindGrapplePointAt(const FVector& Location, float Tolerance, AActor*& OutActor) const;
+
+	/// <summary>
+	/// Copies out every grapple point in the cells within a range of a location
+	/// </summary>
+	/// <param name="Center">the location to look around</param>
+	/// <param name="Range">how far from the location to look, points a little further may also be returned</param>
+	/// <param name="OutCandidates">the grapple points found, added to the end</param>
+	void GatherGrapplePoints(const FVector& Center, float Range, TArray<FGrapplePointCandidate>& OutCandidates) const;
+
+	/// <summary>
+	/// Checks if an actor owns a primitive on the GrapplePoint object channel
+	/// </summary>
+	static bool IsGrapplePointActor(const AActor* Actor);
+
+	int32 GetNumGrapplePoints() const { return Points.Num(); }
+
+	//The size of a grid cell, should be on the order of the grapple range
+	static constexpr float CellSize = 4000.0f;
+
+private:
+	//Packed data for a single grapple point, kept contiguous so the query only walks this array
+	struct FGrapplePoint
+	{
+		FVector Location;
+		float Radius;
+		FIntVector Cell;
+	};
+
+	TArray<FGrapplePoint> Points;
+	TArray<TWeakObjectPtr<AActor>> PointActors;
+	TArray<TObjectKey<AActor>> PointKeys;
+	TMap<FIntVector, TArray<int32>> Cells;
+	TMap<TObjectKey<AActor>, int32> ActorToPoint;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
+	static FIntVector GetCell(const FVector& Location);
+
+	void RemovePointAt(int32 Index);
+	void RegisterLevel(ULevel* Level);
+
+	void HandleActorSpawned(AActor* Actor);
+	void HandleTransformUpdated(USceneComponent* Component, EUpdateTransformFlags UpdateFlags, ETeleportType Teleport);
+	void HandleLevelAdded(ULevel* Level, UWorld* World);
+	void HandleLevelRemoved(ULevel* Level, UWorld* World);
+
+	UFUNCTION()
+	void HandleActorEndPlay(AActor* Actor, EEndPlayReason::Type EndPlayReason);
+};
@@ -0,0 +1,218 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GrappleRope.h"
+#include "SkylineShredder.h"
+#include "Engine/World.h"
+
+namespace GrappleRopeSettings
+{
+	//How far off a corner the rope sits, so the next trace doesn't start inside it
+	static constexpr float ContactOffset = 5.0f;
+
+	//How much of their velocity the nodes keep each step
+	static constexpr float Damping = 0.98f;
+
+	//Passes over the links each step
+	static constexpr int32 SolverIterations = 8;
+}
+
+void FGrappleRope::Attach(const FVector& PlayerLocation, const FVector& InHookLocation, float InMaxLength)
+{
+	HookLocation = InHookLocation;
+	Contacts.Reset();
+	WrappedLength = 0.0f;
+	Length = FMath::Max(FVector::Dist(PlayerLocation, InHookLocation), MinFreeLength);
+	MaxLength = FMath::Max(InMaxLength, Length);
+	bAttached = true;
+	ResetNodes(PlayerLocation);
+}
+
+void FGrappleRope::Detach()
+{
+	bAttached = false;
+	Contacts.Reset();
+	WrappedLength = 0.0f;
+}
+
+bool FGrappleRope::UpdateContacts(const UWorld* World, const FVector& PlayerLocation, const FCollisionQueryParams& Params)
+{
+	using namespace GrappleRopeSettings;
+
+	if (!bAttached || !World)
+		return false;
+
+	bool bChanged = false;
+
+	//Come off the last corner once the player has swung back past the line through it
+	while (Contacts.Num() > 0)
+	{
+		const FContact& Contact = Contacts.Last();
+		const FVector& Before = Contacts.Num() > 1 ? Contacts[Contacts.Num() - 2].Location : HookLocation;
+		const FVector Bend = FVector::CrossProduct(Contact.Location - Before, PlayerLocation - Contact.Location);
+		if (FVector::DotProduct(Bend, Contact.BendNormal) >= 0.0f)
+			break;
+
+		WrappedLength -= Contact.SegmentLength;
+		Contacts.Pop(false);
+		bChanged = true;
+	}
+
+	//Wrap around whatever the straight rope from the anchor to the player now goes through
+	const FVector Anchor = GetAnchor();
+	const FVector ToPlayer = PlayerLocation - Anchor;
+	const float Distance = ToPlayer.Size();
+	if (Contacts.Num() < MaxContacts && Distance > ContactOffset * 4.0f)
+	{
+		//Start just off the anchor so the trace doesn't hit what the rope is already around
+		const FVector Start = Anchor + ToPlayer / Distance * (ContactOffset * 2.0f);
+		FHitResult Hit;
+		PARKOUR_SCENE_QUERIES(1);
+		if (World->LineTraceSingleByChannel(Hit, Start, PlayerLocation, ECC_Visibility, Params) && !Hit.bStartPenetrating)
+		{
+			FContact Contact;
+			Contact.Location = Hit.ImpactPoint + Hit.ImpactNormal * ContactOffset;
+			Contact.SegmentLength = FVector::Dist(Anchor, Contact.Location);
+			Contact.BendNormal = FVector::CrossProduct(Contact.Location - Anchor, PlayerLocation - Contact.Location);
+
+			//Leave the player some rope to swing on past the corner
+			if (!Contact.BendNormal.IsNearlyZero() && WrappedLength + Contact.SegmentLength + MinFreeLength < Length)
+			{
+				WrappedLength += Contact.SegmentLength;
+				Contacts.Add(Contact);
+				bChanged = true;
+			}
+		}
+	}
+
+	if (bChanged)
+		ResetNodes(PlayerLocation);
+
+	return bChanged;
+}
+
+void FGrappleRope::Simulate(const FVector& PlayerLocation, float DeltaTime, float GravityZ)
+{
+	using namespace GrappleRopeSettings;
+
+	if (!bAttached || DeltaTime <= 0.0f)
+		return;
+
+	//Verlet step, the velocity of each node is how far it moved last step
+	const VectorRegister4Float KeptVelocity = VectorSetFloat1(Damping);
+	const VectorRegister4Float Fall = VectorSetFloat1(GravityZ * DeltaTime * DeltaTime);
+	for (int32 i = 0; i < NumNodes; i += 4)
+	{
+		const VectorRegister4Float NodeX = VectorLoad(X + i);
+		const VectorRegister4Float NodeY = VectorLoad(Y + i);
+		const VectorRegister4Float NodeZ = VectorLoad(Z + i);
+
+		VectorStore(VectorMultiplyAdd(VectorSubtract(NodeX, VectorLoad(PreviousX + i)), KeptVelocity, NodeX), X + i);
+		VectorStore(VectorMultiplyAdd(VectorSubtract(NodeY, VectorLoad(PreviousY + i)), KeptVelocity, NodeY), Y + i);
+		VectorStore(VectorAdd(VectorMultiplyAdd(VectorSubtract(NodeZ, VectorLoad(PreviousZ + i)), KeptVelocity, NodeZ), Fall), Z + i);
+
+		VectorStore(NodeX, PreviousX + i);
+		VectorStore(NodeY, PreviousY + i);
+		VectorStore(NodeZ, PreviousZ + i);
+	}
+
+	const FVector PlayerOffset = PlayerLocation - GetAnchor();
+	const float RestLength = GetFreeLength() / (NumNodes - 1);
+
+	PinEnds(PlayerOffset);
+	for (int32 Iteration = 0; Iteration < SolverIterations; Iteration++)
+	{
+		SolveLinks(RestLength);
+		PinEnds(PlayerOffset);
+	}
+}
+
+void FGrappleRope::Reel(float Delta)
+{
+	if (bAttached)
+		Length = FMath::Clamp(Length + Delta, WrappedLength + MinFreeLength, MaxLength);
+}
+
+void FGrappleRope::SetMaxLength(float InMaxLength)
+{
+	if (!bAttached)
+		return;
+
+	MaxLength = FMath::Max(InMaxLength, WrappedLength + MinFreeLength);
+	Length = FMath::Min(Length, MaxLength);
+}
+
+void FGrappleRope::GetPoints(TArray<FVector>& OutPoints) const
+{
+	OutPoints.Reset();
+	if (!bAttached)
+		return;
+
+	OutPoints.Reserve(1 + Contacts.Num() + NumNodes);
+	OutPoints.Add(HookLocation);
+	for (const FContact& Contact : Contacts)
+		OutPoints.Add(Contact.Location);
+
+	//The nodes run from the player to the anchor, which is already in, so add them the other way
+	const FVector Anchor = GetAnchor();
+	for (int32 i = NumNodes - 2; i >= 0; i--)
+		OutPoints.Add(Anchor + FVector(X[i], Y[i], Z[i]));
+}
+
+void FGrappleRope::ResetNodes(const FVector& PlayerLocation)
+{
+	const FVector PlayerOffset = PlayerLocation - GetAnchor();
+	for (int32 i = 0; i < NumNodes; i++)
+	{
+		const float Alpha = 1.0f - (float)i / (NumNodes - 1);
+		X[i] = PreviousX[i] = PlayerOffset.X * Alpha;
+		Y[i] = PreviousY[i] = PlayerOffset.Y * Alpha;
+		Z[i] = PreviousZ[i] = PlayerOffset.Z * Alpha;
+	}
+}
+
+void FGrappleRope::PinEnds(const FVector& PlayerOffset)
+{
+	X[0] = PlayerOffset.X;
+	Y[0] = PlayerOffset.Y;
+	Z[0] = PlayerOffset.Z;
+	X[NumNodes - 1] = Y[NumNodes - 1] = Z[NumNodes - 1] = 0.0f;
+}
+
+void FGrappleRope::SolveLinks(float RestLength)
+{
+	//Every link is corrected from the same positions, then each node takes half of the correction of the
+	//links either side. A rope doesn't push back when squashed, so only stretched links pull
+	const VectorRegister4Float Rest = VectorSetFloat1(RestLength);
+	const VectorRegister4Float Half = VectorSetFloat1(0.5f);
+	const VectorRegister4Float Smallest = VectorSetFloat1(KINDA_SMALL_NUMBER);
+	for (int32 i = 0; i < NumNodes; i += 4)
+	{
+		const VectorRegister4Float LinkX = VectorSubtract(VectorLoad(X + i + 1), VectorLoad(X + i));
+		const VectorRegister4Float LinkY = VectorSubtract(VectorLoad(Y + i + 1), VectorLoad(Y + i));
+		const VectorRegister4Float LinkZ = VectorSubtract(VectorLoad(Z + i + 1), VectorLoad(Z + i));
+
+		VectorRegister4Float LengthSquared = VectorMultiply(LinkX, LinkX);
+		LengthSquared = VectorMultiplyAdd(LinkY, LinkY, LengthSquared);
+		LengthSquared = VectorMultiplyAdd(LinkZ, LinkZ, LengthSquared);
+		LengthSquared = VectorMax(LengthSquared, Smallest);
+
+		//(1 - rest / length) / 2 of the link, nothing for links shorter than their rest length
+		VectorRegister4Float Stretch = VectorSubtract(VectorOne(), VectorMultiply(Rest, VectorReciprocalSqrtAccurate(LengthSquared)));
+		Stretch = VectorMultiply(VectorMax(Stretch, VectorZero()), Half);
+
+		VectorStore(VectorMultiply(LinkX, Stretch), CorrectionX + i + 1);
+		VectorStore(VectorMultiply(LinkY, Stretch), CorrectionY + i + 1);
+		VectorStore(VectorMultiply(LinkZ, Stretch), CorrectionZ + i + 1);
+	}
+
+	//The link after the last node doesn't exist, and the one before the first is always 0
+	CorrectionX[NumNodes] = CorrectionY[NumNodes] = CorrectionZ[NumNodes] = 0.0f;
+
+	for (int32 i = 0; i < NumNodes; i += 4)
+	{
+		VectorStore(VectorAdd(VectorLoad(X + i), VectorSubtract(VectorLoad(CorrectionX + i + 1), VectorLoad(CorrectionX + i))), X + i);
+		VectorStore(VectorAdd(VectorLoad(Y + i), VectorSubtract(VectorLoad(CorrectionY + i + 1), VectorLoad(CorrectionY + i))), Y + i);
+		VectorStore(VectorAdd(VectorLoad(Z + i), VectorSubtract(VectorLoad(CorrectionZ + i + 1), VectorLoad(CorrectionZ + i))), Z + i);
+	}
+}
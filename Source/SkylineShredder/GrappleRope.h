@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UWorld;
+struct FCollisionQueryParams;
+
+/// <summary>
+/// The grapple rope. The rope has a length the player swings on, wraps around the corners it swings
+/// into and can be reeled in and out. The part between the player and the last corner is simulated as
+/// a fixed number of Verlet nodes, stored as arrays of each axis inside the rope so the whole rope is a
+/// few cache lines, and the nodes are stepped and constrained four at a time with SIMD.
+/// </summary>
+class SKYLINESHREDDER_API FGrappleRope
+{
+public:
+	//Nodes in the free part of the rope, a multiple of the SIMD width
+	static constexpr int32 NumNodes = 16;
+
+	//Corners the rope can wrap around at once
+	static constexpr int32 MaxContacts = 8;
+
+	//The shortest the free part of the rope can be reeled in to
+	static constexpr float MinFreeLength = 100.0f;
+
+	/// <summary>
+	/// Attaches the rope to a hook, as long as the distance to it
+	/// </summary>
+	/// <param name="PlayerLocation">the end of the rope the player holds</param>
+	/// <param name="InHookLocation">where the rope is hooked</param>
+	/// <param name="InMaxLength">the longest the rope can be reeled out to, never shorter than it starts</param>
+	void Attach(const FVector& PlayerLocation, const FVector& InHookLocation, float InMaxLength);
+	void Detach();
+
+	/// <summary>
+	/// Wraps the rope around anything the player has swung it into, and takes it off corners the player
+	/// has swung back around. One line trace a call, the corners are kept until unwrapped
+	/// </summary>
+	/// <returns>true if the rope wrapped or unwrapped</returns>
+	bool UpdateContacts(const UWorld* World, const FVector& PlayerLocation, const FCollisionQueryParams& Params);
+
+	/// <summary>
+	/// Steps the nodes of the free part of the rope, only needed for showing the rope
+	/// </summary>
+	void Simulate(const FVector& PlayerLocation, float DeltaTime, float GravityZ);
+
+	/// <summary>
+	/// Reels the rope in with a negative amount or out with a positive one
+	/// </summary>
+	void Reel(float Delta);
+
+	/// <summary>
+	/// Changes the longest the rope can be reeled out to, reeling it in if it is longer than that
+	/// </summary>
+	void SetMaxLength(float InMaxLength);
+
+	bool IsAttached() const { return bAttached; }
+	float GetLength() const { return Length; }
+	float GetMaxLength() const { return MaxLength; }
+	const FVector& GetHookLocation() const { return HookLocation; }
+	int32 GetNumContacts() const { return Contacts.Num(); }
+
+	//The length left for the player to swing on after the corners the rope is wrapped around
+	float GetFreeLength() const { return FMath::Max(Length - WrappedLength, MinFreeLength); }
+
+	//The point the player swings around, the last corner or the hook
+	const FVector& GetAnchor() const { return Contacts.Num() > 0 ? Contacts.Last().Location : HookLocation; }
+
+	/// <summary>
+	/// Gets the rope from the hook, around the corners and along the nodes to the player, for drawing it
+	/// </summary>
+	void GetPoints(TArray<FVector>& OutPoints) const;
+
+private:
+	struct FContact
+	{
+		FVector Location;
+
+		//Which way the rope bends around the corner, it comes off when the player swings back past it
+		FVector BendNormal;
+
+		//The length of rope from the point before to this corner
+		float SegmentLength;
+	};
+
+	TArray<FContact, TInlineAllocator<MaxContacts>> Contacts;
+	FVector HookLocation = FVector::ZeroVector;
+	float Length = 0.0f;
+	float MaxLength = 0.0f;
+	float WrappedLength = 0.0f;
+	bool bAttached = false;
+
+	//Node positions relative to the anchor, node 0 at the player and the last node at the anchor. Padded by
+	//a SIMD width so loading the node after the last one stays in bounds
+	static constexpr int32 PaddedNodes = NumNodes + 4;
+	float X[PaddedNodes] = {};
+	float Y[PaddedNodes] = {};
+	float Z[PaddedNodes] = {};
+	float PreviousX[PaddedNodes] = {};
+	float PreviousY[PaddedNodes] = {};
+	float PreviousZ[PaddedNodes] = {};
+
+	//The correction of each link, link i stored at i + 1 so node i finds the links either side at i and i + 1
+	float CorrectionX[PaddedNodes + 1] = {};
+	float CorrectionY[PaddedNodes + 1] = {};
+	float CorrectionZ[PaddedNodes + 1] = {};
+
+	//Lays the nodes out straight from the player to the anchor, at rest
+	void ResetNodes(const FVector& PlayerLocation);
+
+	//Puts the end nodes back on the player and the anchor
+	void PinEnds(const FVector& PlayerOffset);
+
+	//Pulls each stretched link back towards its rest length, all the links at once
+	void SolveLinks(float RestLength);
+};
@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GrappleTargetingComponent.h"
+#include "SkylineShredder.h"
+#include "Async/Async.h"
+#include "Engine/World.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/Pawn.h"
+
+// Sets default values for this component's properties
+UGrappleTargetingComponent::UGrappleTargetingComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	SightTraceDelegate.BindUObject(this, &UGrappleTargetingComponent::HandleSightTrace);
+}
+
+void UGrappleTargetingComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//Scoring every frame gains nothing, the target only has to be ready by the time grapple is pressed
+	SetComponentTickInterval(UpdateInterval);
+}
+
+void UGrappleTargetingComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//Scoring still running only has its own copy of the points, so it can finish on its own
+	PendingScores = TFuture<TArray<FScoredPoint>>();
+	Ranked.Reset();
+	SightBatch++;
+	SetTarget(FGrapplePointCandidate());
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UGrappleTargetingComponent::GetTarget(const FVector& From, FVector& OutHookLocation, AActor*& OutActor) const
+{
+	OutActor = Target.Actor.Get();
+	if (!OutActor)
+		return false;
+
+	//Hook onto the side of the point facing the player, like the grapple sweep did
+	OutHookLocation = Target.Location + (From - Target.Location).GetSafeNormal() * Target.Radius;
+	return true;
+}
+
+void UGrappleTargetingComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	//Only the player or AI controlling the pawn grapples with it
+	const APawn* Pawn = Cast<APawn>(GetOwner());
+	if (!Pawn || !Pawn->IsLocallyControlled())
+	{
+		if (Target.Actor.IsValid())
+			SetTarget(FGrapplePointCandidate());
+		return;
+	}
+
+	//Check line of sight to the best of the points scored since the last update
+	if (PendingScores.IsValid() && PendingScores.IsReady())
+	{
+		const TArray<FScoredPoint> Scores = PendingScores.Get();
+		PendingScores = TFuture<TArray<FScoredPoint>>();
+		CheckSight(*Pawn, Scores);
+	}
+
+	//Then start scoring the points around the player now
+	if (!PendingScores.IsValid())
+		StartScoring(*Pawn);
+}
+
+void UGrappleTargetingComponent::StartScoring(const APawn& Pawn)
+{
+	const UGrapplePointSubsystem* GrapplePoints = GetWorld()->GetSubsystem<UGrapplePointSubsystem>();
+	if (!GrapplePoints)
+		return;
+
+	//Aim where the controller is looking, the camera for players and the eyes for AI
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	if (const AController* Controller = Pawn.GetController())
+		Controller->GetPlayerViewPoint(ViewLocation, ViewRotation);
+	else
+		ViewRotation = Pawn.GetActorRotation();
+
+	FScoreInput Input;
+	Input.Start = Pawn.GetActorLocation();
+	Input.Aim = ViewRotation.Vector();
+	Input.Velocity = Pawn.GetVelocity();
+	Input.Range = Range;
+	Input.AimRadius = AimRadius;
+	Input.AlignmentWeight = AlignmentWeight;
+	Input.DistanceWeight = DistanceWeight;
+	Input.MomentumWeight = MomentumWeight;
+	Input.MaxResults = FMath::Max(MaxSightChecks, 1);
+
+	ScoredCandidates.Reset();
+	GrapplePoints->GatherGrapplePoints(Input.Start, Range + AimRadius, ScoredCandidates);
+
+	Input.Points.Reserve(ScoredCandidates.Num());
+	for (const FGrapplePointCandidate& Candidate : ScoredCandidates)
+		Input.Points.Add(FVector4(Candidate.Location, Candidate.Radius));
+
+	PendingScores = Async(EAsyncExecution::TaskGraph, [Input = MoveTemp(Input)]()
+	{
+		return ScorePoints(Input);
+	});
+}
+
+TArray<UGrappleTargetingComponent::FScoredPoint> UGrappleTargetingComponent::ScorePoints(const FScoreInput& Input)
+{
+	TArray<FScoredPoint> Scores;
+	const float Reach = Input.Range + Input.AimRadius;
+	const float Speed = Input.Velocity.Size();
+	const FVector MoveDirection = Speed > 100.0f ? Input.Velocity / Speed : FVector::ZeroVector;
+
+	for (int32 Index = 0; Index < Input.Points.Num(); Index++)
+	{
+		const FVector Location(Input.Points[Index]);
+		const float ContactRadius = Input.AimRadius + Input.Points[Index].W;
+
+		//Only the points the old grapple sweep could reach, in front of the player and close to the aim
+		const FVector ToPoint = Location - Input.Start;
+		const float Along = FVector::DotProduct(ToPoint, Input.Aim);
+		const float DistanceSquared = ToPoint.SizeSquared();
+		if (Along < 0.0f || Along > Input.Range + ContactRadius || DistanceSquared - Along * Along > ContactRadius * ContactRadius)
+			continue;
+
+		const float Distance = FMath::Max(FMath::Sqrt(DistanceSquared), KINDA_SMALL_NUMBER);
+		const FVector Direction = ToPoint / Distance;
+
+		const float Alignment = Along / Distance;
+		const float Closeness = 1.0f - FMath::Min(Distance / Reach, 1.0f);
+		const float Momentum = FMath::Max(FVector::DotProduct(Direction, MoveDirection), 0.0f);
+		Scores.Add({ Index, Input.AlignmentWeight * Alignment + Input.DistanceWeight * Closeness + Input.MomentumWeight * Momentum });
+	}
+
+	Scores.Sort([](const FScoredPoint& A, const FScoredPoint& B) { return A.Score > B.Score; });
+	if (Scores.Num() > Input.MaxResults)
+		Scores.SetNum(Input.MaxResults, false);
+
+	return Scores;
+}
+
+void UGrappleTargetingComponent::CheckSight(const APawn& Pawn, const TArray<FScoredPoint>& Scores)
+{
+	//Traces from the last batch that haven't come back are ignored when they do
+	SightBatch++;
+	Ranked.Reset();
+	bHasScored = true;
+
+	if (Scores.Num() == 0)
+	{
+		SetTarget(FGrapplePointCandidate());
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	const FVector Eyes = Pawn.GetPawnViewLocation();
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(GrappleSight), false, &Pawn);
+
+	//All the sight traces go out together and come back together the next frame
+	for (const FScoredPoint& Score : Scores)
+	{
+		FRankedPoint& Point = Ranked.AddDefaulted_GetRef();
+		Point.Candidate = ScoredCandidates[Score.Index];
+
+		const FVector HookLocation = Point.Candidate.Location + (Eyes - Point.Candidate.Location).GetSafeNormal() * Point.Candidate.Radius;
+		Point.SightTrace = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Eyes, HookLocation, ECC_Visibility, TraceParams,
+			FCollisionResponseParams::DefaultResponseParam, &SightTraceDelegate, SightBatch);
+	}
+
+	PARKOUR_SCENE_QUERIES(Ranked.Num());
+}
+
+void UGrappleTargetingComponent::HandleSightTrace(const FTraceHandle& Handle, FTraceDatum& Data)
+{
+	if (Data.UserData != SightBatch)
+		return;
+
+	FRankedPoint* Point = Ranked.FindByPredicate([&Handle](const FRankedPoint& Other) { return Other.SightTrace == Handle; });
+	if (!Point)
+		return;
+
+	//In sight if nothing is in the way, or the only thing in the way is the grapple point itself
+	const FHitResult* Hit = Data.OutHits.Num() > 0 && Data.OutHits[0].bBlockingHit ? &Data.OutHits[0] : nullptr;
+	Point->bChecked = true;
+	Point->bInSight = !Hit || Hit->GetActor() == Point->Candidate.Actor.Get();
+
+	//Once every trace is back the best point in sight is the target
+	if (Ranked.ContainsByPredicate([](const FRankedPoint& Other) { return !Other.bChecked; }))
+		return;
+
+	const FRankedPoint* Best = Ranked.FindByPredicate([](const FRankedPoint& Other) { return Other.bInSight && Other.Candidate.Actor.IsValid(); });
+	SetTarget(Best ? Best->Candidate : FGrapplePointCandidate());
+}
+
+void UGrappleTargetingComponent::SetTarget(const FGrapplePointCandidate& NewTarget)
+{
+	const bool bChanged = NewTarget.Actor != Target.Actor;
+	Target = NewTarget;
+
+	if (bChanged)
+		OnTargetChanged.Broadcast(Target.Actor.Get());
+}
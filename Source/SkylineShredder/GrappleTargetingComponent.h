@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Components/ActorComponent.h"
+#include "GrapplePointSubsystem.h"
+#include "WorldCollision.h"
+#include "GrappleTargetingComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnGrappleTargetChanged, AActor*, Target);
+
+/// <summary>
+/// Keeps the best grapple point for the player up to date in the background, so pressing grapple attaches
+/// straight away without querying anything. Every few frames the grapple points around the player are scored
+/// on a worker thread by distance, how close they are to where the player is looking and how well they line
+/// up with where the player is going. The best few are then checked for line of sight with async traces,
+/// which come back the frame after, and the best one in sight becomes the target.
+/// </summary>
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class SKYLINESHREDDER_API UGrappleTargetingComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UGrappleTargetingComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	//How far along the aim a grapple point can be, and how far either side of it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float Range = 6000.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float AimRadius = 2500.0f;
+
+	//Seconds between scoring the grapple points
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float UpdateInterval = 0.05f;
+
+	//How many of the best scored points are checked for line of sight
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	int32 MaxSightChecks = 4;
+
+	//How much being looked at, being close and being ahead of the player's movement count for
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float AlignmentWeight = 1.0f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float DistanceWeight = 0.5f;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grapple")
+	float MomentumWeight = 0.5f;
+
+	//Called when the target changes, for highlighting it
+	UPROPERTY(BlueprintAssignable, Category = "Grapple")
+	FOnGrappleTargetChanged OnTargetChanged;
+
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	bool HasTarget() const { return Target.Actor.IsValid(); }
+
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	AActor* GetTargetActor() const { return Target.Actor.Get(); }
+
+	/// <summary>
+	/// Gets the target to hook onto
+	/// </summary>
+	/// <param name="From">where the grapple is fired from</param>
+	/// <param name="OutHookLocation">the point on the target facing where the grapple is fired from</param>
+	/// <param name="OutActor">the target actor</param>
+	/// <returns>false if there is no target in sight</returns>
+	bool GetTarget(const FVector& From, FVector& OutHookLocation, AActor*& OutActor) const;
+
+	//If the grapple points have been scored and checked at least once, until then there is no answer either way
+	bool HasScored() const { return bHasScored; }
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	//What the worker needs to score the grapple points
+	struct FScoreInput
+	{
+		FVector Start;
+		FVector Aim;
+		FVector Velocity;
+		float Range;
+		float AimRadius;
+		float AlignmentWeight;
+		float DistanceWeight;
+		float MomentumWeight;
+		int32 MaxResults;
+
+		//Location and radius of each candidate
+		TArray<FVector4> Points;
+	};
+
+	struct FScoredPoint
+	{
+		int32 Index;
+		float Score;
+	};
+
+	//A point that scored well, waiting on its line of sight
+	struct FRankedPoint
+	{
+		FGrapplePointCandidate Candidate;
+		FTraceHandle SightTrace;
+		bool bChecked = false;
+		bool bInSight = false;
+	};
+
+	TFuture<TArray<FScoredPoint>> PendingScores;
+	TArray<FGrapplePointCandidate> ScoredCandidates;
+
+	//The best points of the last scoring in order, and which batch of sight traces they are waiting on
+	TArray<FRankedPoint> Ranked;
+	uint32 SightBatch = 0;
+	FTraceDelegate SightTraceDelegate;
+
+	FGrapplePointCandidate Target;
+	bool bHasScored = false;
+
+	static TArray<FScoredPoint> ScorePoints(const FScoreInput& Input);
+
+	void StartScoring(const APawn& Pawn);
+	void CheckSight(const APawn& Pawn, const TArray<FScoredPoint>& Scores);
+	void HandleSightTrace(const FTraceHandle& Handle, FTraceDatum& Data);
+	void SetTarget(const FGrapplePointCandidate& NewTarget);
+};
@@ -0,0 +1,322 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InstanceClusterCommandlet.h"
+#include "SkylineShredder.h"
+#include "GrapplePointSubsystem.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/Level.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+namespace
+{
+	//Everything a group of actors has to share to become one cluster
+	struct FClusterKey
+	{
+		UStaticMesh* Mesh = nullptr;
+		TArray<UMaterialInterface*> Materials;
+		TArray<FName> Tags;
+		ECollisionEnabled::Type CollisionEnabled = ECollisionEnabled::NoCollision;
+		FCollisionResponseContainer Responses;
+		ECollisionChannel ObjectType = ECC_WorldStatic;
+		bool bCastShadow = true;
+
+		//The grid cell, and the yaw of the faces, so every instance's faces line up with the cluster's for wall running
+		FIntPoint Cell = FIntPoint::ZeroValue;
+		int32 Yaw = 0;
+
+		bool operator==(const FClusterKey& Other) const
+		{
+			return Mesh == Other.Mesh && Materials == Other.Materials && Tags == Other.Tags && CollisionEnabled == Other.CollisionEnabled
+				&& Responses == Other.Responses && ObjectType == Other.ObjectType && bCastShadow == Other.bCastShadow && Cell == Other.Cell && Yaw == Other.Yaw;
+		}
+
+		friend uint32 GetTypeHash(const FClusterKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.Mesh), GetTypeHash(Key.Cell)), HashCombine(GetTypeHash(Key.Yaw), GetTypeHash(Key.Tags.Num())));
+		}
+	};
+
+	struct FCluster
+	{
+		//The component the cluster copies its collision from
+		UStaticMeshComponent* Source = nullptr;
+		TArray<AStaticMeshActor*> Actors;
+		TArray<FTransform> Transforms;
+	};
+
+	void CountLevel(const ULevel* Level, int32& OutActors, int32& OutComponents)
+	{
+		OutActors = 0;
+		OutComponents = 0;
+		for (const AActor* Actor : Level->Actors)
+		{
+			if (!Actor)
+				continue;
+
+			OutActors++;
+			OutComponents += Actor->GetComponents().Num();
+		}
+	}
+
+	//Gets the key an actor is clustered by, or false if it has to stay an actor
+	bool GetClusterKey(AActor* Actor, float CellSize, FClusterKey& OutKey, FTransform& OutTransform)
+	{
+		//Only plain static mesh actors with nothing else on them, anything derived may have behaviour of its own
+		AStaticMeshActor* MeshActor = Actor && Actor->GetClass() == AStaticMeshActor::StaticClass() ? static_cast<AStaticMeshActor*>(Actor) : nullptr;
+		UStaticMeshComponent* Mesh = MeshActor ? MeshActor->GetStaticMeshComponent() : nullptr;
+		if (!Mesh || !Mesh->GetStaticMesh() || Mesh->Mobility != EComponentMobility::Static || MeshActor->GetComponents().Num() != 1
+			|| MeshActor->IsHidden() || !Mesh->IsVisible() || UGrapplePointSubsystem::IsGrapplePointActor(MeshActor))
+			return false;
+
+		//The world isn't running, so make sure the transform is up to date
+		Mesh->UpdateComponentToWorld();
+		OutTransform = Mesh->GetComponentTransform();
+
+		//Tilted meshes have faces the wall run can't cache for a whole cluster
+		const FRotator Rotation = OutTransform.Rotator();
+		if (!FMath::IsNearlyZero(Rotation.Pitch, 0.5f) || !FMath::IsNearlyZero(Rotation.Roll, 0.5f))
+			return false;
+
+		OutKey.Mesh = Mesh->GetStaticMesh();
+		for (int32 Index = 0; Index < Mesh->GetNumMaterials(); Index++)
+			OutKey.Materials.Add(Mesh->GetMaterial(Index));
+
+		//The actor's and the component's tags both end up on the cluster component
+		OutKey.Tags = MeshActor->Tags;
+		for (const FName& Tag : Mesh->ComponentTags)
+			OutKey.Tags.AddUnique(Tag);
+		OutKey.Tags.Sort(FNameLexicalLess());
+
+		OutKey.CollisionEnabled = Mesh->GetCollisionEnabled();
+		OutKey.Responses = Mesh->GetCollisionResponseToChannels();
+		OutKey.ObjectType = Mesh->GetCollisionObjectType();
+		OutKey.bCastShadow = Mesh->CastShadow;
+
+		const FVector Location = OutTransform.GetLocation();
+		OutKey.Cell = FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+		OutKey.Yaw = FMath::RoundToInt(FRotator::ClampAxis(Rotation.Yaw)) % 90;
+		return true;
+	}
+
+	//Spawning the clusters needs the world's scenes
+	bool InitWorld(UWorld* World)
+	{
+		if (World->bIsWorldInitialized)
+			return false;
+
+		World->WorldType = EWorldType::Editor;
+		World->InitWorld(UWorld::InitializationValues()
+			.ShouldSimulatePhysics(false)
+			.EnableTraceCollision(false)
+			.CreateNavigation(false)
+			.CreateAISystem(false)
+			.AllowAudioPlayback(false)
+			.RequiresHitProxies(false));
+		World->UpdateWorldComponents(true, false);
+		return true;
+	}
+}
+
+UInstanceClusterCommandlet::UInstanceClusterCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UInstanceClusterCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	//Cluster the blockout unless other maps were asked for
+	FString MapsParam = ParamValues.FindRef(TEXT("Maps"));
+	if (MapsParam.IsEmpty())
+		MapsParam = TEXT("/Game/Maps/CityBlockout_Level");
+
+	if (const FString* CellSizeParam = ParamValues.Find(TEXT("CellSize")))
+		CellSize = FMath::Max(FCString::Atof(**CellSizeParam), 100.0f);
+	if (const FString* MinInstancesParam = ParamValues.Find(TEXT("MinInstances")))
+		MinInstances = FMath::Max(FCString::Atoi(**MinInstancesParam), 2);
+	bDryRun = Switches.Contains(TEXT("DryRun"));
+
+	TArray<FString> Maps;
+	MapsParam.ParseIntoArray(Maps, TEXT(","));
+
+	int32 NumFailed = 0;
+	for (const FString& Map : Maps)
+	{
+		if (!ClusterMap(Map))
+			NumFailed++;
+	}
+
+	return NumFailed == 0 ? 0 : 1;
+}
+
+bool UInstanceClusterCommandlet::ClusterMap(const FString& MapPackageName) const
+{
+	UPackage* MapPackage = LoadPackage(nullptr, *MapPackageName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogSkylineShredder, Error, TEXT("InstanceCluster: could not load map %s"), *MapPackageName);
+		return false;
+	}
+
+	//Each sublevel is a streaming cell saved in its own package, so clusters never cross from one into another
+	TArray<FString> SublevelNames;
+	for (const ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		if (StreamingLevel)
+			SublevelNames.Add(StreamingLevel->GetWorldAssetPackageName());
+	}
+
+	bool bSaved = ClusterLevel(World);
+
+	for (const FString& SublevelName : SublevelNames)
+	{
+		UPackage* LevelPackage = LoadPackage(nullptr, *SublevelName, LOAD_None);
+		UWorld* LevelWorld = LevelPackage ? UWorld::FindWorldInPackage(LevelPackage) : nullptr;
+		if (!LevelWorld)
+		{
+			UE_LOG(LogSkylineShredder, Error, TEXT("InstanceCluster: could not load sublevel %s"), *SublevelName);
+			bSaved = false;
+			continue;
+		}
+
+		bSaved &= ClusterLevel(LevelWorld);
+	}
+
+	return bSaved;
+}
+
+bool UInstanceClusterCommandlet::ClusterLevel(UWorld* World) const
+{
+	ULevel* Level = World->PersistentLevel;
+	const FString PackageName = World->GetOutermost()->GetName();
+
+	int32 ActorsBefore;
+	int32 ComponentsBefore;
+	CountLevel(Level, ActorsBefore, ComponentsBefore);
+
+	TMap<FClusterKey, FCluster> Clusters;
+	for (AActor* Actor : Level->Actors)
+	{
+		FClusterKey Key;
+		FTransform Transform;
+		if (!GetClusterKey(Actor, CellSize, Key, Transform))
+			continue;
+
+		FCluster& Cluster = Clusters.FindOrAdd(MoveTemp(Key));
+		AStaticMeshActor* MeshActor = static_cast<AStaticMeshActor*>(Actor);
+		if (!Cluster.Source)
+			Cluster.Source = MeshActor->GetStaticMeshComponent();
+		Cluster.Actors.Add(MeshActor);
+		Cluster.Transforms.Add(Transform);
+	}
+
+	//Meshes that aren't repeated enough stay as they are
+	for (auto It = Clusters.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Actors.Num() < MinInstances)
+			It.RemoveCurrent();
+	}
+
+	int32 NumMerged = 0;
+	for (const TPair<FClusterKey, FCluster>& Pair : Clusters)
+		NumMerged += Pair.Value.Actors.Num();
+
+	if (bDryRun || Clusters.Num() == 0)
+	{
+		UE_LOG(LogSkylineShredder, Display, TEXT("InstanceCluster: %s would merge %d actors into %d clusters, %d actors and %d components now"),
+			*PackageName, NumMerged, Clusters.Num(), ActorsBefore, ComponentsBefore);
+		return true;
+	}
+
+	const bool bInitializedWorld = InitWorld(World);
+
+	//One actor for each grid cell holds the clusters in it
+	TMap<FIntPoint, AActor*> CellActors;
+	for (const TPair<FClusterKey, FCluster>& Pair : Clusters)
+	{
+		const FClusterKey& Key = Pair.Key;
+		const FCluster& Cluster = Pair.Value;
+		const FVector CellCenter((Key.Cell.X + 0.5f) * CellSize, (Key.Cell.Y + 0.5f) * CellSize, 0.0f);
+
+		AActor*& CellActor = CellActors.FindOrAdd(Key.Cell);
+		if (!CellActor)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.OverrideLevel = Level;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			CellActor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(CellCenter), SpawnParams);
+
+			USceneComponent* Root = NewObject<USceneComponent>(CellActor, TEXT("Root"));
+			Root->SetMobility(EComponentMobility::Static);
+			Root->SetWorldLocation(CellCenter);
+			CellActor->SetRootComponent(Root);
+			CellActor->AddInstanceComponent(Root);
+			Root->RegisterComponent();
+
+#if WITH_EDITOR
+			CellActor->SetActorLabel(FString::Printf(TEXT("InstanceCluster_%d_%d"), Key.Cell.X, Key.Cell.Y));
+#endif
+		}
+
+		UHierarchicalInstancedStaticMeshComponent* Instances = NewObject<UHierarchicalInstancedStaticMeshComponent>(CellActor);
+		Instances->SetMobility(EComponentMobility::Static);
+		Instances->SetStaticMesh(Key.Mesh);
+		for (int32 Index = 0; Index < Key.Materials.Num(); Index++)
+			Instances->SetMaterial(Index, Key.Materials[Index]);
+
+		Instances->BodyInstance.CopyBodyInstancePropertiesFrom(&Cluster.Source->BodyInstance);
+		Instances->CastShadow = Key.bCastShadow;
+		Instances->ComponentTags = Key.Tags;
+
+		//Turned to the yaw of its instances, the wall run caches one set of faces for the whole component
+		Instances->SetupAttachment(CellActor->GetRootComponent());
+		Instances->SetRelativeRotation(FRotator(0.0f, Key.Yaw, 0.0f));
+		CellActor->AddInstanceComponent(Instances);
+		Instances->RegisterComponent();
+
+		const FTransform ClusterTransform = Instances->GetComponentTransform();
+		for (const FTransform& Transform : Cluster.Transforms)
+			Instances->AddInstance(Transform.GetRelativeTransform(ClusterTransform));
+		Instances->BuildTreeIfOutdated(false, true);
+
+		for (AStaticMeshActor* Actor : Cluster.Actors)
+			World->DestroyActor(Actor);
+	}
+
+	int32 ActorsAfter;
+	int32 ComponentsAfter;
+	CountLevel(Level, ActorsAfter, ComponentsAfter);
+
+	World->GetOutermost()->MarkPackageDirty();
+
+	bool bSaved = false;
+#if WITH_EDITOR
+	const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetMapPackageExtension());
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Standalone;
+	bSaved = UPackage::SavePackage(World->GetOutermost(), World, *Filename, SaveArgs);
+#endif
+
+	if (bInitializedWorld)
+		World->CleanupWorld();
+
+	UE_LOG(LogSkylineShredder, Display, TEXT("InstanceCluster: %s merged %d actors into %d clusters, actors %d -> %d, components %d -> %d, %s"),
+		*PackageName, NumMerged, Clusters.Num(), ActorsBefore, ActorsAfter, ComponentsBefore, ComponentsAfter,
+		bSaved ? TEXT("saved") : TEXT("failed to save"));
+	return bSaved;
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "InstanceClusterCommandlet.generated.h"
+
+/// <summary>
+/// Replaces the repeated static mesh actors of each map with hierarchical instanced static mesh clusters.
+/// Actors with the same mesh, materials, collision and tags are merged per sublevel and per grid cell, so a
+/// cluster never crosses a streaming cell and stays small enough to cull. Tags go on the cluster component,
+/// which is where the wall run check looks for them, and grapple points and tilted meshes are left alone.
+/// Bake the ledges again after running it.
+/// Usage: UnrealEditor-Cmd SkylineShredder.uproject -run=InstanceCluster [-Maps=/Game/Maps/A,/Game/Maps/B] [-CellSize=10000] [-MinInstances=2] [-DryRun]
+/// </summary>
+UCLASS()
+class UInstanceClusterCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UInstanceClusterCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	//The size of a cluster cell, and how many actors have to share everything before they are merged
+	float CellSize = 10000.0f;
+	int32 MinInstances = 2;
+
+	//Only report what would be merged, without changing or saving anything
+	bool bDryRun = false;
+
+	/// <summary>
+	/// Clusters the persistent level of a map and each of its sublevels, which are saved in their own packages
+	/// </summary>
+	/// <returns>true if every level was saved</returns>
+	bool ClusterMap(const FString& MapPackageName) const;
+
+	/// <summary>
+	/// Merges the repeated static mesh actors of one level and saves it
+	/// </summary>
+	/// <returns>true if the level was saved, or had nothing to merge</returns>
+	bool ClusterLevel(class UWorld* World) const;
+};
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeBakeCommandlet.h"
+#include "SkylineShredder.h"
+#include "LedgeDataAsset.h"
+#include "LedgeSubsystem.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Level.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+#include "PhysicsEngine/BodySetup.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+ULedgeBakeCommandlet::ULedgeBakeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 ULedgeBakeCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	//Bake the city levels unless other maps were asked for
+	FString MapsParam = ParamValues.FindRef(TEXT("Maps"));
+	if (MapsParam.IsEmpty())
+		MapsParam = TEXT("/Game/Maps/CityBlockout_Level,/Game/Maps/Main_Level");
+
+	TArray<FString> Maps;
+	MapsParam.ParseIntoArray(Maps, TEXT(","));
+
+	int32 NumFailed = 0;
+	for (const FString& Map : Maps)
+	{
+		if (!BakeMap(Map))
+			NumFailed++;
+	}
+
+	return NumFailed == 0 ? 0 : 1;
+}
+
+void ULedgeBakeCommandlet::GatherLevelLedges(ULevel* Level, TArray<FLedgeSegment>& OutSegments) const
+{
+	for (AActor* Actor : Level->Actors)
+	{
+		if (!Actor)
+			continue;
+
+		//The world isn't running, so make sure the component transforms are up to date
+		if (USceneComponent* Root = Actor->GetRootComponent())
+			Root->UpdateComponentToWorld();
+
+		TInlineComponentArray<UStaticMeshComponent*> Meshes(Actor);
+		for (UStaticMeshComponent* Mesh : Meshes)
+		{
+			//Only static meshes that block the climbing traces can be baked, everything else is traced at runtime
+			if (Mesh->Mobility != EComponentMobility::Static || Mesh->GetCollisionEnabled() == ECollisionEnabled::NoCollision
+				|| Mesh->GetCollisionResponseToChannel(ECC_Visibility) != ECR_Block)
+				continue;
+
+			UStaticMesh* StaticMesh = Mesh->GetStaticMesh();
+			UBodySetup* BodySetup = StaticMesh ? StaticMesh->GetBodySetup() : nullptr;
+			if (!BodySetup)
+				continue;
+
+			//Instanced meshes, like the clusters of the blockout, give the ledges of every instance
+			TArray<FTransform, TInlineAllocator<1>> Transforms;
+			if (const UInstancedStaticMeshComponent* Instances = Cast<UInstancedStaticMeshComponent>(Mesh))
+			{
+				for (int32 Index = 0; Index < Instances->GetInstanceCount(); Index++)
+					Instances->GetInstanceTransform(Index, Transforms.AddDefaulted_GetRef(), true);
+			}
+			else
+			{
+				Transforms.Add(Mesh->GetComponentTransform());
+			}
+
+			//Every simple box collision gives a ledge on each of its sides
+			for (const FTransform& Transform : Transforms)
+			{
+				for (const FKBoxElem& Box : BodySetup->AggGeom.BoxElems)
+				{
+					const FVector HalfSize(Box.X * 0.5f, Box.Y * 0.5f, Box.Z * 0.5f);
+					ULedgeDataAsset::AddBoxLedges(Box.GetTransform() * Transform, FBox(-HalfSize, HalfSize), OutSegments);
+				}
+			}
+		}
+	}
+}
+
+bool ULedgeBakeCommandlet::BakeMap(const FString& MapPackageName) const
+{
+	UPackage* MapPackage = LoadPackage(nullptr, *MapPackageName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogSkylineShredder, Error, TEXT("LedgeBake: could not load map %s"), *MapPackageName);
+		return false;
+	}
+
+	TArray<FLedgeSegment> Segments;
+	GatherLevelLedges(World->PersistentLevel, Segments);
+
+	//Streamed sublevels are baked into the same dataset as their persistent level
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		UPackage* LevelPackage = StreamingLevel ? LoadPackage(nullptr, *StreamingLevel->GetWorldAssetPackageName(), LOAD_None) : nullptr;
+		UWorld* LevelWorld = LevelPackage ? UWorld::FindWorldInPackage(LevelPackage) : nullptr;
+		if (LevelWorld)
+			GatherLevelLedges(LevelWorld->PersistentLevel, Segments);
+	}
+
+	const int32 NumSegments = Segments.Num();
+
+	//Create or replace the dataset next to the map
+	const FString ObjectPath = ULedgeSubsystem::GetLedgeDataPath(MapPackageName);
+	const FString PackageName = FPackageName::ObjectPathToPackageName(ObjectPath);
+	UPackage* Package = CreatePackage(*PackageName);
+	Package->FullyLoad();
+
+	const FString AssetName = FPackageName::ObjectPathToObjectName(ObjectPath);
+	ULedgeDataAsset* LedgeData = FindObject<ULedgeDataAsset>(Package, *AssetName);
+	if (!LedgeData)
+		LedgeData = NewObject<ULedgeDataAsset>(Package, *AssetName, RF_Public | RF_Standalone);
+
+	LedgeData->Build(MoveTemp(Segments));
+	Package->MarkPackageDirty();
+
+	bool bSaved = false;
+#if WITH_EDITOR
+	const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	bSaved = UPackage::SavePackage(Package, LedgeData, *Filename, SaveArgs);
+#endif
+
+	UE_LOG(LogSkylineShredder, Display, TEXT("LedgeBake: %s has %d ledges, %s %s"), *MapPackageName, NumSegments,
+		bSaved ? TEXT("saved") : TEXT("failed to save"), *PackageName);
+	return bSaved;
+}
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "LedgeBakeCommandlet.generated.h"
+
+/// <summary>
+/// Bakes the ledge dataset for each map from its static geometry.
+/// Usage: UnrealEditor-Cmd SkylineShredder.uproject -run=LedgeBake [-Maps=/Game/Maps/A,/Game/Maps/B]
+/// </summary>
+UCLASS()
+class ULedgeBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	ULedgeBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/// <summary>
+	/// Adds the ledges of every static, climbable box collision in the level
+	/// </summary>
+	void GatherLevelLedges(class ULevel* Level, TArray<struct FLedgeSegment>& OutSegments) const;
+
+	/// <summary>
+	/// Bakes and saves the ledge dataset for one map
+	/// </summary>
+	/// <returns>true if the dataset was saved</returns>
+	bool BakeMap(const FString& MapPackageName) const;
+};
@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeDataAsset.h"
+#include "SkylineShredder.h"
+#include "Algo/BinarySearch.h"
+
+//Bump this whenever the layout of the dataset changes so old bakes are thrown away
+static const int32 LedgeDataVersion = 1;
+
+//Reads past a bulk serialized array without knowing what its elements were, so the rest of the
+//package still lines up when a dataset of another version is thrown away
+static void SkipBulkArray(FArchive& Ar)
+{
+	int32 ElementSize = 0;
+	int32 Num = 0;
+	Ar << ElementSize << Num;
+
+	const int64 NumBytes = (int64)ElementSize * Num;
+	if (ElementSize < 0 || Num < 0 || (Ar.TotalSize() >= 0 && NumBytes > Ar.TotalSize() - Ar.Tell()))
+	{
+		Ar.SetError();
+		return;
+	}
+
+	TArray<uint8> Bytes;
+	Bytes.SetNumUninitialized(NumBytes);
+	Ar.Serialize(Bytes.GetData(), NumBytes);
+}
+
+void ULedgeDataAsset::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	int32 Version = LedgeDataVersion;
+	Ar << Version;
+
+	if (Ar.IsLoading() && Version != LedgeDataVersion)
+	{
+		Segments.Empty();
+		CellKeys.Empty();
+		CellStarts.Empty();
+		SegmentIndices.Empty();
+
+		//The four arrays are still in the package, read past them so the serial size matches
+		for (int32 Array = 0; Array < 4 && !Ar.IsError(); Array++)
+			SkipBulkArray(Ar);
+		return;
+	}
+
+	Segments.BulkSerialize(Ar);
+	CellKeys.BulkSerialize(Ar);
+	CellStarts.BulkSerialize(Ar);
+	SegmentIndices.BulkSerialize(Ar);
+}
+
+uint32 ULedgeDataAsset::GetCellKey(int32 X, int32 Y)
+{
+	return ((uint32)(uint16)X << 16) | (uint32)(uint16)Y;
+}
+
+FIntPoint ULedgeDataAsset::GetCell(float X, float Y)
+{
+	return FIntPoint(FMath::FloorToInt(X / CellSize), FMath::FloorToInt(Y / CellSize));
+}
+
+void ULedgeDataAsset::Build(TArray<FLedgeSegment>&& InSegments)
+{
+	Segments = MoveTemp(InSegments);
+
+	//Put every segment in each cell its bounds touch
+	TArray<TPair<uint32, uint32>> Entries;
+	for (int32 Index = 0; Index < Segments.Num(); Index++)
+	{
+		const FLedgeSegment& Segment = Segments[Index];
+		const FIntPoint Min = GetCell(FMath::Min(Segment.Start.X, Segment.End.X), FMath::Min(Segment.Start.Y, Segment.End.Y));
+		const FIntPoint Max = GetCell(FMath::Max(Segment.Start.X, Segment.End.X), FMath::Max(Segment.Start.Y, Segment.End.Y));
+
+		for (int32 X = Min.X; X <= Max.X; X++)
+		{
+			for (int32 Y = Min.Y; Y <= Max.Y; Y++)
+				Entries.Add(TPair<uint32, uint32>(GetCellKey(X, Y), Index));
+		}
+	}
+
+	Entries.Sort([](const TPair<uint32, uint32>& A, const TPair<uint32, uint32>& B)
+	{
+		return A.Key < B.Key || (A.Key == B.Key && A.Value < B.Value);
+	});
+
+	//Flatten the sorted entries into the cell arrays
+	CellKeys.Reset();
+	CellStarts.Reset();
+	SegmentIndices.Reset(Entries.Num());
+	for (const TPair<uint32, uint32>& Entry : Entries)
+	{
+		if (CellKeys.Num() == 0 || CellKeys.Last() != Entry.Key)
+		{
+			CellKeys.Add(Entry.Key);
+			CellStarts.Add(SegmentIndices.Num());
+		}
+		SegmentIndices.Add(Entry.Value);
+	}
+	CellStarts.Add(SegmentIndices.Num());
+}
+
+void ULedgeDataAsset::AddBoxLedges(const FTransform& Transform, const FBox& LocalBox, TArray<FLedgeSegment>& OutSegments)
+{
+	//Only upright boxes have ledges that can be climbed
+	if (!LocalBox.IsValid || Transform.GetUnitAxis(EAxis::Z).Z < 0.99f)
+		return;
+
+	const FVector Min = LocalBox.Min;
+	const FVector Max = LocalBox.Max;
+	const float TopZ = Transform.TransformPosition(FVector(Min.X, Min.Y, Max.Z)).Z;
+	const float BottomZ = Transform.TransformPosition(FVector(Min.X, Min.Y, Min.Z)).Z;
+	const float SizeX = Transform.TransformVector(FVector(Max.X - Min.X, 0.0f, 0.0f)).Size();
+	const float SizeY = Transform.TransformVector(FVector(0.0f, Max.Y - Min.Y, 0.0f)).Size();
+
+	//The four corners of the top face and the faces between them, with the face normal and the thickness behind it
+	const FVector Corners[4] =
+	{
+		Transform.TransformPosition(FVector(Max.X, Min.Y, Max.Z)),
+		Transform.TransformPosition(FVector(Max.X, Max.Y, Max.Z)),
+		Transform.TransformPosition(FVector(Min.X, Max.Y, Max.Z)),
+		Transform.TransformPosition(FVector(Min.X, Min.Y, Max.Z)),
+	};
+	const FVector Normals[4] =
+	{
+		Transform.GetUnitAxis(EAxis::X),
+		Transform.GetUnitAxis(EAxis::Y),
+		-Transform.GetUnitAxis(EAxis::X),
+		-Transform.GetUnitAxis(EAxis::Y),
+	};
+	const float Thicknesses[4] = { SizeX, SizeY, SizeX, SizeY };
+
+	for (int32 Side = 0; Side < 4; Side++)
+	{
+		const FVector& Start = Corners[Side];
+		const FVector& End = Corners[(Side + 1) % 4];
+
+		//Skip slivers that are too small to stand on
+		if (FVector::DistSquared2D(Start, End) < FMath::Square(10.0f) || Thicknesses[Side] < 1.0f)
+			continue;
+
+		FLedgeSegment Segment;
+		Segment.Start = FVector3f(Start.X, Start.Y, TopZ);
+		Segment.End = FVector3f(End.X, End.Y, TopZ);
+		Segment.Normal = FVector2f(Normals[Side].X, Normals[Side].Y).GetSafeNormal();
+		Segment.BottomZ = BottomZ;
+		Segment.Thickness = Thicknesses[Side];
+		OutSegments.Add(Segment);
+	}
+}
+
+bool ULedgeDataAsset::FindLedge(const FVector& Start, const FVector& Forward, float Length, FLedgeHit& OutHit) const
+{
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourFindLedge);
+
+	const FVector2f RayStart(Start.X, Start.Y);
+	const FVector2f RayDelta(Forward.X * Length, Forward.Y * Length);
+	const FVector End = Start + Forward * Length;
+
+	const FIntPoint MinCell = GetCell(FMath::Min(Start.X, End.X), FMath::Min(Start.Y, End.Y));
+	const FIntPoint MaxCell = GetCell(FMath::Max(Start.X, End.X), FMath::Max(Start.Y, End.Y));
+
+	float BestTime = 1.0f;
+	int32 BestIndex = INDEX_NONE;
+
+	for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			//Binary search the sorted keys for the cell
+			const int32 CellIndex = Algo::BinarySearch(CellKeys, GetCellKey(X, Y));
+			if (CellIndex == INDEX_NONE)
+				continue;
+
+			for (uint32 Entry = CellStarts[CellIndex]; Entry < CellStarts[CellIndex + 1]; Entry++)
+			{
+				const int32 Index = SegmentIndices[Entry];
+				const FLedgeSegment& Segment = Segments[Index];
+
+				//The wall must cover the height of the ray and face the ray
+				if (Start.Z < Segment.BottomZ || Start.Z > Segment.Start.Z)
+					continue;
+				if (FVector2f::DotProduct(RayDelta, Segment.Normal) >= 0.0f)
+					continue;
+
+				//Intersect the ray with the edge on the XY plane
+				const FVector2f EdgeStart(Segment.Start.X, Segment.Start.Y);
+				const FVector2f EdgeDelta(Segment.End.X - Segment.Start.X, Segment.End.Y - Segment.Start.Y);
+				const float Denominator = FVector2f::CrossProduct(RayDelta, EdgeDelta);
+				if (FMath::IsNearlyZero(Denominator))
+					continue;
+
+				const FVector2f ToEdge = EdgeStart - RayStart;
+				const float Time = FVector2f::CrossProduct(ToEdge, EdgeDelta) / Denominator;
+				const float EdgeTime = FVector2f::CrossProduct(ToEdge, RayDelta) / Denominator;
+				if (Time < 0.0f || Time > BestTime || EdgeTime < 0.0f || EdgeTime > 1.0f)
+					continue;
+
+				BestTime = Time;
+				BestIndex = Index;
+			}
+		}
+	}
+
+	if (BestIndex == INDEX_NONE)
+		return false;
+
+	const FLedgeSegment& Best = Segments[BestIndex];
+	OutHit.WallLocation = Start + Forward * Length * BestTime;
+	OutHit.WallNormal = FVector(Best.Normal.X, Best.Normal.Y, 0.0f);
+	OutHit.TopZ = Best.Start.Z;
+	OutHit.BottomZ = Best.BottomZ;
+	OutHit.Thickness = Best.Thickness;
+	return true;
+}
@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "LedgeDataAsset.generated.h"
+
+//The top edge of one side of a wall, baked from static geometry
+struct FLedgeSegment
+{
+	//The top edge of the wall face
+	FVector3f Start;
+	FVector3f End;
+	//The horizontal direction the face points in
+	FVector2f Normal;
+	//The height of the bottom of the wall and how thick it is behind the face
+	float BottomZ;
+	float Thickness;
+
+	friend FArchive& operator<<(FArchive& Ar, FLedgeSegment& Segment)
+	{
+		Ar << Segment.Start << Segment.End << Segment.Normal << Segment.BottomZ << Segment.Thickness;
+		return Ar;
+	}
+};
+
+template<> struct TCanBulkSerialize<FLedgeSegment> { enum { Value = true }; };
+
+//A wall found by a ledge lookup, matching what the climbing traces would have found
+struct FLedgeHit
+{
+	FVector WallLocation;
+	FVector WallNormal;
+	float TopZ;
+	float BottomZ;
+	float Thickness;
+};
+
+/// <summary>
+/// Flat ledge dataset for a level, baked by the LedgeBake commandlet. The segments and the grid
+/// over them are plain arrays that are bulk serialized, so loading is a straight copy. Nothing
+/// references a dataset, it is only found by its path, so it is a primary asset the asset manager
+/// always cooks, see DefaultGame.ini
+/// </summary>
+UCLASS()
+class SKYLINESHREDDER_API ULedgeDataAsset : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Serialize(FArchive& Ar) override;
+
+	/// <summary>
+	/// Replaces the dataset with the given segments and rebuilds the grid over them
+	/// </summary>
+	void Build(TArray<FLedgeSegment>&& InSegments);
+
+	/// <summary>
+	/// Adds a ledge for each side of an upright box, used when baking static meshes
+	/// </summary>
+	/// <param name="Transform">the transform of the box</param>
+	/// <param name="LocalBox">the box in local space</param>
+	/// <param name="OutSegments">the list to add the ledges to</param>
+	static void AddBoxLedges(const FTransform& Transform, const FBox& LocalBox, TArray<FLedgeSegment>& OutSegments);
+
+	/// <summary>
+	/// Finds the closest wall face a horizontal ray hits from the front
+	/// </summary>
+	/// <param name="Start">start of the ray</param>
+	/// <param name="Forward">direction of the ray</param>
+	/// <param name="Length">length of the ray</param>
+	/// <param name="OutHit">the wall that was hit</param>
+	/// <returns>true if a wall was hit</returns>
+	bool FindLedge(const FVector& Start, const FVector& Forward, float Length, FLedgeHit& OutHit) const;
+
+	int32 GetNumSegments() const { return Segments.Num(); }
+
+	//The size of a grid cell on the XY plane
+	static constexpr float CellSize = 500.0f;
+
+private:
+	TArray<FLedgeSegment> Segments;
+
+	//The grid is stored as sorted cell keys, where each cell's segments start in SegmentIndices
+	TArray<uint32> CellKeys;
+	TArray<uint32> CellStarts;
+	TArray<uint32> SegmentIndices;
+
+	static uint32 GetCellKey(int32 X, int32 Y);
+	static FIntPoint GetCell(float X, float Y);
+};
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LedgeSubsystem.h"
+#include "Engine/World.h"
+#include "Misc/PackageName.h"
+
+void ULedgeSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//Load the dataset baked for this map, if there is one climbing just uses traces
+	const FString MapPackageName = UWorld::RemovePIEPrefix(InWorld.GetOutermost()->GetName());
+	const FString LedgeDataPath = GetLedgeDataPath(MapPackageName);
+	if (FPackageName::DoesPackageExist(FPackageName::ObjectPathToPackageName(LedgeDataPath)))
+		LedgeData = LoadObject<ULedgeDataAsset>(nullptr, *LedgeDataPath);
+}
+
+FString ULedgeSubsystem::GetLedgeDataPath(const FString& MapPackageName)
+{
+	const FString AssetName = FPackageName::GetShortName(MapPackageName) + TEXT("_Ledges");
+	return FPackageName::GetLongPackagePath(MapPackageName) / AssetName + TEXT(".") + AssetName;
+}
+
+bool ULedgeSubsystem::FindLedge(const FVector& Start, const FVector& Forward, float Length, FLedgeHit& OutHit) const
+{
+	return LedgeData && LedgeData->FindLedge(Start, Forward, Length, OutHit);
+}
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LedgeDataAsset.h"
+#include "LedgeSubsystem.generated.h"
+
+/// <summary>
+/// Loads the baked ledge dataset for the current level so climbing and vaulting can look
+/// up static walls instead of tracing for them. The dataset for a map lives next to it as
+/// <MapName>_Ledges and is made by the LedgeBake commandlet
+/// </summary>
+UCLASS()
+class SKYLINESHREDDER_API ULedgeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/// <summary>
+	/// Finds the closest baked wall a horizontal ray hits from the front
+	/// </summary>
+	/// <returns>true if a baked wall was hit</returns>
+	bool FindLedge(const FVector& Start, const FVector& Forward, float Length, FLedgeHit& OutHit) const;
+
+	/// <summary>
+	/// Gets the object path the ledge dataset for a map is saved at
+	/// </summary>
+	/// <param name="MapPackageName">the long package name of the map</param>
+	static FString GetLedgeDataPath(const FString& MapPackageName);
+
+private:
+	UPROPERTY()
+	ULedgeDataAsset* LedgeData;
+};
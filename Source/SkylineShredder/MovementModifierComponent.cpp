@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MovementModifierComponent.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+
+// Sets default values for this component's properties
+UMovementModifierComponent::UMovementModifierComponent()
+{
+	//Only ticks while there are timed modifiers to remove
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	Aggregates[(int32)EMovementModifierAttribute::Impulse].Base = 1.0f;
+}
+
+// Called when the game starts
+void UMovementModifierComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//Start from whatever the movement is set to
+	if (ACharacter* Character = Cast<ACharacter>(GetOwner()))
+		CharacterMovement = Character->GetCharacterMovement();
+
+	if (CharacterMovement)
+	{
+		Aggregates[(int32)EMovementModifierAttribute::Speed].Base = CharacterMovement->MaxWalkSpeed;
+		Aggregates[(int32)EMovementModifierAttribute::Gravity].Base = CharacterMovement->GravityScale;
+	}
+}
+
+void UMovementModifierComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (Now < NextExpireTime)
+		return;
+
+	for (int32 Index = Modifiers.Num() - 1; Index >= 0; Index--)
+	{
+		if (Modifiers[Index].ExpireTime > 0.0f && Modifiers[Index].ExpireTime <= Now)
+			RemoveModifierAt(Index);
+	}
+
+	UpdateExpiry();
+}
+
+int32 UMovementModifierComponent::AddModifier(EMovementModifierAttribute Attribute, EMovementModifierOp Op, float Value, float Duration, const UObject* Source)
+{
+	if (Attribute >= EMovementModifierAttribute::Count)
+		return 0;
+
+	FMovementModifier& Modifier = Modifiers.AddDefaulted_GetRef();
+	Modifier.Id = NextModifierId++;
+	Modifier.Attribute = Attribute;
+	Modifier.Op = Op;
+	Modifier.Value = Value;
+	Modifier.ExpireTime = Duration > 0.0f ? GetWorld()->GetTimeSeconds() + Duration : 0.0f;
+	Modifier.Source = Source;
+
+	ApplyModifier(Modifier, true);
+
+	if (Modifier.ExpireTime > 0.0f)
+	{
+		NextExpireTime = NumTimedModifiers == 0 ? Modifier.ExpireTime : FMath::Min(NextExpireTime, Modifier.ExpireTime);
+		NumTimedModifiers++;
+		SetComponentTickEnabled(true);
+	}
+
+	return Modifier.Id;
+}
+
+bool UMovementModifierComponent::RemoveModifier(int32 ModifierId)
+{
+	const int32 Index = Modifiers.IndexOfByPredicate([ModifierId](const FMovementModifier& Modifier) { return Modifier.Id == ModifierId; });
+	if (Index == INDEX_NONE)
+		return false;
+
+	RemoveModifierAt(Index);
+	UpdateExpiry();
+	return true;
+}
+
+void UMovementModifierComponent::RemoveModifiersFromSource(const UObject* Source)
+{
+	const TObjectKey<UObject> SourceKey(Source);
+	for (int32 Index = Modifiers.Num() - 1; Index >= 0; Index--)
+	{
+		if (Modifiers[Index].Source == SourceKey)
+			RemoveModifierAt(Index);
+	}
+
+	UpdateExpiry();
+}
+
+bool UMovementModifierComponent::HasModifierFromSource(const UObject* Source) const
+{
+	const TObjectKey<UObject> SourceKey(Source);
+	return Modifiers.ContainsByPredicate([&SourceKey](const FMovementModifier& Modifier) { return Modifier.Source == SourceKey; });
+}
+
+float UMovementModifierComponent::GetValue(EMovementModifierAttribute Attribute) const
+{
+	return Attribute < EMovementModifierAttribute::Count ? Aggregates[(int32)Attribute].Resolve() : 0.0f;
+}
+
+void UMovementModifierComponent::SetBaseValue(EMovementModifierAttribute Attribute, float Value)
+{
+	if (Attribute >= EMovementModifierAttribute::Count)
+		return;
+
+	Aggregates[(int32)Attribute].Base = Value;
+	PushAttribute(Attribute);
+}
+
+void UMovementModifierComponent::AddImpulse(const FVector& Impulse, bool bVelocityChange)
+{
+	if (CharacterMovement)
+		CharacterMovement->AddImpulse(Impulse * GetValue(EMovementModifierAttribute::Impulse), bVelocityChange);
+}
+
+void UMovementModifierComponent::ApplyModifier(const FMovementModifier& Modifier, bool bAdd)
+{
+	FAggregate& Aggregate = Aggregates[(int32)Modifier.Attribute];
+
+	if (Modifier.Op == EMovementModifierOp::Additive)
+	{
+		Aggregate.NumAdd += bAdd ? 1 : -1;
+		Aggregate.Add += bAdd ? Modifier.Value : -Modifier.Value;
+
+		//Start the sum again once it is empty so rounding doesn't build up
+		if (Aggregate.NumAdd == 0)
+			Aggregate.Add = 0.0f;
+	}
+	else
+	{
+		Aggregate.NumMul += bAdd ? 1 : -1;
+
+		if (Modifier.Value == 0.0f)
+			Aggregate.NumZeroMul += bAdd ? 1 : -1;
+		else
+			Aggregate.Mul = bAdd ? Aggregate.Mul * Modifier.Value : Aggregate.Mul / Modifier.Value;
+
+		//Same for the product
+		if (Aggregate.NumMul == 0)
+			Aggregate.Mul = 1.0f;
+	}
+
+	PushAttribute(Modifier.Attribute);
+}
+
+void UMovementModifierComponent::RemoveModifierAt(int32 Index)
+{
+	const FMovementModifier Modifier = Modifiers[Index];
+	Modifiers.RemoveAtSwap(Index);
+
+	if (Modifier.ExpireTime > 0.0f)
+		NumTimedModifiers--;
+
+	ApplyModifier(Modifier, false);
+}
+
+void UMovementModifierComponent::UpdateExpiry()
+{
+	if (NumTimedModifiers == 0)
+	{
+		SetComponentTickEnabled(false);
+		return;
+	}
+
+	NextExpireTime = TNumericLimits<float>::Max();
+	for (const FMovementModifier& Modifier : Modifiers)
+	{
+		if (Modifier.ExpireTime > 0.0f)
+			NextExpireTime = FMath::Min(NextExpireTime, Modifier.ExpireTime);
+	}
+}
+
+void UMovementModifierComponent::PushAttribute(EMovementModifierAttribute Attribute)
+{
+	FAggregate& Aggregate = Aggregates[(int32)Attribute];
+	const float Value = Aggregate.Resolve();
+
+	//Only write to the movement when the value changes
+	if (!CharacterMovement || (Aggregate.bHasPushed && Aggregate.Pushed == Value))
+		return;
+
+	switch (Attribute)
+	{
+	case EMovementModifierAttribute::Speed:
+		CharacterMovement->MaxWalkSpeed = Value;
+		break;
+	case EMovementModifierAttribute::Gravity:
+		CharacterMovement->GravityScale = Value;
+		break;
+	default:
+		//Impulses are scaled when they are added
+		return;
+	}
+
+	Aggregate.Pushed = Value;
+	Aggregate.bHasPushed = true;
+}
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "MovementModifierComponent.generated.h"
+
+//The movement values a modifier can change
+UENUM(BlueprintType)
+enum class EMovementModifierAttribute : uint8
+{
+	Speed,
+	Gravity,
+	Impulse,
+	Count UMETA(Hidden)
+};
+
+//How a modifier is combined with the base value, the result is (base + additive) * multiplicative
+UENUM(BlueprintType)
+enum class EMovementModifierOp : uint8
+{
+	Additive,
+	Multiplicative
+};
+
+/// <summary>
+/// Stack of timed speed, gravity and impulse modifiers on a character. Anything can push a modifier,
+/// the totals are kept up to date as modifiers come and go so reading them is constant time, and the
+/// character movement is only written to when a total actually changes.
+/// </summary>
+UCLASS(ClassGroup = (Custom), meta = (BlueprintSpawnableComponent))
+class SKYLINESHREDDER_API UMovementModifierComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	UMovementModifierComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/// <summary>
+	/// Pushes a modifier onto the stack
+	/// </summary>
+	/// <param name="Attribute">the value to modify</param>
+	/// <param name="Op">if the modifier is added to or multiplies the value</param>
+	/// <param name="Value">the amount to add or multiply by</param>
+	/// <param name="Duration">seconds until the modifier is removed, 0 keeps it until it is removed</param>
+	/// <param name="Source">the object the modifier came from, used to find or remove it later</param>
+	/// <returns>the id of the modifier</returns>
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	int32 AddModifier(EMovementModifierAttribute Attribute, EMovementModifierOp Op, float Value, float Duration = 0.0f, const UObject* Source = nullptr);
+
+	/// <summary>
+	/// Removes a modifier from the stack
+	/// </summary>
+	/// <returns>true if the modifier was still on the stack</returns>
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool RemoveModifier(int32 ModifierId);
+
+	/// <summary>
+	/// Removes every modifier pushed by a source
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	void RemoveModifiersFromSource(const UObject* Source);
+
+	/// <summary>
+	/// Checks if a source has a modifier on the stack
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool HasModifierFromSource(const UObject* Source) const;
+
+	/// <summary>
+	/// Gets a value with every modifier applied
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	float GetValue(EMovementModifierAttribute Attribute) const;
+
+	/// <summary>
+	/// Sets the value the modifiers are applied to, the movement is updated if the result changes
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	void SetBaseValue(EMovementModifierAttribute Attribute, float Value);
+
+	void SetBaseSpeed(float Speed) { SetBaseValue(EMovementModifierAttribute::Speed, Speed); }
+	void SetBaseGravityScale(float GravityScale) { SetBaseValue(EMovementModifierAttribute::Gravity, GravityScale); }
+
+	/// <summary>
+	/// Adds an impulse to the character scaled by the impulse modifiers
+	/// </summary>
+	void AddImpulse(const FVector& Impulse, bool bVelocityChange = false);
+
+protected:
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+private:
+	struct FMovementModifier
+	{
+		int32 Id;
+		EMovementModifierAttribute Attribute;
+		EMovementModifierOp Op;
+		float Value;
+		//World time the modifier is removed at, 0 for never
+		float ExpireTime;
+		TObjectKey<UObject> Source;
+	};
+
+	//Running totals for one attribute, multipliers of 0 are counted so the product can be divided back out
+	struct FAggregate
+	{
+		float Base = 0.0f;
+		float Add = 0.0f;
+		float Mul = 1.0f;
+		int32 NumAdd = 0;
+		int32 NumMul = 0;
+		int32 NumZeroMul = 0;
+		//The value last written to the character movement
+		float Pushed = 0.0f;
+		bool bHasPushed = false;
+
+		float Resolve() const { return NumZeroMul > 0 ? 0.0f : (Base + Add) * Mul; }
+	};
+
+	TArray<FMovementModifier> Modifiers;
+	FAggregate Aggregates[(int32)EMovementModifierAttribute::Count];
+	int32 NextModifierId = 1;
+	int32 NumTimedModifiers = 0;
+	float NextExpireTime = 0.0f;
+
+	UPROPERTY()
+	class UCharacterMovementComponent* CharacterMovement;
+
+	void ApplyModifier(const FMovementModifier& Modifier, bool bAdd);
+	void RemoveModifierAt(int32 Index);
+	void UpdateExpiry();
+	void PushAttribute(EMovementModifierAttribute Attribute);
+};
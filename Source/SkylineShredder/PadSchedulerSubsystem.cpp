@@ -0,0 +1,149 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PadSchedulerSubsystem.h"
+#include "SkylineShredder.h"
+
+UPadSchedulerSubsystem::UPadSchedulerSubsystem()
+{
+	for (int32& Head : SlotHeads)
+		Head = INDEX_NONE;
+}
+
+void UPadSchedulerSubsystem::Deinitialize()
+{
+	Timers.Empty();
+	for (int32& Head : SlotHeads)
+		Head = INDEX_NONE;
+	FreeHead = INDEX_NONE;
+	NumActiveTimers = 0;
+
+	Super::Deinitialize();
+}
+
+TStatId UPadSchedulerSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPadSchedulerSubsystem, STATGROUP_Parkour);
+}
+
+FPadTimerHandle UPadSchedulerSubsystem::SetTimer(float Delay, FSimpleDelegate OnExpired)
+{
+	//Reuse a free timer if there is one so the array stays packed
+	int32 Index = FreeHead;
+	if (Index != INDEX_NONE)
+		FreeHead = Timers[Index].Next;
+	else
+		Index = Timers.AddDefaulted();
+
+	//Part of the next wheel tick has already gone by
+	const int32 DelayTicks = FMath::Max(1, FMath::CeilToInt((Delay + TickRemainder) / WheelResolution));
+
+	FPadTimer& Timer = Timers[Index];
+	Timer.OnExpired = MoveTemp(OnExpired);
+	Timer.ExpireTick = CurrentTick + DelayTicks;
+	Timer.Serial++;
+	Timer.bActive = true;
+	LinkTimer(Index);
+	NumActiveTimers++;
+
+	FPadTimerHandle Handle;
+	Handle.Index = Index;
+	Handle.Serial = Timer.Serial;
+	return Handle;
+}
+
+void UPadSchedulerSubsystem::ClearTimer(FPadTimerHandle& Handle)
+{
+	if (IsTimerActive(Handle))
+	{
+		UnlinkTimer(Handle.Index);
+		ReleaseTimer(Handle.Index);
+	}
+
+	Handle.Invalidate();
+}
+
+bool UPadSchedulerSubsystem::IsTimerActive(const FPadTimerHandle& Handle) const
+{
+	return Timers.IsValidIndex(Handle.Index) && Timers[Handle.Index].bActive && Timers[Handle.Index].Serial == Handle.Serial;
+}
+
+void UPadSchedulerSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TickRemainder += DeltaTime;
+	const int32 NumTicks = FMath::FloorToInt(TickRemainder / WheelResolution);
+	if (NumTicks == 0)
+		return;
+
+	TickRemainder -= NumTicks * WheelResolution;
+	const uint64 FirstTick = CurrentTick + 1;
+	CurrentTick += NumTicks;
+
+	//Pull every expired timer off the wheel before calling anything, the delegates are free to set new timers.
+	//A long frame covers at most one turn of the wheel since every slot is visited once.
+	TArray<FSimpleDelegate, TInlineAllocator<16>> Expired;
+	const uint64 LastSlotTick = FMath::Min<uint64>(CurrentTick, FirstTick + NumWheelSlots - 1);
+	for (uint64 SlotTick = FirstTick; SlotTick <= LastSlotTick; SlotTick++)
+	{
+		int32 Index = SlotHeads[SlotTick % NumWheelSlots];
+		while (Index != INDEX_NONE)
+		{
+			FPadTimer& Timer = Timers[Index];
+			const int32 Next = Timer.Next;
+
+			//Timers more than a turn away stay in the slot until their turn comes round
+			if (Timer.ExpireTick <= CurrentTick)
+			{
+				Expired.Add(MoveTemp(Timer.OnExpired));
+				UnlinkTimer(Index);
+				ReleaseTimer(Index);
+			}
+
+			Index = Next;
+		}
+	}
+
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourPadCallbacks);
+	for (FSimpleDelegate& OnExpired : Expired)
+		OnExpired.ExecuteIfBound();
+}
+
+void UPadSchedulerSubsystem::LinkTimer(int32 Index)
+{
+	FPadTimer& Timer = Timers[Index];
+	int32& Head = SlotHeads[Timer.ExpireTick % NumWheelSlots];
+
+	Timer.Prev = INDEX_NONE;
+	Timer.Next = Head;
+	if (Head != INDEX_NONE)
+		Timers[Head].Prev = Index;
+	Head = Index;
+}
+
+void UPadSchedulerSubsystem::UnlinkTimer(int32 Index)
+{
+	FPadTimer& Timer = Timers[Index];
+
+	if (Timer.Prev != INDEX_NONE)
+		Timers[Timer.Prev].Next = Timer.Next;
+	else
+		SlotHeads[Timer.ExpireTick % NumWheelSlots] = Timer.Next;
+
+	if (Timer.Next != INDEX_NONE)
+		Timers[Timer.Next].Prev = Timer.Prev;
+
+	Timer.Prev = INDEX_NONE;
+	Timer.Next = INDEX_NONE;
+}
+
+void UPadSchedulerSubsystem::ReleaseTimer(int32 Index)
+{
+	FPadTimer& Timer = Timers[Index];
+	Timer.OnExpired.Unbind();
+	Timer.bActive = false;
+	Timer.Next = FreeHead;
+	FreeHead = Index;
+	NumActiveTimers--;
+}
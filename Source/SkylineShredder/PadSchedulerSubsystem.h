@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PadSchedulerSubsystem.generated.h"
+
+//Identifies a timer set on the pad scheduler, stays safe to use after the timer has finished
+struct FPadTimerHandle
+{
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; }
+};
+
+/// <summary>
+/// Runs the cooldowns and timed effects of every pad in the world, so pads don't have to tick.
+/// Timers live in one packed array and are expired with a hashed timer wheel, and the
+/// subsystem only ticks while at least one timer is running.
+/// </summary>
+UCLASS()
+class SKYLINESHREDDER_API UPadSchedulerSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	UPadSchedulerSubsystem();
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return NumActiveTimers > 0; }
+	virtual TStatId GetStatId() const override;
+
+	/// <summary>
+	/// Calls a delegate once after a delay
+	/// </summary>
+	/// <param name="Delay">seconds until the delegate is called, rounded up to the wheel resolution</param>
+	/// <param name="OnExpired">the delegate to call</param>
+	/// <returns>handle used to clear or check the timer</returns>
+	FPadTimerHandle SetTimer(float Delay, FSimpleDelegate OnExpired);
+
+	/// <summary>
+	/// Stops a timer without calling its delegate and invalidates the handle
+	/// </summary>
+	void ClearTimer(FPadTimerHandle& Handle);
+
+	/// <summary>
+	/// Checks if a timer is still waiting to expire
+	/// </summary>
+	bool IsTimerActive(const FPadTimerHandle& Handle) const;
+
+	int32 GetNumActiveTimers() const { return NumActiveTimers; }
+
+	//The length of a wheel slot, timers expire on the first tick after their slot
+	static constexpr float WheelResolution = 1.0f / 60.0f;
+	//The number of wheel slots, timers further out than a turn of the wheel wait in their slot for extra turns
+	static constexpr int32 NumWheelSlots = 256;
+
+private:
+	struct FPadTimer
+	{
+		FSimpleDelegate OnExpired;
+		uint64 ExpireTick = 0;
+		uint32 Serial = 0;
+		//Links to the other timers in the same wheel slot, or the free list for unused timers
+		int32 Prev = INDEX_NONE;
+		int32 Next = INDEX_NONE;
+		bool bActive = false;
+	};
+
+	TArray<FPadTimer> Timers;
+	int32 SlotHeads[NumWheelSlots];
+	int32 FreeHead = INDEX_NONE;
+	int32 NumActiveTimers = 0;
+
+	//The wheel tick that was processed last, and the time that hasn't made up a whole tick yet
+	uint64 CurrentTick = 0;
+	float TickRemainder = 0.0f;
+
+	void LinkTimer(int32 Index);
+	void UnlinkTimer(int32 Index);
+	void ReleaseTimer(int32 Index);
+};
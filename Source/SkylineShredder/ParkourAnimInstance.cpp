@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ParkourAnimInstance.h"
+#include "SkylineShredderCharacter.h"
+#include "ParkourAnimSnapshot.h"
+
+void UParkourAnimInstance::NativeInitializeAnimation()
+{
+	Super::NativeInitializeAnimation();
+
+	Character = Cast<ASkylineShredderCharacter>(TryGetPawnOwner());
+}
+
+void UParkourAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
+
+	//The editor preview has no runner, keep the defaults
+	if (!Character)
+		return;
+
+	//A copy of the snapshot the character published at the end of its tick, nothing else on the character is touched here
+	const FParkourAnimSnapshot Snapshot = Character->GetAnimSnapshot();
+
+	ParkourState = Snapshot.State;
+	bIsWallRunning = Snapshot.State == EParkourState::WallRun;
+	bIsVaulting = Snapshot.State == EParkourState::Vault;
+	bIsClimbing = Snapshot.State == EParkourState::Climb;
+	bInAction = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_InAction);
+	bWallOnLeft = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_WallOnLeft);
+	bWallOnRight = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_WallOnRight);
+	bDoubleJumped = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_DoubleJumped);
+	bShouldPlayerClimb = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_ShouldClimb);
+	bIsFalling = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_Falling);
+	bIsOnGround = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_OnGround);
+	bHasMovementInput = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_HasMovementInput);
+	NumberOfJumps = Snapshot.NumberOfJumps;
+	GroundSpeed = Snapshot.GroundSpeed;
+	VerticalSpeed = Snapshot.VerticalSpeed;
+	Momentum = Snapshot.Momentum;
+	bGrappleAttached = Snapshot.HasFlag(FParkourAnimSnapshot::FLAG_GrappleAttached);
+	HookLocation = Snapshot.HookLocation;
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Animation/AnimInstance.h"
+#include "ParkourState.h"
+#include "ParkourAnimInstance.generated.h"
+
+class ASkylineShredderCharacter;
+
+/// <summary>
+/// The base class for the runner animation blueprints. Everything the anim graph reads is set here from the
+/// snapshot the character publishes each frame, in the thread safe update, so with multi threaded animation
+/// update turned on in the animation blueprint none of the animation update runs on the game thread.
+/// </summary>
+UCLASS(Transient, Blueprintable)
+class SKYLINESHREDDER_API UParkourAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+public:
+	virtual void NativeInitializeAnimation() override;
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
+protected:
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	EParkourState ParkourState = EParkourState::None;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bIsWallRunning = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bIsVaulting = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bIsClimbing = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bInAction = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bWallOnLeft = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bWallOnRight = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bDoubleJumped = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bShouldPlayerClimb = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bIsFalling = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bIsOnGround = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	bool bHasMovementInput = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	int32 NumberOfJumps = 0;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	float GroundSpeed = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	float VerticalSpeed = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Parkour")
+	float Momentum = 0.0f;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Grapple")
+	bool bGrappleAttached = false;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Grapple")
+	FVector HookLocation = FVector::ZeroVector;
+
+private:
+	//Set on the game thread when the animation is initialized, only the published snapshot is read through it after that
+	UPROPERTY(Transient)
+	ASkylineShredderCharacter* Character = nullptr;
+};
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ParkourState.h"
+
+//Everything the animation needs from a runner for one frame, copied out so the animation can be updated off the game thread
+struct SKYLINESHREDDER_API FParkourAnimSnapshot
+{
+	enum : uint16
+	{
+		FLAG_InAction = 1 << 0,
+		FLAG_WallOnLeft = 1 << 1,
+		FLAG_WallOnRight = 1 << 2,
+		FLAG_DoubleJumped = 1 << 3,
+		FLAG_GrappleAttached = 1 << 4,
+		FLAG_Falling = 1 << 5,
+		FLAG_OnGround = 1 << 6,
+		FLAG_ShouldClimb = 1 << 7,
+		FLAG_HasMovementInput = 1 << 8
+	};
+
+	uint16 Flags = 0;
+	EParkourState State = EParkourState::None;
+	uint8 NumberOfJumps = 0;
+
+	//Speed along the ground and up or down, in cm/s
+	float GroundSpeed = 0.0f;
+	float VerticalSpeed = 0.0f;
+	float Momentum = 0.0f;
+
+	FVector HookLocation = FVector::ZeroVector;
+
+	bool HasFlag(uint16 Flag) const { return (Flags & Flag) != 0; }
+};
+
+static_assert(std::is_trivially_copyable<FParkourAnimSnapshot>::value, "The animation snapshot is copied between threads, it can't own anything");
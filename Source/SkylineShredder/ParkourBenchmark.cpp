@@ -0,0 +1,401 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+//Measures how the parkour code scales with the number of runners. Spawns N bots, each on its own lane
+//with a boost pad, a wall to run on, a grapple point, a block to vault and a bounce pad, and drives them
+//with scripted input while sampling the game thread. Run it headless with
+//  UnrealEditor SkylineShredder.uproject /Game/Maps/CityBlockout_Level -game -nullrhi -unattended -ExecCmds="Parkour.LoadBenchmark 1,16,64,256 600 quit"
+//The results are written as CSV and JSON to Saved/Profiling/ParkourBenchmark.
+
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "BoostPad.h"
+#include "BouncePad.h"
+#include "GrapplePointSubsystem.h"
+#include "Components/BoxComponent.h"
+#include "Components/SphereComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Containers/Ticker.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/ArchiveCountMem.h"
+
+namespace ParkourLoadBenchmark
+{
+	//Where the lanes are built, well away from anything in the map
+	static const FVector CourseOrigin(0.0f, 0.0f, 100000.0f);
+	static const float LaneLength = 6000.0f;
+	static const float LaneSpacing = 1200.0f;
+	static const int32 LanesPerRow = 16;
+
+	//Where along a lane each route happens
+	static const float BoostPadX = 800.0f;
+	static const float JumpStartX = 1100.0f;
+	static const float JumpEndX = 1400.0f;
+	static const float WallStartX = 1500.0f;
+	static const float WallEndX = 3500.0f;
+	static const float GrappleStartX = 2600.0f;
+	static const float GrappleEndX = 3200.0f;
+	static const float GrappleHoldTime = 0.75f;
+	static const float VaultStartX = 3900.0f;
+	static const float VaultBlockX = 4200.0f;
+	static const float BouncePadX = 5200.0f;
+
+	static const int32 WarmupFrames = 60;
+
+	struct FBot
+	{
+		TWeakObjectPtr<ASkylineShredderCharacter> Character;
+		FVector LaneOrigin;
+		bool bJumpHeld = false;
+		float GrappleTime = 0.0f;
+	};
+
+	struct FResult
+	{
+		int32 NumBots = 0;
+		int32 NumFrames = 0;
+		double AverageGameThreadMs = 0.0;
+		double MaxGameThreadMs = 0.0;
+		double AverageFrameMs = 0.0;
+		double SceneQueriesPerFrame = 0.0;
+		double ProcessMemoryPerBotKB = 0.0;
+		double ObjectMemoryPerBotKB = 0.0;
+	};
+
+	class FLoadBenchmark : public TSharedFromThis<FLoadBenchmark>
+	{
+	public:
+		FLoadBenchmark(UWorld* InWorld, TArray<int32> InBotCounts, int32 InMeasureFrames, bool bInQuitWhenDone)
+			: World(InWorld), BotCounts(MoveTemp(InBotCounts)), MeasureFrames(InMeasureFrames), bQuitWhenDone(bInQuitWhenDone)
+		{
+		}
+
+		void Start()
+		{
+			//The ticker keeps the benchmark alive until it returns false
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([This = AsShared()](float DeltaTime)
+			{
+				return This->Tick(DeltaTime);
+			}));
+		}
+
+	private:
+		TWeakObjectPtr<UWorld> World;
+		TArray<int32> BotCounts;
+		int32 MeasureFrames;
+		bool bQuitWhenDone;
+
+		//The step being run, its bots and the actors built for their lanes
+		int32 Step = INDEX_NONE;
+		int32 Frame = 0;
+		TArray<FBot> Bots;
+		TArray<TWeakObjectPtr<AActor>> SpawnedActors;
+		FResult Current;
+		TArray<FResult> Results;
+
+		bool Tick(float DeltaTime)
+		{
+			UWorld* CurrentWorld = World.Get();
+			if (!CurrentWorld)
+			{
+				UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour load benchmark: the world went away, stopping"));
+				return false;
+			}
+
+			//Start the next step once the last one is done
+			if (Step == INDEX_NONE || Frame >= WarmupFrames + MeasureFrames)
+			{
+				if (Step != INDEX_NONE)
+					FinishStep();
+
+				Step++;
+				if (Step >= BotCounts.Num())
+				{
+					Finish();
+					return false;
+				}
+
+				StartStep(CurrentWorld, BotCounts[Step]);
+				return true;
+			}
+
+			DriveBots(CurrentWorld, DeltaTime);
+
+			//The game thread time is for the frame that just finished, the bots have been running by then
+			const int32 SceneQueries = GParkourSceneQueries;
+			GParkourSceneQueries = 0;
+			if (Frame >= WarmupFrames)
+			{
+				const double GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+				Current.NumFrames++;
+				Current.AverageGameThreadMs += GameThreadMs;
+				Current.MaxGameThreadMs = FMath::Max(Current.MaxGameThreadMs, GameThreadMs);
+				Current.AverageFrameMs += DeltaTime * 1000.0;
+				Current.SceneQueriesPerFrame += SceneQueries;
+			}
+
+			Frame++;
+			return true;
+		}
+
+		AActor* SpawnBox(UWorld* InWorld, UStaticMesh* Cube, const FVector& Center, const FVector& Size)
+		{
+			//The engine cube is 100 units across
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			AStaticMeshActor* Box = InWorld->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), FTransform(FQuat::Identity, Center, Size / 100.0f), SpawnParams);
+			Box->GetStaticMeshComponent()->SetStaticMesh(Cube);
+			SpawnedActors.Add(Box);
+			return Box;
+		}
+
+		template <typename PadType>
+		void SpawnPad(UWorld* InWorld, const FVector& Center, bool bBlocking)
+		{
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			PadType* Pad = InWorld->SpawnActor<PadType>(PadType::StaticClass(), FTransform(Center), SpawnParams);
+
+			//The pad blueprints give the pads their shape, so give the native pads a box
+			UBoxComponent* Box = NewObject<UBoxComponent>(Pad);
+			Box->InitBoxExtent(FVector(100.0f, 300.0f, 10.0f));
+			Box->SetCollisionProfileName(bBlocking ? UCollisionProfile::BlockAll_ProfileName : TEXT("OverlapAllDynamic"));
+			Box->SetGenerateOverlapEvents(!bBlocking);
+			Pad->SetRootComponent(Box);
+			Box->RegisterComponent();
+			Box->SetWorldLocation(Center);
+			SpawnedActors.Add(Pad);
+		}
+
+		void SpawnLane(UWorld* InWorld, UStaticMesh* Cube, const FVector& LaneOrigin)
+		{
+			//Floor, a wall on the right to run along, and a thin block low enough to vault
+			SpawnBox(InWorld, Cube, LaneOrigin + FVector(LaneLength * 0.5f, 0.0f, -50.0f), FVector(LaneLength, 800.0f, 100.0f));
+			SpawnBox(InWorld, Cube, LaneOrigin + FVector((WallStartX + WallEndX) * 0.5f, 250.0f, 300.0f), FVector(WallEndX - WallStartX, 50.0f, 600.0f));
+			SpawnBox(InWorld, Cube, LaneOrigin + FVector(VaultBlockX, 0.0f, 50.0f), FVector(40.0f, 400.0f, 100.0f));
+
+			SpawnPad<ABoostPad>(InWorld, LaneOrigin + FVector(BoostPadX, 0.0f, 10.0f), false);
+			SpawnPad<ABouncePad>(InWorld, LaneOrigin + FVector(BouncePadX, 0.0f, 10.0f), true);
+
+			//A grapple point above the end of the wall, like the grapple point blueprints
+			FActorSpawnParameters SpawnParams;
+			SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+			AActor* Point = InWorld->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParams);
+			USphereComponent* Sphere = NewObject<USphereComponent>(Point);
+			Sphere->InitSphereRadius(50.0f);
+			Sphere->SetCollisionObjectType(ECC_GameTraceChannel2);
+			Sphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+			Point->SetRootComponent(Sphere);
+			Sphere->RegisterComponent();
+			Sphere->SetWorldLocation(LaneOrigin + FVector(GrappleEndX, 0.0f, 1500.0f));
+			InWorld->GetSubsystem<UGrapplePointSubsystem>()->RegisterGrapplePoint(Point);
+			SpawnedActors.Add(Point);
+		}
+
+		void StartStep(UWorld* InWorld, int32 NumBots)
+		{
+			Frame = 0;
+			Current = FResult();
+			Current.NumBots = NumBots;
+
+			UStaticMesh* Cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+
+			TArray<FVector> LaneOrigins;
+			for (int32 i = 0; i < NumBots; i++)
+			{
+				LaneOrigins.Add(CourseOrigin + FVector((i / LanesPerRow) * (LaneLength + 2000.0f), (i % LanesPerRow) * LaneSpacing, 0.0f));
+				SpawnLane(InWorld, Cube, LaneOrigins.Last());
+			}
+
+			//Use the game mode's pawn so the bots carry the same mesh and animation as a player
+			UClass* BotClass = ASkylineShredderCharacter::StaticClass();
+			AGameModeBase* GameMode = InWorld->GetAuthGameMode();
+			if (GameMode && GameMode->DefaultPawnClass && GameMode->DefaultPawnClass->IsChildOf(ASkylineShredderCharacter::StaticClass()))
+				BotClass = GameMode->DefaultPawnClass;
+
+			const uint64 MemoryBefore = FPlatformMemory::GetStats().UsedPhysical;
+
+			for (const FVector& LaneOrigin : LaneOrigins)
+			{
+				FActorSpawnParameters SpawnParams;
+				SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+				ASkylineShredderCharacter* Character = InWorld->SpawnActor<ASkylineShredderCharacter>(BotClass, FTransform(LaneOrigin + FVector(100.0f, 0.0f, 100.0f)), SpawnParams);
+				if (!Character)
+					continue;
+
+				//Movement input only goes through with a controller
+				Character->SpawnDefaultController();
+
+				FBot& Bot = Bots.AddDefaulted_GetRef();
+				Bot.Character = Character;
+				Bot.LaneOrigin = LaneOrigin;
+			}
+
+			const uint64 MemoryAfter = FPlatformMemory::GetStats().UsedPhysical;
+			if (Bots.Num() > 0)
+			{
+				Current.ProcessMemoryPerBotKB = (double)(MemoryAfter > MemoryBefore ? MemoryAfter - MemoryBefore : 0) / 1024.0 / Bots.Num();
+
+				//Count what one bot's objects take up, the process delta above also has allocator and physics overhead
+				ASkylineShredderCharacter* Character = Bots[0].Character.Get();
+				uint64 ObjectBytes = FArchiveCountMem(Character).GetMax();
+				for (UActorComponent* Component : Character->GetComponents())
+					ObjectBytes += FArchiveCountMem(Component).GetMax();
+				Current.ObjectMemoryPerBotKB = ObjectBytes / 1024.0;
+			}
+
+			GParkourSceneQueries = 0;
+			UE_LOG(LogSkylineShredder, Display, TEXT("Parkour load benchmark: running %d bots"), Bots.Num());
+		}
+
+		void DriveBots(UWorld* InWorld, float DeltaTime)
+		{
+			//Grappling aims along the player's camera, so bots can only grapple when there is one
+			const bool bCanGrapple = UGameplayStatics::GetPlayerCameraManager(InWorld, 0) != nullptr;
+
+			for (FBot& Bot : Bots)
+			{
+				ASkylineShredderCharacter* Character = Bot.Character.Get();
+				if (!Character)
+					continue;
+
+				UCharacterMovementComponent* Movement = Character->GetCharacterMovement();
+				const FVector Local = Character->GetActorLocation() - Bot.LaneOrigin;
+
+				//Start the lane again at the end, or after falling off it
+				if (Local.X > LaneLength - 200.0f || Local.Z < -1000.0f)
+				{
+					Character->EndGrapple();
+					Character->SetActorLocation(Bot.LaneOrigin + FVector(100.0f, 0.0f, 100.0f), false, nullptr, ETeleportType::TeleportPhysics);
+					Movement->Velocity = FVector::ZeroVector;
+					Bot.GrappleTime = 0.0f;
+					continue;
+				}
+
+				//Run forward, leaning into the wall along the wall section
+				const bool bAlongWall = Local.X > WallStartX && Local.X < WallEndX;
+				Character->AddScriptedInput(1.0f, bAlongWall ? 0.4f : 0.0f);
+
+				//Press jump just before the wall, and let go the next frame
+				if (Bot.bJumpHeld)
+				{
+					Character->QueueJumpToggle();
+					Bot.bJumpHeld = false;
+				}
+				else if (Movement->IsMovingOnGround() && Local.X > JumpStartX && Local.X < JumpEndX)
+				{
+					Character->QueueJumpToggle();
+					Bot.bJumpHeld = true;
+				}
+
+				//Grapple off the end of the wall and let go after a moment
+				if (Character->IsGrappleHookAttached())
+				{
+					Bot.GrappleTime += DeltaTime;
+					if (Bot.GrappleTime >= GrappleHoldTime)
+						Character->EndGrapple();
+				}
+				else if (bCanGrapple && Movement->IsFalling() && Local.X > GrappleStartX && Local.X < GrappleEndX)
+				{
+					Bot.GrappleTime = 0.0f;
+					Character->CheckForGrapple();
+				}
+
+				//Vault the block
+				if (!Character->IsInAction() && Local.X > VaultStartX && Local.X < VaultBlockX && Character->CheckForClimbing())
+					Character->StartVaultOrGetUp();
+			}
+		}
+
+		void FinishStep()
+		{
+			if (Current.NumFrames > 0)
+			{
+				Current.AverageGameThreadMs /= Current.NumFrames;
+				Current.AverageFrameMs /= Current.NumFrames;
+				Current.SceneQueriesPerFrame /= Current.NumFrames;
+			}
+
+			UE_LOG(LogSkylineShredder, Display, TEXT("Parkour load benchmark: %4d bots, game thread %7.3f ms avg %7.3f ms max, frame %7.3f ms, %8.1f scene queries/frame, %8.1f KB/bot process, %8.1f KB/bot objects"),
+				Current.NumBots, Current.AverageGameThreadMs, Current.MaxGameThreadMs, Current.AverageFrameMs, Current.SceneQueriesPerFrame,
+				Current.ProcessMemoryPerBotKB, Current.ObjectMemoryPerBotKB);
+			Results.Add(Current);
+
+			for (FBot& Bot : Bots)
+			{
+				if (ASkylineShredderCharacter* Character = Bot.Character.Get())
+				{
+					if (AController* Controller = Character->GetController())
+						Controller->Destroy();
+					Character->Destroy();
+				}
+			}
+			Bots.Reset();
+
+			for (TWeakObjectPtr<AActor>& Actor : SpawnedActors)
+			{
+				if (Actor.IsValid())
+					Actor->Destroy();
+			}
+			SpawnedActors.Reset();
+		}
+
+		void Finish()
+		{
+			FString Csv = TEXT("Bots,Frames,GameThreadMsAvg,GameThreadMsMax,FrameMsAvg,SceneQueriesPerFrame,ProcessMemoryPerBotKB,ObjectMemoryPerBotKB\n");
+			FString Json = TEXT("[\n");
+			for (int32 i = 0; i < Results.Num(); i++)
+			{
+				const FResult& Result = Results[i];
+				Csv += FString::Printf(TEXT("%d,%d,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f\n"), Result.NumBots, Result.NumFrames, Result.AverageGameThreadMs,
+					Result.MaxGameThreadMs, Result.AverageFrameMs, Result.SceneQueriesPerFrame, Result.ProcessMemoryPerBotKB, Result.ObjectMemoryPerBotKB);
+				Json += FString::Printf(TEXT("  { \"bots\": %d, \"frames\": %d, \"gameThreadMsAvg\": %.4f, \"gameThreadMsMax\": %.4f, \"frameMsAvg\": %.4f, \"sceneQueriesPerFrame\": %.2f, \"processMemoryPerBotKB\": %.2f, \"objectMemoryPerBotKB\": %.2f }%s\n"),
+					Result.NumBots, Result.NumFrames, Result.AverageGameThreadMs, Result.MaxGameThreadMs, Result.AverageFrameMs, Result.SceneQueriesPerFrame,
+					Result.ProcessMemoryPerBotKB, Result.ObjectMemoryPerBotKB, i + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+			}
+			Json += TEXT("]\n");
+
+			const FString BaseName = FPaths::ProfilingDir() / TEXT("ParkourBenchmark") / FString::Printf(TEXT("ParkourBenchmark-%s"), *FDateTime::Now().ToString());
+			FFileHelper::SaveStringToFile(Csv, *(BaseName + TEXT(".csv")));
+			FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+			UE_LOG(LogSkylineShredder, Display, TEXT("Parkour load benchmark: wrote %s.csv and .json"), *BaseName);
+
+			if (bQuitWhenDone)
+				FPlatformMisc::RequestExit(false);
+		}
+	};
+
+	static void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || !World->IsGameWorld())
+			return;
+
+		TArray<int32> BotCounts = { 1, 16, 64, 256 };
+		if (Args.Num() > 0)
+		{
+			TArray<FString> Counts;
+			Args[0].ParseIntoArray(Counts, TEXT(","));
+			BotCounts.Reset();
+			for (const FString& Count : Counts)
+				BotCounts.Add(FMath::Max(1, FCString::Atoi(*Count)));
+		}
+
+		const int32 MeasureFrames = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 600;
+		const bool bQuitWhenDone = Args.Contains(TEXT("quit"));
+
+		MakeShared<FLoadBenchmark>(World, MoveTemp(BotCounts), MeasureFrames, bQuitWhenDone)->Start();
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs LoadBenchmarkCommand(
+	TEXT("Parkour.LoadBenchmark"),
+	TEXT("Runs N scripted parkour bots and reports game thread time, scene queries and memory per bot. Usage: Parkour.LoadBenchmark [Counts=1,16,64,256] [Frames=600] [quit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ParkourLoadBenchmark::Run));
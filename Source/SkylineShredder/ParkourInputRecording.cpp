@@ -0,0 +1,205 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ParkourInputRecording.h"
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "SkylineMovementComponent.h"
+#include "GrappleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/Controller.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+//////////////////////////////////////////////////////////////////////////
+// FParkourInputFrame
+
+void FParkourInputFrame::SetAxis(EParkourInputAxis Axis, float Value)
+{
+	switch (Axis)
+	{
+	case EParkourInputAxis::MoveForward: MoveForward = Value; break;
+	case EParkourInputAxis::MoveRight: MoveRight = Value; break;
+	case EParkourInputAxis::Turn: Turn = Value; break;
+	case EParkourInputAxis::LookUp: LookUp = Value; break;
+	case EParkourInputAxis::TurnRate: TurnRate = Value; break;
+	case EParkourInputAxis::LookUpRate: LookUpRate = Value; break;
+	}
+}
+
+void FParkourInputFrame::AddJumpEvent(bool bPressed)
+{
+	//Nobody presses jump eight times in a frame, anything past that is dropped
+	if (NumJumpEvents >= 8)
+		return;
+
+	if (bPressed)
+		JumpEvents |= 1 << NumJumpEvents;
+	NumJumpEvents++;
+}
+
+FArchive& operator<<(FArchive& Ar, FParkourInputFrame& Frame)
+{
+	Ar << Frame.DeltaTime;
+	Ar << Frame.MoveForward << Frame.MoveRight << Frame.Turn << Frame.LookUp << Frame.TurnRate << Frame.LookUpRate;
+	Ar << Frame.NumJumpEvents << Frame.JumpEvents;
+	Ar << Frame.ControlRotation << Frame.Location << Frame.Momentum;
+	return Ar;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FParkourInputRecording
+
+FString FParkourInputRecording::GetRecordingDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("InputRecordings");
+}
+
+FString FParkourInputRecording::GetRecordingPath(const FString& RecordingName)
+{
+	return GetRecordingDirectory() / (FPaths::MakeValidFileName(RecordingName) + TEXT(".pinput"));
+}
+
+//Everything before the frames, the same for saving and loading
+static void SerializeStart(FArchive& Ar, FParkourInputRecording& Recording)
+{
+	Ar << Recording.MapName << Recording.StartLocation << Recording.StartRotation << Recording.StartControlRotation << Recording.StartVelocity << Recording.StartMovementMode;
+
+	uint8 ParkourState = (uint8)Recording.StartParkourState;
+	Ar << ParkourState << Recording.StartParkourFlags << Recording.StartNumberOfJumps;
+	Recording.StartParkourState = ParkourState < (uint8)EParkourState::Count ? (EParkourState)ParkourState : EParkourState::None;
+
+	FParkourSimulationState& Simulation = Recording.StartSimulation;
+	Ar << Simulation.Momentum << Simulation.PreviousMomentum << Simulation.Gravity << Simulation.PreviousGravity << Simulation.Accumulator;
+
+	Ar << Recording.bStartGrappleAttached << Recording.StartHookLocation << Recording.StartRopeMaxLength;
+}
+
+bool FParkourInputRecording::Save(const FString& Path) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 FileMagic = Magic;
+	uint32 Version = CurrentVersion;
+	Writer << FileMagic << Version;
+
+	//Saving doesn't change anything, the archive just can't take a const recording
+	SerializeStart(Writer, const_cast<FParkourInputRecording&>(*this));
+
+	int32 NumFrames = Frames.Num();
+	Writer << NumFrames;
+	for (FParkourInputFrame Frame : Frames)
+		Writer << Frame;
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Path);
+}
+
+bool FParkourInputRecording::Load(const FString& Path)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path, FILEREAD_Silent))
+		return false;
+
+	FMemoryReader Reader(Bytes);
+	uint32 FileMagic = 0;
+	uint32 Version = 0;
+	Reader << FileMagic << Version;
+	if (FileMagic != Magic || Version != CurrentVersion)
+	{
+		UE_LOG(LogSkylineShredder, Warning, TEXT("%s isn't an input recording this version can read"), *Path);
+		return false;
+	}
+
+	SerializeStart(Reader, *this);
+
+	//Every frame is dozens of bytes, so more frames than bytes means the file is corrupt
+	int32 NumFrames = 0;
+	Reader << NumFrames;
+	if (Reader.IsError() || NumFrames < 0 || NumFrames > Bytes.Num())
+		return false;
+
+	Frames.SetNum(NumFrames);
+	for (FParkourInputFrame& Frame : Frames)
+		Reader << Frame;
+
+	return !Reader.IsError();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FParkourInputTape
+
+FParkourInputTape::FParkourInputTape(ASkylineShredderCharacter& Character)
+{
+	Recording.MapName = Character.GetWorld()->GetMapName();
+	Recording.StartLocation = Character.GetActorLocation();
+	Recording.StartRotation = Character.GetActorRotation();
+	Recording.StartControlRotation = Character.GetControlRotation();
+	Recording.StartVelocity = Character.GetCharacterMovement()->Velocity;
+	Recording.StartMovementMode = Character.GetCharacterMovement()->MovementMode;
+
+	Recording.StartParkourState = Character.ParkourState;
+	Recording.StartParkourFlags = Character.GetParkourFlags();
+	Recording.StartNumberOfJumps = Character.NumberOfJumps;
+	Recording.StartSimulation = Character.GetSimulationState();
+
+	const UGrappleComponent* Grapple = Character.GetGrapple();
+	const USkylineMovementComponent* SkylineMovement = Cast<USkylineMovementComponent>(Character.GetCharacterMovement());
+	Recording.bStartGrappleAttached = Grapple->IsHookAttached() && SkylineMovement;
+	Recording.StartHookLocation = Grapple->GetHookLocation();
+	Recording.StartRopeMaxLength = SkylineMovement ? SkylineMovement->GetGrappleRope().GetMaxLength() : 0.0f;
+}
+
+FParkourInputTape::FParkourInputTape(FParkourInputRecording InRecording)
+	: Recording(MoveTemp(InRecording)), bReplaying(true)
+{
+	ReplayFrames.Reserve(Recording.Frames.Num());
+}
+
+void FParkourInputTape::RecordAxis(EParkourInputAxis Axis, float Value)
+{
+	if (!bReplaying)
+		Pending.SetAxis(Axis, Value);
+}
+
+void FParkourInputTape::RecordJump(bool bPressed)
+{
+	if (!bReplaying)
+		Pending.AddJumpEvent(bPressed);
+}
+
+void FParkourInputTape::CharacterTick(ASkylineShredderCharacter& Character, float DeltaTime)
+{
+	if (!bReplaying)
+	{
+		Pending.DeltaTime = DeltaTime;
+		Pending.ControlRotation = Character.GetControlRotation();
+		Pending.Location = Character.GetActorLocation();
+		Pending.Momentum = Character.GetMomentum();
+		Recording.Frames.Add(Pending);
+		Pending = FParkourInputFrame();
+		return;
+	}
+
+	if (IsFinished())
+		return;
+
+	const FParkourInputFrame& Frame = Recording.Frames[NextFrame];
+
+	//Compare against where the character was at the same point of the recording, before this frame's input
+	FParkourReplayFrame& Result = ReplayFrames.AddDefaulted_GetRef();
+	Result.DeltaTime = DeltaTime;
+	Result.GameThreadMs = FPlatformTime::ToMilliseconds(GGameThreadTime);
+	Result.Divergence = FVector::Dist(Character.GetActorLocation(), Frame.Location);
+	Result.MomentumDivergence = FMath::Abs(Character.GetMomentum() - Frame.Momentum);
+
+	Character.ApplyRecordedInput(Frame);
+	NextFrame++;
+
+	//The engine steps the next frame by exactly as long as the recorded one
+	if (NextFrame < Recording.Frames.Num())
+		FApp::SetFixedDeltaTime(Recording.Frames[NextFrame].DeltaTime);
+}
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "ParkourState.h"
+
+class ASkylineShredderCharacter;
+
+//The input axes the character binds
+enum class EParkourInputAxis : uint8
+{
+	MoveForward,
+	MoveRight,
+	Turn,
+	LookUp,
+	TurnRate,
+	LookUpRate,
+};
+
+/// <summary>
+/// The input that reached the character's bindings in one frame, with how long the frame was and where
+/// the character was at the start of it
+/// </summary>
+struct SKYLINESHREDDER_API FParkourInputFrame
+{
+	float DeltaTime = 0.0f;
+
+	float MoveForward = 0.0f;
+	float MoveRight = 0.0f;
+	float Turn = 0.0f;
+	float LookUp = 0.0f;
+	float TurnRate = 0.0f;
+	float LookUpRate = 0.0f;
+
+	//Jump presses and releases in the order they came in, the first in the lowest bit and a set bit is a press
+	uint8 NumJumpEvents = 0;
+	uint8 JumpEvents = 0;
+
+	//The rotation the look input left the controller at this frame
+	FRotator ControlRotation = FRotator::ZeroRotator;
+
+	//The trajectory replays are checked against
+	FVector Location = FVector::ZeroVector;
+	float Momentum = 0.0f;
+
+	void SetAxis(EParkourInputAxis Axis, float Value);
+	void AddJumpEvent(bool bPressed);
+	bool IsJumpPress(int32 Index) const { return (JumpEvents & (1 << Index)) != 0; }
+
+	friend FArchive& operator<<(FArchive& Ar, FParkourInputFrame& Frame);
+};
+
+/// <summary>
+/// A recorded player session: where the character started, what it was doing, and every frame of input after that
+/// </summary>
+struct SKYLINESHREDDER_API FParkourInputRecording
+{
+	static constexpr uint32 Magic = 0x4E495350; // "PSIN"
+	static constexpr uint32 CurrentVersion = 2;
+
+	FString MapName;
+	FVector StartLocation = FVector::ZeroVector;
+	FRotator StartRotation = FRotator::ZeroRotator;
+	FRotator StartControlRotation = FRotator::ZeroRotator;
+	FVector StartVelocity = FVector::ZeroVector;
+	uint8 StartMovementMode = MOVE_Walking;
+
+	//The parkour state and simulation the character started in
+	EParkourState StartParkourState = EParkourState::None;
+	uint8 StartParkourFlags = 0;
+	int32 StartNumberOfJumps = 0;
+	FParkourSimulationState StartSimulation;
+
+	//The grapple the character started hooked to, if it was
+	bool bStartGrappleAttached = false;
+	FVector StartHookLocation = FVector::ZeroVector;
+	float StartRopeMaxLength = 0.0f;
+
+	TArray<FParkourInputFrame> Frames;
+
+	//The folder recordings are saved in, Saved/InputRecordings
+	static FString GetRecordingDirectory();
+
+	//The path of a recording saved with a name
+	static FString GetRecordingPath(const FString& RecordingName);
+
+	bool Save(const FString& Path) const;
+
+	/// <summary>
+	/// Loads a recording
+	/// </summary>
+	/// <returns>false if the file is missing or isn't a recording this version can read</returns>
+	bool Load(const FString& Path);
+};
+
+//How a replayed frame went against the recording
+struct FParkourReplayFrame
+{
+	float DeltaTime = 0.0f;
+	double GameThreadMs = 0.0;
+	float Divergence = 0.0f;
+	float MomentumDivergence = 0.0f;
+};
+
+/// <summary>
+/// Sits between the character's input bindings and its tick. While recording it collects the input that
+/// comes through the bindings into frames, while replaying it feeds a recording back through the same
+/// handlers, with the recorded frame times, and measures how far the character strays from where it was.
+/// </summary>
+class SKYLINESHREDDER_API FParkourInputTape
+{
+public:
+	//Starts recording the character
+	explicit FParkourInputTape(ASkylineShredderCharacter& Character);
+
+	//Replays a recording, the character has to be put at the start of it first
+	explicit FParkourInputTape(FParkourInputRecording InRecording);
+
+	void RecordAxis(EParkourInputAxis Axis, float Value);
+	void RecordJump(bool bPressed);
+
+	/// <summary>
+	/// Called by the character at the start of its tick, once the controller has processed this frame's input.
+	/// Ends the frame being recorded, or applies the next replayed frame
+	/// </summary>
+	void CharacterTick(ASkylineShredderCharacter& Character, float DeltaTime);
+
+	bool IsReplaying() const { return bReplaying; }
+	bool IsFinished() const { return bReplaying && NextFrame >= Recording.Frames.Num(); }
+
+	const FParkourInputRecording& GetRecording() const { return Recording; }
+	const TArray<FParkourReplayFrame>& GetReplayFrames() const { return ReplayFrames; }
+
+private:
+	FParkourInputRecording Recording;
+	bool bReplaying = false;
+
+	//The frame being recorded
+	FParkourInputFrame Pending;
+
+	//The frame to replay next
+	int32 NextFrame = 0;
+	TArray<FParkourReplayFrame> ReplayFrames;
+};
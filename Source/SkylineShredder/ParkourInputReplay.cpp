@@ -0,0 +1,271 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+//Records a real player session and replays it headless, so the same run can be compared before and after a
+//change for both frame time and behaviour. Record in game with
+//  Parkour.RecordInput MyRun          (starts recording the local player)
+//  Parkour.RecordInput stop           (saves it to Saved/InputRecordings/MyRun.pinput)
+//then replay it on the same map with
+//  UnrealEditor SkylineShredder.uproject /Game/Maps/CityBlockout_Level -game -nullrhi -unattended -ExecCmds="Parkour.ReplayInput MyRun quit"
+//The replay runs every frame with the recorded frame time and writes the per frame game thread time and how far
+//the character strayed from the recording as CSV, with a JSON summary, to Saved/Profiling/ParkourReplay.
+
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "SkylineMovementComponent.h"
+#include "GrappleComponent.h"
+#include "ParkourInputRecording.h"
+#include "Containers/Ticker.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace ParkourInputReplay
+{
+	//How far the character can be from the recording, in cm, before the replay counts as diverged
+	static const float DivergenceTolerance = 10.0f;
+
+	class FInputReplay : public TSharedFromThis<FInputReplay>
+	{
+	public:
+		FInputReplay(const FString& InName, bool bInQuitWhenDone)
+			: Name(InName), bQuitWhenDone(bInQuitWhenDone)
+		{
+		}
+
+		bool Start(UWorld* World)
+		{
+			FParkourInputRecording Recording;
+			if (!Recording.Load(FParkourInputRecording::GetRecordingPath(Name)) || Recording.Frames.Num() == 0)
+			{
+				UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour replay: couldn't load the input recording %s"), *Name);
+				return false;
+			}
+
+			PlayerController = World->GetFirstPlayerController();
+			ASkylineShredderCharacter* PlayerCharacter = PlayerController.IsValid() ? Cast<ASkylineShredderCharacter>(PlayerController->GetPawn()) : nullptr;
+			if (!PlayerCharacter)
+			{
+				UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour replay: there is no player character to replay on"));
+				return false;
+			}
+
+			if (Recording.MapName != World->GetMapName())
+				UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour replay: %s was recorded on %s, not %s, it will diverge"), *Name, *Recording.MapName, *World->GetMapName());
+
+			//End whatever the character is doing, falling leaves a wall run, swing or vault and lets go of the rope
+			UCharacterMovementComponent* Movement = PlayerCharacter->GetCharacterMovement();
+			Movement->SetMovementMode(MOVE_Falling);
+			PlayerCharacter->GetGrapple()->CorrectGrapple(false, FVector::ZeroVector, 0.0f);
+
+			//Put the character back where and how the recording started, with the player's own input turned off
+			PlayerCharacter->SetActorLocationAndRotation(Recording.StartLocation, Recording.StartRotation, false, nullptr, ETeleportType::TeleportPhysics);
+			Movement->Velocity = Recording.StartVelocity;
+			Movement->SetMovementMode(Recording.StartMovementMode == MOVE_Walking ? MOVE_Walking : MOVE_Falling);
+			PlayerController->SetControlRotation(Recording.StartControlRotation);
+			PlayerCharacter->DisableInput(PlayerController.Get());
+
+			//A vault or climb can't be picked up half way, so the replay starts after it. A wall run starts again
+			//from the falling movement as soon as the wall is found
+			const bool bStartedInVault = Recording.StartParkourState == EParkourState::Vault || Recording.StartParkourState == EParkourState::Climb;
+			PlayerCharacter->RestoreParkourState(bStartedInVault ? EParkourState::None : Recording.StartParkourState, Recording.StartParkourFlags, Recording.StartNumberOfJumps);
+			PlayerCharacter->SetSimulationState(Recording.StartSimulation);
+			PlayerCharacter->SetPendingJumpToggles(0);
+
+			USkylineMovementComponent* SkylineMovement = Cast<USkylineMovementComponent>(Movement);
+			if (Recording.bStartGrappleAttached && SkylineMovement)
+			{
+				PlayerCharacter->GetGrapple()->CorrectGrapple(true, Recording.StartHookLocation, Recording.StartRopeMaxLength);
+				SkylineMovement->StartGrappleSwing(Recording.StartHookLocation, Recording.StartRopeMaxLength);
+			}
+
+			//Step the engine by the recorded frame times, the tape sets the time of each frame after the first
+			bUsedFixedTimeStep = FApp::UseFixedTimeStep();
+			PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+			FApp::SetUseFixedTimeStep(true);
+			FApp::SetFixedDeltaTime(Recording.Frames[0].DeltaTime);
+
+			UE_LOG(LogSkylineShredder, Display, TEXT("Parkour replay: replaying %s, %d frames"), *Name, Recording.Frames.Num());
+
+			Tape = MakeShared<FParkourInputTape>(MoveTemp(Recording));
+			PlayerCharacter->SetInputTape(Tape);
+			Character = PlayerCharacter;
+
+			//The ticker keeps the replay alive until it returns false
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([This = AsShared()](float DeltaTime)
+			{
+				return This->Tick(DeltaTime);
+			}));
+			return true;
+		}
+
+	private:
+		FString Name;
+		bool bQuitWhenDone;
+
+		TWeakObjectPtr<APlayerController> PlayerController;
+		TWeakObjectPtr<ASkylineShredderCharacter> Character;
+		TSharedPtr<FParkourInputTape> Tape;
+
+		bool bUsedFixedTimeStep = false;
+		double PreviousFixedDeltaTime = 0.0;
+
+		bool Tick(float DeltaTime)
+		{
+			if (!Character.IsValid())
+			{
+				UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour replay: the character went away, stopping"));
+				Finish();
+				return false;
+			}
+
+			if (!Tape->IsFinished())
+				return true;
+
+			Finish();
+			return false;
+		}
+
+		void Finish()
+		{
+			FApp::SetUseFixedTimeStep(bUsedFixedTimeStep);
+			FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+			if (ASkylineShredderCharacter* CurrentCharacter = Character.Get())
+			{
+				CurrentCharacter->SetInputTape(nullptr);
+				if (PlayerController.IsValid())
+					CurrentCharacter->EnableInput(PlayerController.Get());
+			}
+
+			WriteReport();
+
+			if (bQuitWhenDone)
+				FPlatformMisc::RequestExit(false);
+		}
+
+		void WriteReport()
+		{
+			const TArray<FParkourReplayFrame>& Frames = Tape->GetReplayFrames();
+
+			//The game thread time is for the frame before, so the first frame's belongs to before the replay
+			TArray<double> GameThreadMs;
+			double TotalGameThreadMs = 0.0;
+			float MaxDivergence = 0.0f;
+			float MaxMomentumDivergence = 0.0f;
+			int32 FirstDivergedFrame = INDEX_NONE;
+
+			FString Csv = TEXT("Frame,DeltaTime,GameThreadMs,Divergence,MomentumDivergence\n");
+			for (int32 i = 0; i < Frames.Num(); i++)
+			{
+				const FParkourReplayFrame& Frame = Frames[i];
+				Csv += FString::Printf(TEXT("%d,%.5f,%.4f,%.3f,%.3f\n"), i, Frame.DeltaTime, Frame.GameThreadMs, Frame.Divergence, Frame.MomentumDivergence);
+
+				if (i > 0)
+				{
+					GameThreadMs.Add(Frame.GameThreadMs);
+					TotalGameThreadMs += Frame.GameThreadMs;
+				}
+
+				MaxDivergence = FMath::Max(MaxDivergence, Frame.Divergence);
+				MaxMomentumDivergence = FMath::Max(MaxMomentumDivergence, Frame.MomentumDivergence);
+				if (FirstDivergedFrame == INDEX_NONE && Frame.Divergence > DivergenceTolerance)
+					FirstDivergedFrame = i;
+			}
+
+			GameThreadMs.Sort();
+			const double AverageGameThreadMs = GameThreadMs.Num() > 0 ? TotalGameThreadMs / GameThreadMs.Num() : 0.0;
+			const double P95GameThreadMs = GameThreadMs.Num() > 0 ? GameThreadMs[FMath::Min(GameThreadMs.Num() - 1, GameThreadMs.Num() * 95 / 100)] : 0.0;
+			const double MaxGameThreadMs = GameThreadMs.Num() > 0 ? GameThreadMs.Last() : 0.0;
+			const float FinalDivergence = Frames.Num() > 0 ? Frames.Last().Divergence : 0.0f;
+
+			UE_LOG(LogSkylineShredder, Display, TEXT("Parkour replay: %s, %d of %d frames, game thread %7.3f ms avg %7.3f ms p95 %7.3f ms max, divergence %.1f cm max %.1f cm final, first diverged frame %d"),
+				*Name, Frames.Num(), Tape->GetRecording().Frames.Num(), AverageGameThreadMs, P95GameThreadMs, MaxGameThreadMs, MaxDivergence, FinalDivergence, FirstDivergedFrame);
+
+			const FString Json = FString::Printf(TEXT("{ \"recording\": \"%s\", \"frames\": %d, \"recordedFrames\": %d, \"gameThreadMsAvg\": %.4f, \"gameThreadMsP95\": %.4f, \"gameThreadMsMax\": %.4f, \"maxDivergence\": %.3f, \"finalDivergence\": %.3f, \"maxMomentumDivergence\": %.3f, \"firstDivergedFrame\": %d }\n"),
+				*Name, Frames.Num(), Tape->GetRecording().Frames.Num(), AverageGameThreadMs, P95GameThreadMs, MaxGameThreadMs, MaxDivergence, FinalDivergence,
+				MaxMomentumDivergence, FirstDivergedFrame);
+
+			const FString BaseName = FPaths::ProfilingDir() / TEXT("ParkourReplay") / FString::Printf(TEXT("%s-%s"), *FPaths::MakeValidFileName(Name), *FDateTime::Now().ToString());
+			FFileHelper::SaveStringToFile(Csv, *(BaseName + TEXT(".csv")));
+			FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+			UE_LOG(LogSkylineShredder, Display, TEXT("Parkour replay: wrote %s.csv and .json"), *BaseName);
+		}
+	};
+
+	//The recording in progress
+	static TWeakObjectPtr<ASkylineShredderCharacter> RecordingCharacter;
+	static TSharedPtr<FParkourInputTape> RecordingTape;
+	static FString RecordingName;
+
+	static void StopRecording()
+	{
+		if (ASkylineShredderCharacter* Character = RecordingCharacter.Get())
+			Character->SetInputTape(nullptr);
+
+		if (RecordingTape.IsValid())
+		{
+			const FString Path = FParkourInputRecording::GetRecordingPath(RecordingName);
+			if (RecordingTape->GetRecording().Save(Path))
+				UE_LOG(LogSkylineShredder, Display, TEXT("Parkour input recording: saved %d frames to %s"), RecordingTape->GetRecording().Frames.Num(), *Path);
+			else
+				UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour input recording: couldn't save %s"), *Path);
+		}
+
+		RecordingCharacter.Reset();
+		RecordingTape.Reset();
+	}
+
+	static void Record(const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() == 0 || Args[0] == TEXT("stop"))
+		{
+			StopRecording();
+			return;
+		}
+
+		if (!World || !World->IsGameWorld())
+			return;
+
+		//Starting again saves the recording that was going
+		StopRecording();
+
+		APlayerController* Controller = World->GetFirstPlayerController();
+		ASkylineShredderCharacter* Character = Controller ? Cast<ASkylineShredderCharacter>(Controller->GetPawn()) : nullptr;
+		if (!Character)
+		{
+			UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour input recording: there is no player character to record"));
+			return;
+		}
+
+		RecordingName = Args[0];
+		RecordingCharacter = Character;
+		RecordingTape = MakeShared<FParkourInputTape>(*Character);
+		Character->SetInputTape(RecordingTape);
+		UE_LOG(LogSkylineShredder, Display, TEXT("Parkour input recording: recording %s"), *RecordingName);
+	}
+
+	static void Replay(const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() == 0 || !World || !World->IsGameWorld())
+			return;
+
+		const bool bQuitWhenDone = Args.Contains(TEXT("quit"));
+		TSharedRef<FInputReplay> InputReplay = MakeShared<FInputReplay>(Args[0], bQuitWhenDone);
+		if (!InputReplay->Start(World) && bQuitWhenDone)
+			FPlatformMisc::RequestExit(false);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs RecordInputCommand(
+	TEXT("Parkour.RecordInput"),
+	TEXT("Records the local player's input and frame times until stopped. Usage: Parkour.RecordInput <Name> | Parkour.RecordInput stop"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ParkourInputReplay::Record));
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayInputCommand(
+	TEXT("Parkour.ReplayInput"),
+	TEXT("Replays an input recording on the local player with the recorded frame times and reports frame time and divergence. Usage: Parkour.ReplayInput <Name> [quit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ParkourInputReplay::Replay));
@@ -0,0 +1,243 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+//Measures the bandwidth networked parkour uses per client. Start a server and connect clients over loopback,
+//have the clients run the scripted net bot, then run the report on the server, for example with 16 clients
+//  UnrealEditor SkylineShredder.uproject /Game/Maps/CityBlockout_Level?listen -server -log -nullrhi
+//  UnrealEditor SkylineShredder.uproject 127.0.0.1 -game -nullrhi -unattended -ExecCmds="Parkour.NetBot 1"    (x16)
+//  Parkour.NetReport 30    (on the server, or -ExecCmds="Parkour.NetReport 30 quit")
+//and again with 64 clients. A listen server from the editor with 16 or 64 players works the same way.
+//Each report is appended to Saved/Profiling/ParkourNet/ParkourNet.csv and written as JSON next to it.
+//There are no figures checked in for either player count, they depend on the machine and the map and only
+//come from running the report, so record them from the CSV with the build they were measured on.
+
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "Containers/Ticker.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+namespace ParkourNetReport
+{
+	class FNetReport : public TSharedFromThis<FNetReport>
+	{
+	public:
+		FNetReport(UWorld* InWorld, float InDuration, bool bInQuitWhenDone)
+			: World(InWorld), Duration(InDuration), bQuitWhenDone(bInQuitWhenDone)
+		{
+		}
+
+		void Start()
+		{
+			StartMoveBits = GParkourNetMoveBits;
+			StartResponseBits = GParkourNetResponseBits;
+
+			//The ticker keeps the report alive until it returns false
+			FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([This = AsShared()](float DeltaTime)
+			{
+				return This->Tick(DeltaTime);
+			}));
+		}
+
+	private:
+		TWeakObjectPtr<UWorld> World;
+		float Duration;
+		bool bQuitWhenDone;
+
+		float Elapsed = 0.0f;
+		float SampleTimer = 0.0f;
+		int32 NumSamples = 0;
+		int32 MaxClients = 0;
+		double InBytesPerClientSum = 0.0;
+		double OutBytesPerClientSum = 0.0;
+		int64 StartMoveBits = 0;
+		int64 StartResponseBits = 0;
+
+		bool Tick(float DeltaTime)
+		{
+			UWorld* CurrentWorld = World.Get();
+			UNetDriver* NetDriver = CurrentWorld ? CurrentWorld->GetNetDriver() : nullptr;
+			if (!NetDriver || !NetDriver->IsServer())
+			{
+				UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour net report: not running on a server, stopping"));
+				return false;
+			}
+
+			Elapsed += DeltaTime;
+			SampleTimer += DeltaTime;
+
+			//The connections update their rates once a second, so sample them at the same rate
+			if (SampleTimer >= 1.0f)
+			{
+				SampleTimer -= 1.0f;
+				Sample(NetDriver);
+			}
+
+			if (Elapsed < Duration)
+				return true;
+
+			Finish();
+			return false;
+		}
+
+		void Sample(UNetDriver* NetDriver)
+		{
+			int32 NumClients = 0;
+			double InBytes = 0.0;
+			double OutBytes = 0.0;
+			for (UNetConnection* Connection : NetDriver->ClientConnections)
+			{
+				if (!Connection || Connection->State != USOCK_Open)
+					continue;
+
+				NumClients++;
+				InBytes += Connection->InBytesPerSecond;
+				OutBytes += Connection->OutBytesPerSecond;
+			}
+
+			if (NumClients == 0)
+				return;
+
+			InBytesPerClientSum += InBytes / NumClients;
+			OutBytesPerClientSum += OutBytes / NumClients;
+			MaxClients = FMath::Max(MaxClients, NumClients);
+			NumSamples++;
+		}
+
+		void Finish()
+		{
+			const double InBytesPerClient = NumSamples > 0 ? InBytesPerClientSum / NumSamples : 0.0;
+			const double OutBytesPerClient = NumSamples > 0 ? OutBytesPerClientSum / NumSamples : 0.0;
+
+			//The movement RPCs are counted on the server as they come in and go out
+			const double Seconds = FMath::Max(Elapsed, 1.0f);
+			const int32 Clients = FMath::Max(MaxClients, 1);
+			const double MoveBytesPerClient = (GParkourNetMoveBits - StartMoveBits) / 8.0 / Seconds / Clients;
+			const double ResponseBytesPerClient = (GParkourNetResponseBits - StartResponseBits) / 8.0 / Seconds / Clients;
+
+			UE_LOG(LogSkylineShredder, Display, TEXT("Parkour net report: %3d clients over %5.1f s, per client %8.1f B/s up %8.1f B/s down, movement %7.1f B/s up %7.1f B/s down"),
+				MaxClients, Elapsed, InBytesPerClient, OutBytesPerClient, MoveBytesPerClient, ResponseBytesPerClient);
+
+			const FString Directory = FPaths::ProfilingDir() / TEXT("ParkourNet");
+			const FString CsvPath = Directory / TEXT("ParkourNet.csv");
+			if (!FPlatformFileManager::Get().GetPlatformFile().FileExists(*CsvPath))
+				FFileHelper::SaveStringToFile(TEXT("Clients,Seconds,InBytesPerClient,OutBytesPerClient,MoveBytesPerClient,ResponseBytesPerClient\n"), *CsvPath);
+
+			FFileHelper::SaveStringToFile(FString::Printf(TEXT("%d,%.1f,%.1f,%.1f,%.1f,%.1f\n"), MaxClients, Elapsed, InBytesPerClient, OutBytesPerClient,
+				MoveBytesPerClient, ResponseBytesPerClient), *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+
+			const FString Json = FString::Printf(TEXT("{ \"clients\": %d, \"seconds\": %.1f, \"inBytesPerClient\": %.1f, \"outBytesPerClient\": %.1f, \"moveBytesPerClient\": %.1f, \"responseBytesPerClient\": %.1f }\n"),
+				MaxClients, Elapsed, InBytesPerClient, OutBytesPerClient, MoveBytesPerClient, ResponseBytesPerClient);
+			FFileHelper::SaveStringToFile(Json, *(Directory / FString::Printf(TEXT("ParkourNet-%d-%s.json"), MaxClients, *FDateTime::Now().ToString())));
+			UE_LOG(LogSkylineShredder, Display, TEXT("Parkour net report: appended to %s"), *CsvPath);
+
+			if (bQuitWhenDone)
+				FPlatformMisc::RequestExit(false);
+		}
+	};
+
+	//Runs the local player through the parkour mechanics so a headless client sends realistic moves
+	class FNetBot : public TSharedFromThis<FNetBot>
+	{
+	public:
+		explicit FNetBot(UWorld* InWorld) : World(InWorld) {}
+
+		void Start()
+		{
+			TickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([This = AsShared()](float DeltaTime)
+			{
+				return This->Tick(DeltaTime);
+			}));
+		}
+
+		void Stop()
+		{
+			FTSTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		}
+
+	private:
+		TWeakObjectPtr<UWorld> World;
+		FTSTicker::FDelegateHandle TickerHandle;
+		float Time = 0.0f;
+		float GrappleTime = 0.0f;
+
+		bool Tick(float DeltaTime)
+		{
+			UWorld* CurrentWorld = World.Get();
+			if (!CurrentWorld)
+				return false;
+
+			APlayerController* Controller = CurrentWorld->GetFirstPlayerController();
+			ASkylineShredderCharacter* Character = Controller ? Cast<ASkylineShredderCharacter>(Controller->GetPawn()) : nullptr;
+			if (!Character)
+				return true;
+
+			//Run forward weaving from side to side, jump and double jump every couple of seconds and grapple in the air
+			Time += DeltaTime;
+			Character->AddScriptedInput(1.0f, FMath::Sin(Time * 0.7f));
+
+			const float JumpPhase = FMath::Fmod(Time, 2.5f);
+			const bool bWantsJump = JumpPhase < 0.1f || (JumpPhase > 0.5f && JumpPhase < 0.6f);
+			if (bWantsJump != Character->IsJumpHeld() && Character->GetPendingJumpToggles() == 0)
+				Character->QueueJumpToggle();
+
+			if (Character->IsGrappleHookAttached())
+			{
+				GrappleTime += DeltaTime;
+				if (GrappleTime > 0.75f)
+					Character->EndGrapple();
+			}
+			else if (JumpPhase > 0.8f && JumpPhase < 0.9f)
+			{
+				GrappleTime = 0.0f;
+				Character->CheckForGrapple();
+			}
+
+			return true;
+		}
+	};
+
+	static TSharedPtr<FNetBot> ActiveBot;
+
+	static void RunReport(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || !World->IsGameWorld())
+			return;
+
+		const float Duration = Args.Num() > 0 ? FMath::Max(1.0f, FCString::Atof(*Args[0])) : 30.0f;
+		const bool bQuitWhenDone = Args.Contains(TEXT("quit"));
+
+		MakeShared<FNetReport>(World, Duration, bQuitWhenDone)->Start();
+	}
+
+	static void RunBot(const TArray<FString>& Args, UWorld* World)
+	{
+		if (ActiveBot.IsValid())
+		{
+			ActiveBot->Stop();
+			ActiveBot.Reset();
+		}
+
+		const bool bEnable = Args.Num() == 0 || FCString::Atoi(*Args[0]) != 0;
+		if (bEnable && World && World->IsGameWorld())
+		{
+			ActiveBot = MakeShared<FNetBot>(World);
+			ActiveBot->Start();
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs NetReportCommand(
+	TEXT("Parkour.NetReport"),
+	TEXT("Samples the bytes per second each client uses on the server and appends them to the net report. Usage: Parkour.NetReport [Seconds=30] [quit]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ParkourNetReport::RunReport));
+
+static FAutoConsoleCommandWithWorldAndArgs NetBotCommand(
+	TEXT("Parkour.NetBot"),
+	TEXT("Drives the local player with scripted parkour input so a headless client sends realistic moves. Usage: Parkour.NetBot [1|0]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ParkourNetReport::RunBot));
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ParkourState.generated.h"
+
+//The fixed step momentum and gravity simulation of a runner, everything that has to be put back to step it again the same way
+struct FParkourSimulationState
+{
+	float Momentum = 0.0f;
+	float PreviousMomentum = 0.0f;
+	float Gravity = 0.0f;
+	float PreviousGravity = 0.0f;
+
+	//Time that has not been simulated yet
+	float Accumulator = 0.0f;
+};
+
+//What the runner is doing, only one at a time
+UENUM(BlueprintType)
+enum class EParkourState : uint8
+{
+	//Running, falling or swinging, free to start any action
+	None,
+	WallRun,
+	//Jumping off a wall, can't run on a wall again until it is over
+	WallJump,
+	Vault,
+	Climb,
+	Count UMETA(Hidden)
+};
+
+/// <summary>
+/// Which parkour state can follow which, and what each state stops the runner from doing. The table is
+/// checked at compile time, so a transition that isn't in it can't be taken.
+/// </summary>
+namespace ParkourStateTable
+{
+	struct FStateInfo
+	{
+		//The states this state can go to, a bit for each
+		uint8 Transitions;
+
+		//If the state is an action, which stops the ledge probe, grappling, vaulting and momentum and gravity building up
+		bool bInAction;
+	};
+
+	constexpr uint8 Bit(EParkourState State) { return (uint8)(1 << (uint8)State); }
+
+	constexpr FStateInfo States[] =
+	{
+		/* None */     { Bit(EParkourState::WallRun) | Bit(EParkourState::Vault) | Bit(EParkourState::Climb), false },
+		/* WallRun */  { Bit(EParkourState::None) | Bit(EParkourState::WallJump), true },
+		/* WallJump */ { Bit(EParkourState::None) | Bit(EParkourState::Vault) | Bit(EParkourState::Climb), false },
+		/* Vault */    { Bit(EParkourState::None), true },
+		/* Climb */    { Bit(EParkourState::None), true },
+	};
+
+	static_assert(UE_ARRAY_COUNT(States) == (int32)EParkourState::Count, "Every parkour state needs a row in the table");
+	static_assert((int32)EParkourState::Count <= 8, "The transitions of a state are a bit each in a uint8");
+
+	constexpr bool CanTransition(EParkourState From, EParkourState To)
+	{
+		return (States[(uint8)From].Transitions & Bit(To)) != 0;
+	}
+
+	constexpr bool IsInAction(EParkourState State)
+	{
+		return States[(uint8)State].bInAction;
+	}
+
+	static_assert(!CanTransition(EParkourState::WallJump, EParkourState::WallRun), "Jumping off a wall can't go straight back to running on one");
+	static_assert(!CanTransition(EParkourState::WallRun, EParkourState::Vault), "Vaulting can't start while wall running");
+}
@@ -0,0 +1,339 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ParkourTelemetry.h"
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
+
+namespace ParkourTelemetry
+{
+	//A column of the file, where its values are in a sample and how big each one is
+	struct FColumn
+	{
+		const TCHAR* Name;
+		int32 Offset;
+		int32 Size;
+	};
+
+	static const FColumn Columns[] =
+	{
+		{ TEXT("Time"), STRUCT_OFFSET(FParkourTelemetrySample, Time), sizeof(float) },
+		{ TEXT("FrameTime"), STRUCT_OFFSET(FParkourTelemetrySample, FrameTime), sizeof(float) },
+		{ TEXT("PositionX"), STRUCT_OFFSET(FParkourTelemetrySample, Position) + 0 * sizeof(float), sizeof(float) },
+		{ TEXT("PositionY"), STRUCT_OFFSET(FParkourTelemetrySample, Position) + 1 * sizeof(float), sizeof(float) },
+		{ TEXT("PositionZ"), STRUCT_OFFSET(FParkourTelemetrySample, Position) + 2 * sizeof(float), sizeof(float) },
+		{ TEXT("Speed"), STRUCT_OFFSET(FParkourTelemetrySample, Speed), sizeof(float) },
+		{ TEXT("Momentum"), STRUCT_OFFSET(FParkourTelemetrySample, Momentum), sizeof(float) },
+		{ TEXT("Gravity"), STRUCT_OFFSET(FParkourTelemetrySample, Gravity), sizeof(float) },
+		{ TEXT("State"), STRUCT_OFFSET(FParkourTelemetrySample, State), sizeof(EParkourState) },
+		{ TEXT("Events"), STRUCT_OFFSET(FParkourTelemetrySample, Events), sizeof(uint8) },
+	};
+
+	static const FName CompressionFormat = NAME_Zlib;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FParkourTelemetryRing
+
+FParkourTelemetryRing::FParkourTelemetryRing(uint32 InCapacity)
+{
+	const uint32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max(InCapacity, 2u));
+	Samples.SetNumZeroed(Capacity);
+	SampleData = Samples.GetData();
+	Mask = Capacity - 1;
+}
+
+int32 FParkourTelemetryRing::Pop(FParkourTelemetrySample* OutSamples, int32 MaxSamples)
+{
+	const uint32 Tail = ReadIndex.load(std::memory_order_relaxed);
+	const uint32 Available = WriteIndex.load(std::memory_order_acquire) - Tail;
+	const int32 Count = (int32)FMath::Min<uint32>(Available, (uint32)FMath::Max(MaxSamples, 0));
+
+	for (int32 Index = 0; Index < Count; Index++)
+		OutSamples[Index] = SampleData[(Tail + Index) & Mask];
+
+	//Only now can the recording thread reuse the slots
+	ReadIndex.store(Tail + Count, std::memory_order_release);
+	return Count;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FParkourTelemetryWriter
+
+FParkourTelemetryWriter::FParkourTelemetryWriter(const FString& InPath, const FString& MapName, float InStartTime, uint32 Capacity)
+	: Ring(Capacity)
+	, Path(InPath)
+	, StartTime(InStartTime)
+{
+	File.Reset(IFileManager::Get().CreateFileWriter(*Path));
+	if (!File)
+		return;
+
+	//The header says which columns there are, so readers can skip ones they don't know
+	uint32 FileMagic = Magic;
+	uint32 Version = CurrentVersion;
+	FString Map = MapName;
+	int32 NumColumns = UE_ARRAY_COUNT(ParkourTelemetry::Columns);
+	*File << FileMagic << Version << Map << NumColumns;
+	for (const ParkourTelemetry::FColumn& Column : ParkourTelemetry::Columns)
+	{
+		FString Name = Column.Name;
+		int32 Size = Column.Size;
+		*File << Name << Size;
+	}
+
+	Chunk.Reserve(ChunkSize);
+	Thread = FRunnableThread::Create(this, TEXT("ParkourTelemetryWriter"), 0, TPri_BelowNormal);
+}
+
+FParkourTelemetryWriter::~FParkourTelemetryWriter()
+{
+	//The thread writes out what is left in the ring before it finishes
+	if (Thread)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (File)
+		File->Close();
+}
+
+uint32 FParkourTelemetryWriter::Run()
+{
+	while (!bStopping)
+	{
+		Drain();
+		FPlatformProcess::Sleep(FlushInterval);
+	}
+
+	Drain();
+	if (Chunk.Num() > 0)
+		WriteChunk();
+
+	return 0;
+}
+
+void FParkourTelemetryWriter::Drain()
+{
+	//Full chunks are written as they fill, the last part waits in the chunk for more samples
+	for (;;)
+	{
+		const int32 Start = Chunk.Num();
+		Chunk.SetNumUninitialized(ChunkSize, false);
+		const int32 Count = Ring.Pop(Chunk.GetData() + Start, ChunkSize - Start);
+		Chunk.SetNum(Start + Count, false);
+
+		if (Chunk.Num() < ChunkSize)
+			return;
+
+		WriteChunk();
+	}
+}
+
+void FParkourTelemetryWriter::WriteChunk()
+{
+	int32 NumSamples = Chunk.Num();
+	*File << NumSamples;
+
+	const uint8* SampleBytes = reinterpret_cast<const uint8*>(Chunk.GetData());
+	for (const ParkourTelemetry::FColumn& Column : ParkourTelemetry::Columns)
+	{
+		//Pull the column out of the samples, values next to each other compress far better than whole samples
+		ColumnBytes.SetNumUninitialized(NumSamples * Column.Size, false);
+		for (int32 Index = 0; Index < NumSamples; Index++)
+			FMemory::Memcpy(ColumnBytes.GetData() + Index * Column.Size, SampleBytes + Index * sizeof(FParkourTelemetrySample) + Column.Offset, Column.Size);
+
+		int32 UncompressedSize = ColumnBytes.Num();
+		int32 CompressedSize = FCompression::CompressMemoryBound(ParkourTelemetry::CompressionFormat, UncompressedSize);
+		CompressedBytes.SetNumUninitialized(CompressedSize, false);
+
+		//A column that doesn't compress is stored as it is
+		uint8 bCompressed = FCompression::CompressMemory(ParkourTelemetry::CompressionFormat, CompressedBytes.GetData(), CompressedSize, ColumnBytes.GetData(), UncompressedSize)
+			&& CompressedSize < UncompressedSize;
+		TArray<uint8>& Bytes = bCompressed ? CompressedBytes : ColumnBytes;
+		int32 StoredSize = bCompressed ? CompressedSize : UncompressedSize;
+
+		*File << bCompressed << UncompressedSize << StoredSize;
+		File->Serialize(Bytes.GetData(), StoredSize);
+	}
+
+	NumWritten.fetch_add(NumSamples, std::memory_order_relaxed);
+	Chunk.Reset();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FParkourTelemetrySession
+
+FString FParkourTelemetrySession::GetTelemetryDirectory()
+{
+	return FPaths::ProjectSavedDir() / TEXT("Telemetry");
+}
+
+FString FParkourTelemetrySession::GetTelemetryPath(const FString& SessionName)
+{
+	return GetTelemetryDirectory() / (FPaths::MakeValidFileName(SessionName) + TEXT(".ptel"));
+}
+
+bool FParkourTelemetrySession::Load(const FString& InPath)
+{
+	TUniquePtr<FArchive> File(IFileManager::Get().CreateFileReader(*InPath));
+	if (!File)
+		return false;
+
+	uint32 FileMagic = 0;
+	uint32 Version = 0;
+	int32 NumColumns = 0;
+	*File << FileMagic << Version;
+	if (FileMagic != FParkourTelemetryWriter::Magic || Version != FParkourTelemetryWriter::CurrentVersion)
+		return false;
+
+	*File << MapName << NumColumns;
+
+	//Match the file's columns to the ones this version knows by name
+	TArray<const ParkourTelemetry::FColumn*> FileColumns;
+	TArray<int32> FileColumnSizes;
+	for (int32 Index = 0; Index < NumColumns && !File->IsError(); Index++)
+	{
+		FString Name;
+		int32 Size = 0;
+		*File << Name << Size;
+
+		const ParkourTelemetry::FColumn* Known = nullptr;
+		for (const ParkourTelemetry::FColumn& Column : ParkourTelemetry::Columns)
+		{
+			if (Name == Column.Name && Size == Column.Size)
+				Known = &Column;
+		}
+		FileColumns.Add(Known);
+		FileColumnSizes.Add(Size);
+	}
+
+	Samples.Reset();
+	TArray<uint8> StoredBytes;
+	TArray<uint8> ColumnBytes;
+	while (!File->AtEnd() && !File->IsError())
+	{
+		int32 NumSamples = 0;
+		*File << NumSamples;
+		if (NumSamples <= 0)
+			return false;
+
+		const int32 First = Samples.Num();
+		Samples.AddDefaulted(NumSamples);
+		uint8* SampleBytes = reinterpret_cast<uint8*>(Samples.GetData() + First);
+
+		for (int32 Index = 0; Index < FileColumns.Num(); Index++)
+		{
+			uint8 bCompressed = 0;
+			int32 UncompressedSize = 0;
+			int32 StoredSize = 0;
+			*File << bCompressed << UncompressedSize << StoredSize;
+			if (File->IsError() || StoredSize < 0 || UncompressedSize != NumSamples * FileColumnSizes[Index])
+				return false;
+
+			StoredBytes.SetNumUninitialized(StoredSize, false);
+			File->Serialize(StoredBytes.GetData(), StoredSize);
+
+			const ParkourTelemetry::FColumn* Column = FileColumns[Index];
+			if (!Column)
+				continue;
+
+			ColumnBytes.SetNumUninitialized(UncompressedSize, false);
+			if (bCompressed)
+			{
+				if (!FCompression::UncompressMemory(ParkourTelemetry::CompressionFormat, ColumnBytes.GetData(), UncompressedSize, StoredBytes.GetData(), StoredSize))
+					return false;
+			}
+			else if (StoredSize == UncompressedSize)
+			{
+				FMemory::Memcpy(ColumnBytes.GetData(), StoredBytes.GetData(), StoredSize);
+			}
+			else
+			{
+				return false;
+			}
+
+			for (int32 Sample = 0; Sample < NumSamples; Sample++)
+				FMemory::Memcpy(SampleBytes + Sample * sizeof(FParkourTelemetrySample) + Column->Offset, ColumnBytes.GetData() + Sample * Column->Size, Column->Size);
+		}
+	}
+
+	return !File->IsError();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Sessions
+
+bool ParkourTelemetry::StartSession(ASkylineShredderCharacter& Character, const FString& SessionName)
+{
+	//Starting again finishes the session that was going
+	StopSession(Character);
+
+	UWorld* World = Character.GetWorld();
+	const FString Path = FParkourTelemetrySession::GetTelemetryPath(SessionName);
+	TSharedPtr<FParkourTelemetryWriter> Writer = MakeShared<FParkourTelemetryWriter>(Path, UWorld::RemovePIEPrefix(World->GetMapName()), World->GetTimeSeconds());
+	if (!Writer->IsOpen())
+	{
+		UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour telemetry: couldn't open %s"), *Path);
+		return false;
+	}
+
+	Character.SetTelemetry(Writer);
+	UE_LOG(LogSkylineShredder, Display, TEXT("Parkour telemetry: recording %s"), *Path);
+	return true;
+}
+
+void ParkourTelemetry::StopSession(ASkylineShredderCharacter& Character)
+{
+	TSharedPtr<FParkourTelemetryWriter> Writer = Character.GetTelemetry();
+	if (!Writer.IsValid())
+		return;
+
+	Character.SetTelemetry(nullptr);
+
+	//Destroying the writer writes out the rest of the ring and closes the file
+	const FString Path = Writer->GetPath();
+	const uint32 NumDropped = Writer->GetNumDropped();
+	Writer.Reset();
+	UE_LOG(LogSkylineShredder, Display, TEXT("Parkour telemetry: saved %s, %u samples dropped"), *Path, NumDropped);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Console command
+
+namespace ParkourTelemetry
+{
+	//Starts or stops a session of the local player by hand, whether or not sessions are recorded for every run
+	static void Record(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World || !World->IsGameWorld())
+			return;
+
+		APlayerController* Controller = World->GetFirstPlayerController();
+		ASkylineShredderCharacter* Character = Controller ? Cast<ASkylineShredderCharacter>(Controller->GetPawn()) : nullptr;
+		if (!Character)
+		{
+			UE_LOG(LogSkylineShredder, Warning, TEXT("Parkour telemetry: there is no player character to record"));
+			return;
+		}
+
+		if (Args.Num() == 0 || Args[0] == TEXT("stop"))
+			StopSession(*Character);
+		else
+			StartSession(*Character, Args[0]);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs TelemetryCommand(
+	TEXT("Parkour.Telemetry"),
+	TEXT("Records the local player's position, speed, momentum, gravity, parkour state, pad hits, grapple attaches and frame time every frame until stopped. Usage: Parkour.Telemetry <Name> | Parkour.Telemetry stop"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ParkourTelemetry::Record));
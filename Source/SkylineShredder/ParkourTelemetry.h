@@ -0,0 +1,171 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "ParkourState.h"
+#include <atomic>
+
+class FRunnableThread;
+class ASkylineShredderCharacter;
+
+//What a runner was doing in one frame
+struct SKYLINESHREDDER_API FParkourTelemetrySample
+{
+	//Things that happened to the runner since the last sample
+	enum : uint8
+	{
+		EVENT_PadHit = 1 << 0,
+		EVENT_GrappleAttach = 1 << 1
+	};
+
+	//Seconds since the session started, and how long the frame was
+	float Time = 0.0f;
+	float FrameTime = 0.0f;
+
+	FVector3f Position = FVector3f::ZeroVector;
+	float Speed = 0.0f;
+	float Momentum = 0.0f;
+	float Gravity = 0.0f;
+	EParkourState State = EParkourState::None;
+	uint8 Events = 0;
+};
+
+static_assert(std::is_trivially_copyable<FParkourTelemetrySample>::value, "Telemetry samples are copied through the ring buffer, they can't own anything");
+
+/// <summary>
+/// A fixed size ring of samples with one thread pushing and one thread popping, and no locks between them.
+/// Pushing is a copy and two atomics, and a sample is dropped rather than waited on when the ring is full.
+/// </summary>
+class SKYLINESHREDDER_API FParkourTelemetryRing
+{
+public:
+	//The capacity is rounded up to a power of two
+	explicit FParkourTelemetryRing(uint32 InCapacity);
+
+	//Only called from the thread recording the samples
+	FORCEINLINE bool TryPush(const FParkourTelemetrySample& Sample)
+	{
+		const uint32 Head = WriteIndex.load(std::memory_order_relaxed);
+		if (Head - ReadIndex.load(std::memory_order_acquire) > Mask)
+		{
+			Dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		SampleData[Head & Mask] = Sample;
+		WriteIndex.store(Head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// Copies out the oldest samples, only called from the thread writing them out
+	/// </summary>
+	/// <returns>how many samples were copied</returns>
+	int32 Pop(FParkourTelemetrySample* OutSamples, int32 MaxSamples);
+
+	uint32 GetNumDropped() const { return Dropped.load(std::memory_order_relaxed); }
+
+private:
+	TArray<FParkourTelemetrySample> Samples;
+	FParkourTelemetrySample* SampleData;
+	uint32 Mask;
+
+	//On their own cache lines so the two threads don't keep taking the line off each other. Dropped is written
+	//by the recording thread, so it is kept off the line the writer thread reads and writes ReadIndex on
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> WriteIndex{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> ReadIndex{ 0 };
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> Dropped{ 0 };
+};
+
+/// <summary>
+/// Records a telemetry session to a file. The game thread only pushes samples into the ring, a background
+/// thread drains it every so often into chunks and writes each chunk a column at a time, with every column
+/// compressed on its own. The file is finished when the writer is destroyed.
+/// </summary>
+class SKYLINESHREDDER_API FParkourTelemetryWriter : public FRunnable
+{
+public:
+	static constexpr uint32 Magic = 0x4C455450; // "PTEL"
+	static constexpr uint32 CurrentVersion = 1;
+
+	//Samples in a chunk, and seconds between draining the ring
+	static constexpr int32 ChunkSize = 4096;
+	static constexpr float FlushInterval = 0.1f;
+
+	/// <summary>
+	/// Opens the file and starts the writer thread
+	/// </summary>
+	/// <param name="InPath">the file to write</param>
+	/// <param name="MapName">the map the session is on</param>
+	/// <param name="InStartTime">the world time the session starts at, sample times are from this</param>
+	/// <param name="Capacity">how many samples the ring holds, a few seconds of frames is plenty</param>
+	FParkourTelemetryWriter(const FString& InPath, const FString& MapName, float InStartTime, uint32 Capacity = 8192);
+	virtual ~FParkourTelemetryWriter();
+
+	bool IsOpen() const { return File.IsValid(); }
+
+	FORCEINLINE void Record(const FParkourTelemetrySample& Sample) { Ring.TryPush(Sample); }
+
+	float GetStartTime() const { return StartTime; }
+	const FString& GetPath() const { return Path; }
+	int64 GetNumWritten() const { return NumWritten.load(std::memory_order_relaxed); }
+	uint32 GetNumDropped() const { return Ring.GetNumDropped(); }
+
+	virtual uint32 Run() override;
+	virtual void Stop() override { bStopping = true; }
+
+private:
+	FParkourTelemetryRing Ring;
+	FString Path;
+	float StartTime;
+
+	TUniquePtr<FArchive> File;
+	FRunnableThread* Thread = nullptr;
+	std::atomic<bool> bStopping{ false };
+	std::atomic<int64> NumWritten{ 0 };
+
+	//Only touched by the writer thread
+	TArray<FParkourTelemetrySample> Chunk;
+	TArray<uint8> ColumnBytes;
+	TArray<uint8> CompressedBytes;
+
+	void Drain();
+	void WriteChunk();
+};
+
+/// <summary>
+/// A telemetry session loaded back for analysis. Columns the file doesn't have are left at their defaults,
+/// and columns this version doesn't know are skipped.
+/// </summary>
+struct SKYLINESHREDDER_API FParkourTelemetrySession
+{
+	FString MapName;
+	TArray<FParkourTelemetrySample> Samples;
+
+	//The folder sessions are saved in, Saved/Telemetry
+	static FString GetTelemetryDirectory();
+
+	//The path of a session saved with a name
+	static FString GetTelemetryPath(const FString& SessionName);
+
+	/// <summary>
+	/// Loads a session
+	/// </summary>
+	/// <returns>false if the file is missing, isn't a telemetry session or is cut short</returns>
+	bool Load(const FString& InPath);
+};
+
+namespace ParkourTelemetry
+{
+	/// <summary>
+	/// Starts recording a character into a new session, finishing the session it was recording
+	/// </summary>
+	/// <param name="SessionName">the name the session is saved under, see FParkourTelemetrySession::GetTelemetryPath</param>
+	/// <returns>false if the session file couldn't be opened</returns>
+	SKYLINESHREDDER_API bool StartSession(ASkylineShredderCharacter& Character, const FString& SessionName);
+
+	//Finishes the session a character is recording and writes out the rest of it, does nothing if it isn't recording
+	SKYLINESHREDDER_API void StopSession(ASkylineShredderCharacter& Character);
+}
@@ -0,0 +1,176 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PredictiveStreamingSubsystem.h"
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "GrappleComponent.h"
+#include "EngineUtils.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/LevelStreamingVolume.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+void UPredictiveStreamingSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//The volumes are in the persistent level, so their bounds are known before anything is streamed in
+	for (ULevelStreaming* StreamingLevel : InWorld.GetStreamingLevels())
+	{
+		if (!StreamingLevel || StreamingLevel->ShouldBeAlwaysLoaded())
+			continue;
+
+		const FString LevelName = UWorld::RemovePIEPrefix(StreamingLevel->GetWorldAssetPackageName());
+		FBox Bounds(ForceInit);
+		for (TActorIterator<ALevelStreamingVolume> It(&InWorld); It; ++It)
+		{
+			if (It->StreamingLevelNames.ContainsByPredicate([&LevelName](const FName& Name) { return UWorld::RemovePIEPrefix(Name.ToString()) == LevelName; }))
+				Bounds += It->GetComponentsBoundingBox(true);
+		}
+
+		if (!Bounds.IsValid)
+			continue;
+
+		FStreamingCell& Cell = Cells.AddDefaulted_GetRef();
+		Cell.Level = StreamingLevel;
+		Cell.Bounds = Bounds;
+		Cell.bHadDistanceStreamingDisabled = StreamingLevel->bDisableDistanceStreaming;
+
+		//The volumes would only load the level once the camera is inside them
+		StreamingLevel->bDisableDistanceStreaming = true;
+	}
+
+	UE_LOG(LogSkylineShredder, Log, TEXT("PredictiveStreaming: streaming %d sublevels of %s ahead of the players"), Cells.Num(), *InWorld.GetMapName());
+}
+
+void UPredictiveStreamingSubsystem::Deinitialize()
+{
+	for (FStreamingCell& Cell : Cells)
+	{
+		if (ULevelStreaming* Level = Cell.Level.Get())
+			Level->bDisableDistanceStreaming = Cell.bHadDistanceStreamingDisabled;
+	}
+	Cells.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId UPredictiveStreamingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPredictiveStreamingSubsystem, STATGROUP_Parkour);
+}
+
+float UPredictiveStreamingSubsystem::GetTimeToArrival(const ULevelStreaming* Level) const
+{
+	const FStreamingCell* Found = Cells.FindByPredicate([Level](const FStreamingCell& Cell) { return Cell.Level == Level; });
+	return Found ? Found->TimeToArrival : -1.0f;
+}
+
+void UPredictiveStreamingSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.0f)
+		return;
+	TimeUntilUpdate = UpdateInterval;
+
+	for (FStreamingCell& Cell : Cells)
+		Cell.TimeToArrival = -1.0f;
+
+	//Clients only have their own players, the server has everyone's and keeps what any of them need
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* Controller = It->Get();
+		const APawn* Pawn = Controller ? Controller->GetPawn() : nullptr;
+		if (!Pawn)
+			continue;
+
+		Path.Reset();
+		ProjectPath(*Pawn, Path);
+
+		for (FStreamingCell& Cell : Cells)
+		{
+			const float Arrival = FindArrival(Cell.Bounds, Path);
+			if (Arrival >= 0.0f && (Cell.TimeToArrival < 0.0f || Arrival < Cell.TimeToArrival))
+				Cell.TimeToArrival = Arrival;
+		}
+	}
+
+	for (FStreamingCell& Cell : Cells)
+		ApplyCell(Cell);
+}
+
+void UPredictiveStreamingSubsystem::ProjectPath(const APawn& Pawn, TArray<FPathPoint>& OutPath) const
+{
+	const FVector Start = Pawn.GetActorLocation();
+	const FVector Velocity = Pawn.GetVelocity();
+
+	//Only along the ground, the city is streamed in columns
+	FVector Direction(Velocity.X, Velocity.Y, 0.0f);
+	float Speed = Direction.Size();
+	if (Speed > 100.0f)
+		Direction /= Speed;
+	else
+		Speed = 0.0f;
+
+	float Spread = FreeSpread;
+	if (const ASkylineShredderCharacter* Runner = Cast<ASkylineShredderCharacter>(&Pawn))
+	{
+		//A moving runner keeps its momentum, so it only gets faster until it stops
+		if (Speed > 0.0f)
+			Speed = FMath::Max(Speed, Runner->BaseSpeed + Runner->GetInterpolatedMomentum());
+
+		if (Runner->IsWallRunning())
+		{
+			Spread = WallRunSpread;
+		}
+		else if (Runner->IsGrappleHookAttached())
+		{
+			//Letting go of the grapple throws the runner forward with more momentum
+			Speed += Runner->GetGrapple()->ReleaseMomentum;
+			Spread = GrappleSpread;
+		}
+	}
+
+	const float SpreadSpeed = FMath::Max(Speed, IdleSpreadSpeed) * Spread;
+	const float Step = FMath::Max(PathStep, 0.05f);
+
+	OutPath.Add({ Start, MinRadius, 0.0f });
+	for (float Time = Step; Time <= LookAheadTime; Time += Step)
+		OutPath.Add({ Start + Direction * Speed * Time, MinRadius + SpreadSpeed * Time, Time });
+}
+
+float UPredictiveStreamingSubsystem::FindArrival(const FBox& Bounds, const TArray<FPathPoint>& InPath)
+{
+	for (const FPathPoint& Point : InPath)
+	{
+		if (FMath::SphereAABBIntersection(Point.Location, FMath::Square(Point.Radius), Bounds))
+			return Point.Time;
+	}
+
+	return -1.0f;
+}
+
+void UPredictiveStreamingSubsystem::ApplyCell(FStreamingCell& Cell)
+{
+	ULevelStreaming* Level = Cell.Level.Get();
+	if (!Level)
+		return;
+
+	const bool bWanted = Cell.TimeToArrival >= 0.0f;
+	Cell.UnwantedTime = bWanted ? 0.0f : Cell.UnwantedTime + UpdateInterval;
+
+	//A sublevel nobody is heading for stays as it is for a while before it is unloaded
+	const bool bLoad = bWanted || (Level->ShouldBeLoaded() && Cell.UnwantedTime < UnloadDelay);
+	const bool bVisible = bLoad && ((bWanted && Cell.TimeToArrival <= VisibleTime) || Level->GetShouldBeVisibleFlag());
+
+	//The sooner a player gets there the sooner it is streamed, in tenths of a second
+	const int32 Priority = bWanted ? FMath::RoundToInt((LookAheadTime - Cell.TimeToArrival) * 10.0f) + 1 : 0;
+	if (Level->GetPriority() != Priority)
+		Level->SetPriority(Priority);
+
+	if (Level->ShouldBeLoaded() != bLoad)
+		Level->SetShouldBeLoaded(bLoad);
+	if (Level->GetShouldBeVisibleFlag() != bVisible)
+		Level->SetShouldBeVisible(bVisible);
+}
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PredictiveStreamingSubsystem.generated.h"
+
+class APawn;
+class ULevelStreaming;
+
+/// <summary>
+/// Streams the city sublevels in ahead of the players instead of only around them. Each player's path is
+/// projected a few seconds ahead from their velocity, momentum and what they are doing, and every sublevel
+/// the path reaches is loaded, sooner ones at a higher priority, and made visible just before the player gets
+/// there. Only sublevels with level streaming volumes are streamed this way, the volumes give their bounds,
+/// and the engine's own volume streaming is turned off for them.
+/// </summary>
+UCLASS(config = Game)
+class SKYLINESHREDDER_API UPredictiveStreamingSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Cells.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+
+	/// <summary>
+	/// Gets how many seconds until a player reaches a sublevel, or a negative number if none will within the look ahead
+	/// </summary>
+	float GetTimeToArrival(const ULevelStreaming* Level) const;
+
+	//Seconds ahead the paths are projected, and the seconds between points along them
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float LookAheadTime = 4.0f;
+
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float PathStep = 0.25f;
+
+	//Seconds between projecting the paths
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float UpdateInterval = 0.2f;
+
+	//How close a sublevel has to be in time before it is made visible
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float VisibleTime = 1.5f;
+
+	//Seconds a sublevel stays loaded after no path reaches it, so turning around doesn't load it again
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float UnloadDelay = 5.0f;
+
+	//How far around the player a sublevel always counts as reached
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float MinRadius = 3000.0f;
+
+	//How much wider the path gets for each cm along it, running freely, wall running and swinging on the grapple.
+	//Wall runs go along the wall, while a grapple swing can let go in any direction
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float FreeSpread = 0.35f;
+
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float WallRunSpread = 0.15f;
+
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float GrappleSpread = 0.6f;
+
+	//The speed the path widens at for a player standing still, who could set off anywhere
+	UPROPERTY(Config, EditAnywhere, Category = Streaming)
+	float IdleSpreadSpeed = 600.0f;
+
+private:
+	//A sublevel and the bounds of its streaming volumes
+	struct FStreamingCell
+	{
+		TWeakObjectPtr<ULevelStreaming> Level;
+		FBox Bounds;
+		float TimeToArrival = -1.0f;
+		float UnwantedTime = 0.0f;
+		bool bHadDistanceStreamingDisabled = false;
+	};
+
+	struct FPathPoint
+	{
+		FVector Location;
+		float Radius;
+		float Time;
+	};
+
+	TArray<FStreamingCell> Cells;
+	TArray<FPathPoint> Path;
+	float TimeUntilUpdate = 0.0f;
+
+	//Adds the points a pawn is expected to pass through, in time order
+	void ProjectPath(const APawn& Pawn, TArray<FPathPoint>& OutPath) const;
+
+	//Gets the first time along a path that reaches the bounds, or a negative number if it doesn't
+	static float FindArrival(const FBox& Bounds, const TArray<FPathPoint>& InPath);
+
+	void ApplyCell(FStreamingCell& Cell);
+};
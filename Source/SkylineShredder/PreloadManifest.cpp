@@ -0,0 +1,11 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PreloadManifest.h"
+#include "Misc/PackageName.h"
+
+FString UPreloadManifest::GetManifestPath(const FString& MapPackageName)
+{
+	const FString AssetName = FPackageName::GetShortName(MapPackageName) + TEXT("_Preload");
+	return FPackageName::GetLongPackagePath(MapPackageName) / AssetName + TEXT(".") + AssetName;
+}
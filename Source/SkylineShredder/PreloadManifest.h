@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "PreloadManifest.generated.h"
+
+/// <summary>
+/// The assets of a map's pads and grapple points, including the ones in its sublevels, made by the
+/// PreloadManifest commandlet. The preload subsystem loads them in the background as the map starts on every
+/// machine that draws it, so they are in memory before the sublevels holding them stream in. The manifest for a map lives next to it as
+/// <MapName>_Preload, and is a primary asset the asset manager always cooks since it is only found by
+/// its path, see DefaultGame.ini
+/// </summary>
+UCLASS()
+class SKYLINESHREDDER_API UPreloadManifest : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	//Meshes, materials, animation blueprints and animations, soft so the manifest doesn't load them itself
+	UPROPERTY(VisibleAnywhere, Category = Preload)
+	TArray<FSoftObjectPath> Assets;
+
+	/// <summary>
+	/// Gets the object path the preload manifest for a map is saved at
+	/// </summary>
+	/// <param name="MapPackageName">the long package name of the map</param>
+	static FString GetManifestPath(const FString& MapPackageName);
+};
@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PreloadManifestCommandlet.h"
+#include "SkylineShredder.h"
+#include "BoostPad.h"
+#include "BouncePad.h"
+#include "GrapplePointSubsystem.h"
+#include "PreloadManifest.h"
+#include "Animation/AnimationAsset.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/Level.h"
+#include "Engine/LevelStreaming.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "Materials/MaterialInterface.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+#include "UObject/SavePackage.h"
+
+UPreloadManifestCommandlet::UPreloadManifestCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UPreloadManifestCommandlet::Main(const FString& Params)
+{
+	TArray<FString> Tokens;
+	TArray<FString> Switches;
+	TMap<FString, FString> ParamValues;
+	ParseCommandLine(*Params, Tokens, Switches, ParamValues);
+
+	//Make the manifests of the city levels unless other maps were asked for
+	FString MapsParam = ParamValues.FindRef(TEXT("Maps"));
+	if (MapsParam.IsEmpty())
+		MapsParam = TEXT("/Game/Maps/CityBlockout_Level,/Game/Maps/Main_Level");
+
+	TArray<FString> Maps;
+	MapsParam.ParseIntoArray(Maps, TEXT(","));
+
+	int32 NumFailed = 0;
+	for (const FString& Map : Maps)
+	{
+		if (!BuildManifest(Map))
+			NumFailed++;
+	}
+
+	return NumFailed == 0 ? 0 : 1;
+}
+
+void UPreloadManifestCommandlet::GatherLevelAssets(ULevel* Level, TSet<FSoftObjectPath>& OutAssets) const
+{
+	for (AActor* Actor : Level->Actors)
+	{
+		if (!Actor || !(Actor->IsA<ABoostPad>() || Actor->IsA<ABouncePad>() || UGrapplePointSubsystem::IsGrapplePointActor(Actor)))
+			continue;
+
+		TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+		for (UPrimitiveComponent* Primitive : Primitives)
+		{
+			TArray<UMaterialInterface*> Materials;
+			Primitive->GetUsedMaterials(Materials);
+			for (UMaterialInterface* Material : Materials)
+			{
+				if (Material)
+					OutAssets.Add(FSoftObjectPath(Material));
+			}
+
+			if (const UStaticMeshComponent* StaticMesh = Cast<UStaticMeshComponent>(Primitive))
+			{
+				if (StaticMesh->GetStaticMesh())
+					OutAssets.Add(FSoftObjectPath(StaticMesh->GetStaticMesh()));
+			}
+			else if (const USkeletalMeshComponent* SkeletalMesh = Cast<USkeletalMeshComponent>(Primitive))
+			{
+				if (SkeletalMesh->SkeletalMesh)
+					OutAssets.Add(FSoftObjectPath(SkeletalMesh->SkeletalMesh));
+				if (SkeletalMesh->AnimClass)
+					OutAssets.Add(FSoftObjectPath(SkeletalMesh->AnimClass.Get()));
+				if (SkeletalMesh->AnimationData.AnimToPlay)
+					OutAssets.Add(FSoftObjectPath(SkeletalMesh->AnimationData.AnimToPlay));
+			}
+		}
+	}
+}
+
+bool UPreloadManifestCommandlet::BuildManifest(const FString& MapPackageName) const
+{
+	UPackage* MapPackage = LoadPackage(nullptr, *MapPackageName, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if (!World)
+	{
+		UE_LOG(LogSkylineShredder, Error, TEXT("PreloadManifest: could not load map %s"), *MapPackageName);
+		return false;
+	}
+
+	TSet<FSoftObjectPath> Assets;
+	GatherLevelAssets(World->PersistentLevel, Assets);
+
+	//The sublevels are what the manifest is mostly for, their assets would otherwise only load as they stream in
+	for (ULevelStreaming* StreamingLevel : World->GetStreamingLevels())
+	{
+		UPackage* LevelPackage = StreamingLevel ? LoadPackage(nullptr, *StreamingLevel->GetWorldAssetPackageName(), LOAD_None) : nullptr;
+		UWorld* LevelWorld = LevelPackage ? UWorld::FindWorldInPackage(LevelPackage) : nullptr;
+		if (LevelWorld)
+			GatherLevelAssets(LevelWorld->PersistentLevel, Assets);
+	}
+
+	//Sorted so the manifest only changes when the assets do
+	TArray<FSoftObjectPath> SortedAssets = Assets.Array();
+	SortedAssets.Sort([](const FSoftObjectPath& A, const FSoftObjectPath& B) { return A.ToString() < B.ToString(); });
+
+	//Create or replace the manifest next to the map
+	const FString ObjectPath = UPreloadManifest::GetManifestPath(MapPackageName);
+	const FString PackageName = FPackageName::ObjectPathToPackageName(ObjectPath);
+	UPackage* Package = CreatePackage(*PackageName);
+	Package->FullyLoad();
+
+	const FString AssetName = FPackageName::ObjectPathToObjectName(ObjectPath);
+	UPreloadManifest* Manifest = FindObject<UPreloadManifest>(Package, *AssetName);
+	if (!Manifest)
+		Manifest = NewObject<UPreloadManifest>(Package, *AssetName, RF_Public | RF_Standalone);
+
+	Manifest->Assets = MoveTemp(SortedAssets);
+	Package->MarkPackageDirty();
+
+	bool bSaved = false;
+#if WITH_EDITOR
+	const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+	FSavePackageArgs SaveArgs;
+	SaveArgs.TopLevelFlags = RF_Public | RF_Standalone;
+	bSaved = UPackage::SavePackage(Package, Manifest, *Filename, SaveArgs);
+#endif
+
+	UE_LOG(LogSkylineShredder, Display, TEXT("PreloadManifest: %s has %d assets, %s %s"), *MapPackageName, Manifest->Assets.Num(),
+		bSaved ? TEXT("saved") : TEXT("failed to save"), *PackageName);
+	return bSaved;
+}
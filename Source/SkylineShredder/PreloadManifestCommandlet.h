@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PreloadManifestCommandlet.generated.h"
+
+/// <summary>
+/// Makes the preload manifest for each map from the pads and grapple points in it and its sublevels.
+/// Usage: UnrealEditor-Cmd SkylineShredder.uproject -run=PreloadManifest [-Maps=/Game/Maps/A,/Game/Maps/B]
+/// </summary>
+UCLASS()
+class UPreloadManifestCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UPreloadManifestCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	/// <summary>
+	/// Adds the assets of every pad and grapple point in the level
+	/// </summary>
+	void GatherLevelAssets(class ULevel* Level, TSet<FSoftObjectPath>& OutAssets) const;
+
+	/// <summary>
+	/// Makes and saves the preload manifest for one map
+	/// </summary>
+	/// <returns>true if the manifest was saved</returns>
+	bool BuildManifest(const FString& MapPackageName) const;
+};
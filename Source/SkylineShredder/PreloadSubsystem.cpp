@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PreloadSubsystem.h"
+#include "SkylineShredder.h"
+#include "SkylineShredderGameMode.h"
+#include "PreloadManifest.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/PackageName.h"
+
+bool UPreloadSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	//The manifest is meshes, materials and animations, which a dedicated server has no use for
+	if (!Super::ShouldCreateSubsystem(Outer) || IsRunningDedicatedServer())
+		return false;
+
+	const UWorld* World = Cast<UWorld>(Outer);
+	return World && World->IsGameWorld();
+}
+
+void UPreloadSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	UWorld* World = GetWorld();
+	LoadStartTime = FPlatformTime::Seconds();
+
+	//Clients don't have the game mode, so the runner comes from the class the map's game mode would use
+	const AWorldSettings* WorldSettings = World->GetWorldSettings(false, false);
+	const TSubclassOf<AGameModeBase> GameModeClass = WorldSettings ? WorldSettings->DefaultGameMode : nullptr;
+	const ASkylineShredderGameMode* GameMode = GameModeClass && GameModeClass->IsChildOf<ASkylineShredderGameMode>()
+		? GameModeClass->GetDefaultObject<ASkylineShredderGameMode>() : GetDefault<ASkylineShredderGameMode>();
+
+	//The runner and the map's manifest are loaded first, then the assets the manifest lists
+	TArray<FSoftObjectPath> Paths;
+	if (!GameMode->RunnerPawnClass.IsNull())
+		Paths.Add(GameMode->RunnerPawnClass.ToSoftObjectPath());
+
+	ManifestPath = UPreloadManifest::GetManifestPath(UWorld::RemovePIEPrefix(World->GetOutermost()->GetName()));
+	if (FPackageName::DoesPackageExist(FPackageName::ObjectPathToPackageName(ManifestPath)))
+		Paths.Add(FSoftObjectPath(ManifestPath));
+
+	if (Paths.Num() == 0)
+		return;
+
+	RunnerHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Paths,
+		FStreamableDelegate::CreateUObject(this, &UPreloadSubsystem::HandleRunnerLoaded), FStreamableManager::AsyncLoadHighPriority);
+}
+
+void UPreloadSubsystem::Deinitialize()
+{
+	//Let go of everything so the next map only keeps what it needs
+	if (RunnerHandle.IsValid())
+		RunnerHandle->CancelHandle();
+	if (PreloadHandle.IsValid())
+		PreloadHandle->CancelHandle();
+	RunnerHandle.Reset();
+	PreloadHandle.Reset();
+
+	Super::Deinitialize();
+}
+
+void UPreloadSubsystem::HandleRunnerLoaded()
+{
+	bRunnerLoaded = true;
+	UE_LOG(LogSkylineShredder, Log, TEXT("Preload: runner and manifest loaded in %.1f ms"), (FPlatformTime::Seconds() - LoadStartTime) * 1000.0);
+
+	//Then the pads and grapple points, at normal priority behind anything the map itself is loading
+	const UPreloadManifest* Manifest = FindObject<UPreloadManifest>(nullptr, *ManifestPath);
+	if (!Manifest || Manifest->Assets.Num() == 0)
+		return;
+
+	PreloadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Manifest->Assets,
+		FStreamableDelegate::CreateUObject(this, &UPreloadSubsystem::HandlePreloadLoaded));
+}
+
+void UPreloadSubsystem::HandlePreloadLoaded()
+{
+	TArray<UObject*> Loaded;
+	if (PreloadHandle.IsValid())
+		PreloadHandle->GetLoadedAssets(Loaded);
+
+	UE_LOG(LogSkylineShredder, Log, TEXT("Preload: %d preloaded assets loaded in %.1f ms"), Loaded.Num(), (FPlatformTime::Seconds() - LoadStartTime) * 1000.0);
+}
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PreloadSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+/// <summary>
+/// Loads the runner and the map's preload manifest in the background as soon as a game world is made, on
+/// clients as well as the server, and then the assets in the manifest. Everything is kept loaded while the
+/// map is running. Dedicated servers don't draw anything, so the subsystem isn't made on them and the game
+/// mode only loads the runner there.
+/// </summary>
+UCLASS()
+class SKYLINESHREDDER_API UPreloadSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	//If the runner and the manifest have loaded, the manifest's assets may still be loading
+	bool IsRunnerLoaded() const { return bRunnerLoaded; }
+
+private:
+	TSharedPtr<FStreamableHandle> RunnerHandle;
+	TSharedPtr<FStreamableHandle> PreloadHandle;
+
+	FString ManifestPath;
+	bool bRunnerLoaded = false;
+	double LoadStartTime = 0.0;
+
+	void HandleRunnerLoaded();
+	void HandlePreloadLoaded();
+};
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RunnerSignificanceSubsystem.h"
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+
+URunnerSignificanceSubsystem::URunnerSignificanceSubsystem()
+{
+	//Full rate up close, then 30Hz, 10Hz, and the slowest rate for anything past 150 meters.
+	//Movement never goes below 10Hz so the parkour simulation can always catch up in one move
+	Buckets.SetNum(4);
+	Buckets[0].MaxDistance = 2000.0f;
+
+	Buckets[1].MaxDistance = 5000.0f;
+	Buckets[1].ActorTickInterval = 1.0f / 30.0f;
+	Buckets[1].MovementTickInterval = 1.0f / 30.0f;
+	Buckets[1].AnimationTickInterval = 1.0f / 30.0f;
+
+	Buckets[2].MaxDistance = 15000.0f;
+	Buckets[2].ActorTickInterval = 0.1f;
+	Buckets[2].MovementTickInterval = 0.1f;
+	Buckets[2].AnimationTickInterval = 0.2f;
+	Buckets[2].bOnlyAnimateWhenRendered = true;
+
+	Buckets[3].ActorTickInterval = 0.25f;
+	Buckets[3].MovementTickInterval = 0.1f;
+	Buckets[3].AnimationTickInterval = 0.5f;
+	Buckets[3].bOnlyAnimateWhenRendered = true;
+}
+
+void URunnerSignificanceSubsystem::Deinitialize()
+{
+	for (FRunner& Runner : Runners)
+		ApplyBucket(Runner, 0);
+	Runners.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId URunnerSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(URunnerSignificanceSubsystem, STATGROUP_Parkour);
+}
+
+void URunnerSignificanceSubsystem::RegisterRunner(ASkylineShredderCharacter* Runner)
+{
+	if (!Runner || Runners.ContainsByPredicate([Runner](const FRunner& Other) { return Other.Character == Runner; }))
+		return;
+
+	FRunner& NewRunner = Runners.AddDefaulted_GetRef();
+	NewRunner.Character = Runner;
+	NewRunner.ActorTickInterval = Runner->GetActorTickInterval();
+	NewRunner.MovementTickInterval = Runner->GetCharacterMovement()->GetComponentTickInterval();
+	NewRunner.AnimationTickInterval = Runner->GetMesh()->GetComponentTickInterval();
+	NewRunner.AnimTickOption = Runner->GetMesh()->VisibilityBasedAnimTickOption;
+
+	//Work out the new runner's bucket on the next tick
+	TimeUntilUpdate = 0.0f;
+}
+
+void URunnerSignificanceSubsystem::UnregisterRunner(ASkylineShredderCharacter* Runner)
+{
+	const int32 Index = Runners.IndexOfByPredicate([Runner](const FRunner& Other) { return Other.Character == Runner; });
+	if (Index == INDEX_NONE)
+		return;
+
+	ApplyBucket(Runners[Index], 0);
+	Runners.RemoveAtSwap(Index);
+}
+
+int32 URunnerSignificanceSubsystem::GetRunnerBucket(const ASkylineShredderCharacter* Runner) const
+{
+	const FRunner* Found = Runners.FindByPredicate([Runner](const FRunner& Other) { return Other.Character == Runner; });
+	return Found ? FMath::Max(Found->Bucket, 0) : 0;
+}
+
+void URunnerSignificanceSubsystem::Tick(float DeltaTime)
+{
+	TimeUntilUpdate -= DeltaTime;
+	if (TimeUntilUpdate > 0.0f)
+		return;
+	TimeUntilUpdate = UpdateInterval;
+
+	//Runners are measured from every local player's camera, a dedicated server has none and runs everyone at full rate
+	TArray<FVector> Viewers;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* Controller = It->Get();
+		if (!Controller || !Controller->IsLocalController())
+			continue;
+
+		FVector Location;
+		FRotator Rotation;
+		Controller->GetPlayerViewPoint(Location, Rotation);
+		Viewers.Add(Location);
+	}
+
+	for (int32 Index = Runners.Num() - 1; Index >= 0; Index--)
+	{
+		FRunner& Runner = Runners[Index];
+		if (!Runner.Character.IsValid())
+		{
+			Runners.RemoveAtSwap(Index);
+			continue;
+		}
+
+		const int32 Bucket = PickBucket(Runner, Viewers);
+		if (Bucket != Runner.Bucket)
+			ApplyBucket(Runner, Bucket);
+	}
+}
+
+int32 URunnerSignificanceSubsystem::PickBucket(const FRunner& Runner, const TArray<FVector>& Viewers) const
+{
+	const ASkylineShredderCharacter* Character = Runner.Character.Get();
+
+	//Players predicting their own runner, and the server simulating a remote player's moves, need every frame
+	if (Viewers.Num() == 0 || Buckets.Num() == 0 || Character->IsLocallyControlled() || (Character->IsPlayerControlled() && Character->HasAuthority()))
+		return 0;
+
+	const FVector Location = Character->GetActorLocation();
+	float DistanceSquared = TNumericLimits<float>::Max();
+	for (const FVector& Viewer : Viewers)
+		DistanceSquared = FMath::Min(DistanceSquared, FVector::DistSquared(Location, Viewer));
+
+	float Distance = FMath::Sqrt(DistanceSquared);
+	if (!Character->GetMesh()->WasRecentlyRendered(UpdateInterval))
+		Distance *= OffScreenDistanceScale;
+
+	//Moving up to a more significant bucket happens straight away, dropping down has to pass the hysteresis
+	//margin so a runner on the edge of a bucket doesn't keep switching
+	for (int32 Bucket = 0; Bucket < Buckets.Num(); Bucket++)
+	{
+		const float MaxDistance = Buckets[Bucket].MaxDistance;
+		if (MaxDistance <= 0.0f)
+			return Bucket;
+
+		const float Margin = Runner.Bucket != INDEX_NONE && Bucket >= Runner.Bucket ? MaxDistance * Hysteresis : 0.0f;
+		if (Distance < MaxDistance + Margin)
+			return Bucket;
+	}
+
+	return Buckets.Num() - 1;
+}
+
+void URunnerSignificanceSubsystem::ApplyBucket(FRunner& Runner, int32 Bucket)
+{
+	Runner.Bucket = Bucket;
+
+	ASkylineShredderCharacter* Character = Runner.Character.Get();
+	if (!Character || !Buckets.IsValidIndex(Bucket))
+		return;
+
+	//The character's own rates are the fastest it ever ticks at. The parkour simulation is stepped with
+	//fixed steps from the move length, so it carries on at the same speed whatever the interval
+	const FRunnerSignificanceBucket& Settings = Buckets[Bucket];
+	Character->SetActorTickInterval(FMath::Max(Runner.ActorTickInterval, Settings.ActorTickInterval));
+	Character->GetCharacterMovement()->SetComponentTickInterval(FMath::Max(Runner.MovementTickInterval, Settings.MovementTickInterval));
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+	Mesh->SetComponentTickInterval(FMath::Max(Runner.AnimationTickInterval, Settings.AnimationTickInterval));
+	Mesh->VisibilityBasedAnimTickOption = Settings.bOnlyAnimateWhenRendered ? EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered : Runner.AnimTickOption;
+}
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RunnerSignificanceSubsystem.generated.h"
+
+class ASkylineShredderCharacter;
+
+//How often a runner is updated while it is in a significance bucket
+USTRUCT()
+struct FRunnerSignificanceBucket
+{
+	GENERATED_BODY()
+
+	//Runners closer than this to the nearest viewer are in the bucket, 0 for no limit
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float MaxDistance = 0.0f;
+
+	//Seconds between ticks of the character, its movement and its animation, 0 for every frame
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float ActorTickInterval = 0.0f;
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float MovementTickInterval = 0.0f;
+	UPROPERTY(EditAnywhere, Category = Significance)
+	float AnimationTickInterval = 0.0f;
+
+	//If the pose is only updated while the mesh is on screen
+	UPROPERTY(EditAnywhere, Category = Significance)
+	bool bOnlyAnimateWhenRendered = false;
+};
+
+/// <summary>
+/// Lowers how often far away and off screen runners tick. Every runner is put into a significance bucket
+/// by its distance to the closest local viewer, and the bucket sets the tick interval of the character,
+/// its movement and its animation. Runners controlled by a player on this machine, and remote players on
+/// the server, always run at the full rate.
+/// </summary>
+UCLASS(config = Game)
+class SKYLINESHREDDER_API URunnerSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	URunnerSignificanceSubsystem();
+
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Runners.Num() > 0; }
+	virtual TStatId GetStatId() const override;
+
+	/// <summary>
+	/// Starts managing how often a runner ticks
+	/// </summary>
+	void RegisterRunner(ASkylineShredderCharacter* Runner);
+
+	/// <summary>
+	/// Puts a runner back to its own tick rates and stops managing it
+	/// </summary>
+	void UnregisterRunner(ASkylineShredderCharacter* Runner);
+
+	/// <summary>
+	/// Gets the bucket a runner is in, 0 is the most significant
+	/// </summary>
+	int32 GetRunnerBucket(const ASkylineShredderCharacter* Runner) const;
+
+	//The buckets from most to least significant, a runner goes in the first one it is close enough for
+	UPROPERTY(Config, EditAnywhere, Category = Significance)
+	TArray<FRunnerSignificanceBucket> Buckets;
+
+	//Seconds between working out the buckets
+	UPROPERTY(Config, EditAnywhere, Category = Significance)
+	float UpdateInterval = 0.2f;
+
+	//How much further than a bucket's distance a runner has to go before it drops to a less significant bucket
+	UPROPERTY(Config, EditAnywhere, Category = Significance)
+	float Hysteresis = 0.15f;
+
+	//Off screen runners are treated as this much further away
+	UPROPERTY(Config, EditAnywhere, Category = Significance)
+	float OffScreenDistanceScale = 2.0f;
+
+private:
+	struct FRunner
+	{
+		TWeakObjectPtr<ASkylineShredderCharacter> Character;
+		int32 Bucket = INDEX_NONE;
+
+		//The runner's own settings, never ticked slower than these
+		float ActorTickInterval = 0.0f;
+		float MovementTickInterval = 0.0f;
+		float AnimationTickInterval = 0.0f;
+		EVisibilityBasedAnimTickOption AnimTickOption = EVisibilityBasedAnimTickOption::AlwaysTickPose;
+	};
+
+	TArray<FRunner> Runners;
+	float TimeUntilUpdate = 0.0f;
+
+	int32 PickBucket(const FRunner& Runner, const TArray<FVector>& Viewers) const;
+	void ApplyBucket(FRunner& Runner, int32 Bucket);
+};
@@ -0,0 +1,733 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SkylineMovementComponent.h"
+#include "SkylineShredder.h"
+#include "SkylineShredderCharacter.h"
+#include "GrappleComponent.h"
+#include "GameFramework/Character.h"
+#include "Engine/NetConnection.h"
+
+//////////////////////////////////////////////////////////////////////////
+// FSkylineParkourNetState
+
+void FSkylineParkourNetState::Set(bool bWallRunning, bool bLeftSide, bool bRightSide, bool bGrappleAttached, int32 Jumps, float Momentum, const FVector& Hook)
+{
+	Flags = (bWallRunning ? FLAG_WallRunning : 0) | (bLeftSide ? FLAG_LeftSide : 0) | (bRightSide ? FLAG_RightSide : 0) | (bGrappleAttached ? FLAG_GrappleAttached : 0);
+	NumberOfJumps = (uint8)FMath::Clamp(Jumps, 0, 3);
+	QuantizedMomentum = SkylineNetQuantize::QuantizeMomentum(Momentum);
+
+	//Leave the hook alone while detached so the state doesn't change and get sent again
+	if (bGrappleAttached)
+		HookLocation = Hook;
+}
+
+float FSkylineParkourNetState::GetMomentum() const
+{
+	return SkylineNetQuantize::DequantizeMomentum(QuantizedMomentum);
+}
+
+bool FSkylineParkourNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	//4 bits of flags, 2 bits of jumps, 16 bits of momentum and the hook only while it is attached
+	uint32 flags = Flags;
+	uint32 jumps = NumberOfJumps;
+	Ar.SerializeInt(flags, 1 << NumFlagBits);
+	Ar.SerializeInt(jumps, 4);
+	Ar << QuantizedMomentum;
+	Flags = (uint8)flags;
+	NumberOfJumps = (uint8)jumps;
+
+	bOutSuccess = true;
+	if (HasFlag(FLAG_GrappleAttached))
+		bOutSuccess = HookLocation.NetSerialize(Ar, Map, bOutSuccess);
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSavedMove_Skyline
+
+void FSavedMove_Skyline::Clear()
+{
+	Super::Clear();
+
+	bSavedHasInput = false;
+	bSavedJumpHeld = false;
+	bSavedWallRunning = false;
+	bSavedGrappleAttached = false;
+	SavedHookLocation = FVector::ZeroVector;
+	SavedJumpToggles = 0;
+	SavedParkourState = EParkourState::None;
+	SavedParkourFlags = 0;
+	SavedNumberOfJumps = 0;
+	SavedSimulation = FParkourSimulationState();
+	SavedVault = FSkylineVaultState();
+	SavedEndMomentum = 0.0f;
+	SavedEndNumberOfJumps = 0;
+}
+
+uint8 FSavedMove_Skyline::GetCompressedFlags() const
+{
+	uint8 flags = Super::GetCompressedFlags();
+
+	if (bSavedHasInput)
+		flags |= FLAG_HasInput;
+	if (bSavedJumpHeld)
+		flags |= FLAG_JumpHeld;
+	if (bSavedWallRunning)
+		flags |= FLAG_WallRunning;
+	if (bSavedGrappleAttached)
+		flags |= FLAG_GrappleAttached;
+
+	return flags;
+}
+
+bool FSavedMove_Skyline::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const
+{
+	//Never merge moves across a change in the parkour state or a jump, the server has to see every transition
+	const FSavedMove_Skyline* newMove = static_cast<const FSavedMove_Skyline*>(NewMove.Get());
+	if (SavedJumpToggles != 0 || newMove->SavedJumpToggles != 0 || bSavedHasInput != newMove->bSavedHasInput || bSavedJumpHeld != newMove->bSavedJumpHeld
+		|| bSavedWallRunning != newMove->bSavedWallRunning || bSavedGrappleAttached != newMove->bSavedGrappleAttached
+		|| SavedParkourState != newMove->SavedParkourState || SavedParkourFlags != newMove->SavedParkourFlags
+		|| SavedEndNumberOfJumps != newMove->SavedEndNumberOfJumps || !SavedHookLocation.Equals(newMove->SavedHookLocation))
+		return false;
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_Skyline::SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	ASkylineShredderCharacter* character = Cast<ASkylineShredderCharacter>(C);
+	if (!character)
+		return;
+
+	bSavedHasInput = character->HasMovementInput();
+	bSavedJumpHeld = character->IsJumpHeld();
+	bSavedWallRunning = character->IsWallRunning();
+	const UGrappleComponent* grapple = character->GetGrapple();
+	bSavedGrappleAttached = grapple->IsHookAttached();
+	SavedHookLocation = grapple->IsHookAttached() ? grapple->GetHookLocation() : FVector::ZeroVector;
+	SavedJumpToggles = character->GetPendingJumpToggles();
+	SavedParkourState = character->ParkourState;
+	SavedParkourFlags = character->GetParkourFlags();
+	SavedNumberOfJumps = (uint8)FMath::Clamp(character->NumberOfJumps, 0, 3);
+	SavedSimulation = character->GetSimulationState();
+	SavedVault = character->GetSkylineMovement()->GetVaultState();
+}
+
+void FSavedMove_Skyline::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	//Only the first replayed move is put back to how it started, the moves after it step on from where the
+	//replay got to so a correction carries through them. That is saved again for a later correction to start from
+	if (ASkylineShredderCharacter* character = Cast<ASkylineShredderCharacter>(C))
+	{
+		SavedParkourState = character->ParkourState;
+		SavedParkourFlags = character->GetParkourFlags();
+		SavedNumberOfJumps = (uint8)FMath::Clamp(character->NumberOfJumps, 0, 3);
+		SavedSimulation = character->GetSimulationState();
+		SavedVault = character->GetSkylineMovement()->GetVaultState();
+
+		//Jump again where the move did
+		character->SetPendingJumpToggles(SavedJumpToggles);
+	}
+}
+
+void FSavedMove_Skyline::PostUpdate(ACharacter* C, EPostUpdateMode PostUpdateMode)
+{
+	Super::PostUpdate(C, PostUpdateMode);
+
+	if (ASkylineShredderCharacter* character = Cast<ASkylineShredderCharacter>(C))
+	{
+		SavedEndMomentum = character->GetMomentum();
+		SavedEndNumberOfJumps = (uint8)FMath::Clamp(character->NumberOfJumps, 0, 3);
+	}
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_Skyline::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_Skyline());
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSkylineNetworkMoveData
+
+void FSkylineNetworkMoveData::ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType)
+{
+	FCharacterNetworkMoveData::ClientFillNetworkMoveData(ClientMove, MoveType);
+
+	const FSavedMove_Skyline& move = static_cast<const FSavedMove_Skyline&>(ClientMove);
+	QuantizedMomentum = SkylineNetQuantize::QuantizeMomentum(move.SavedEndMomentum);
+	NumberOfJumps = move.SavedEndNumberOfJumps;
+	JumpToggles = move.SavedJumpToggles;
+	HookLocation = move.SavedHookLocation;
+}
+
+bool FSkylineNetworkMoveData::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType)
+{
+	FCharacterNetworkMoveData::Serialize(CharacterMovement, Ar, PackageMap, MoveType);
+
+	//16 bits of momentum, 2 bits of jumps, 2 bits of jump presses and releases, and the hook only on moves with the grapple attached
+	uint32 jumps = NumberOfJumps;
+	uint32 toggles = JumpToggles;
+	Ar << QuantizedMomentum;
+	Ar.SerializeInt(jumps, 4);
+	Ar.SerializeInt(toggles, 4);
+	NumberOfJumps = (uint8)jumps;
+	JumpToggles = (uint8)toggles;
+
+	if (CompressedMoveFlags & FSavedMove_Skyline::FLAG_GrappleAttached)
+	{
+		bool bSuccess = true;
+		HookLocation.NetSerialize(Ar, PackageMap, bSuccess);
+	}
+	else if (Ar.IsLoading())
+	{
+		HookLocation = FVector::ZeroVector;
+	}
+
+	return !Ar.IsError();
+}
+
+FSkylineNetworkMoveDataContainer::FSkylineNetworkMoveDataContainer()
+{
+	NewMoveData = &SkylineMoveData[0];
+	PendingMoveData = &SkylineMoveData[1];
+	OldMoveData = &SkylineMoveData[2];
+}
+
+//////////////////////////////////////////////////////////////////////////
+// FSkylineMoveResponseDataContainer
+
+void FSkylineMoveResponseDataContainer::ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment)
+{
+	FCharacterMoveResponseDataContainer::ServerFillResponseData(CharacterMovement, PendingAdjustment);
+
+	const USkylineMovementComponent& movement = static_cast<const USkylineMovementComponent&>(CharacterMovement);
+	ASkylineShredderCharacter* character = movement.GetSkylineCharacter();
+	bHasParkourCorrection = !IsGoodMove() && character;
+	if (!bHasParkourCorrection)
+		return;
+
+	//Send the parkour state as the difference from what the client said it had
+	const USkylineMovementComponent::FClientParkourState& client = movement.GetClientParkourState();
+	QuantizedMomentumError = FMath::RoundToInt((character->GetMomentum() - client.Momentum) * SkylineNetQuantize::MomentumScale);
+	ParkourState = (uint8)character->ParkourState;
+	ParkourFlags = character->GetParkourFlags();
+	NumberOfJumps = (uint8)FMath::Clamp(character->NumberOfJumps, 0, 3);
+	const UGrappleComponent* grapple = character->GetGrapple();
+	bGrappleAttached = grapple->IsHookAttached();
+	bHookIsDelta = bGrappleAttached && client.bGrappleAttached;
+	HookDelta = bHookIsDelta ? grapple->GetHookLocation() - client.HookLocation : FVector::ZeroVector;
+	HookLocation = bGrappleAttached ? grapple->GetHookLocation() : FVector::ZeroVector;
+	RopeMaxLength = bGrappleAttached ? (uint32)FMath::RoundToInt(movement.GetGrappleRope().GetMaxLength()) : 0;
+}
+
+bool FSkylineMoveResponseDataContainer::Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap)
+{
+	if (!FCharacterMoveResponseDataContainer::Serialize(CharacterMovement, Ar, PackageMap))
+		return false;
+
+	if (IsGoodMove())
+		return !Ar.IsError();
+
+	Ar.SerializeBits(&bHasParkourCorrection, 1);
+	if (!bHasParkourCorrection)
+		return !Ar.IsError();
+
+	//The momentum error is usually small, so zigzag it into a packed integer of a byte or two
+	uint32 zigzag = (uint32)((QuantizedMomentumError << 1) ^ (QuantizedMomentumError >> 31));
+	Ar.SerializeIntPacked(zigzag);
+	QuantizedMomentumError = (int32)(zigzag >> 1) ^ -(int32)(zigzag & 1);
+
+	//3 bits of parkour state and 5 bits of parkour flags
+	uint32 state = ParkourState;
+	uint32 flags = ParkourFlags;
+	Ar.SerializeInt(state, (uint32)EParkourState::Count);
+	Ar.SerializeInt(flags, 1 << 5);
+	ParkourState = (uint8)state;
+	ParkourFlags = (uint8)flags;
+
+	uint32 jumps = NumberOfJumps;
+	Ar.SerializeInt(jumps, 4);
+	NumberOfJumps = (uint8)jumps;
+
+	Ar.SerializeBits(&bGrappleAttached, 1);
+	if (bGrappleAttached)
+	{
+		bool bSuccess = true;
+		Ar.SerializeBits(&bHookIsDelta, 1);
+		if (bHookIsDelta)
+			HookDelta.NetSerialize(Ar, PackageMap, bSuccess);
+		else
+			HookLocation.NetSerialize(Ar, PackageMap, bSuccess);
+
+		//The rope length in whole units, so the client hooks the rope again with the server's length
+		Ar.SerializeIntPacked(RopeMaxLength);
+	}
+
+	return !Ar.IsError();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// USkylineMovementComponent
+
+USkylineMovementComponent::USkylineMovementComponent()
+{
+	SetNetworkMoveDataContainer(SkylineMoveDataContainer);
+	SetMoveResponseDataContainer(SkylineMoveResponseDataContainer);
+}
+
+ASkylineShredderCharacter* USkylineMovementComponent::GetSkylineCharacter() const
+{
+	return Cast<ASkylineShredderCharacter>(CharacterOwner);
+}
+
+FNetworkPredictionData_Client* USkylineMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		USkylineMovementComponent* mutableThis = const_cast<USkylineMovementComponent*>(this);
+		mutableThis->ClientPredictionData = new FNetworkPredictionData_Client_Skyline(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void USkylineMovementComponent::SetWallRun(const FVector& WallNormal, float MaxSpeed)
+{
+	WallRunNormal = FVector(WallNormal.X, WallNormal.Y, 0.0f).GetSafeNormal();
+	WallRunMaxSpeed = MaxSpeed;
+
+	if (IsWallRunning())
+		return;
+
+	//Start running along the wall in whichever direction the player is already heading, at no more than the wall run speed
+	FVector alongWall = FVector::CrossProduct(WallRunNormal, FVector::UpVector);
+	const FVector heading = Velocity.SizeSquared2D() > KINDA_SMALL_NUMBER ? Velocity : UpdatedComponent->GetForwardVector();
+	if (FVector::DotProduct(alongWall, heading) < 0.0f)
+		alongWall = -alongWall;
+
+	Velocity = alongWall * FMath::Clamp(Velocity.Size(), 0.0f, WallRunMaxSpeed);
+	SetMovementMode(MOVE_Custom, (uint8)ESkylineMovementMode::WallRun);
+}
+
+void USkylineMovementComponent::StopWallRun()
+{
+	if (IsWallRunning())
+		SetMovementMode(MOVE_Falling);
+}
+
+void USkylineMovementComponent::StartGrappleSwing(const FVector& HookLocation, float MaxRopeLength)
+{
+	GrappleRope.Attach(UpdatedComponent->GetComponentLocation(), HookLocation, MaxRopeLength);
+	SetMovementMode(MOVE_Custom, (uint8)ESkylineMovementMode::GrappleSwing);
+}
+
+void USkylineMovementComponent::SetGrappleHookLocation(const FVector& HookLocation, float MaxRopeLength)
+{
+	if (!GrappleRope.IsAttached() || !GrappleRope.GetHookLocation().Equals(HookLocation, 1.0f))
+		GrappleRope.Attach(UpdatedComponent->GetComponentLocation(), HookLocation, MaxRopeLength);
+	else
+		GrappleRope.SetMaxLength(MaxRopeLength);
+}
+
+void USkylineMovementComponent::ReelGrappleRope(float Amount)
+{
+	GrappleRope.Reel(Amount);
+}
+
+void USkylineMovementComponent::StopGrappleSwing()
+{
+	if (IsGrappleSwinging())
+		SetMovementMode(MOVE_Falling);
+}
+
+void USkylineMovementComponent::StartVault(const FVector& TargetLocation, float Duration)
+{
+	VaultStart = UpdatedComponent->GetComponentLocation();
+	VaultTarget = TargetLocation;
+	VaultDuration = Duration;
+	VaultElapsed = 0.0f;
+	bVaultFinished = false;
+	Velocity = FVector::ZeroVector;
+	SetMovementMode(MOVE_Custom, (uint8)ESkylineMovementMode::Vault);
+}
+
+void USkylineMovementComponent::SetVaultState(const FSkylineVaultState& State)
+{
+	VaultStart = State.Start;
+	VaultTarget = State.Target;
+	VaultDuration = State.Duration;
+	VaultElapsed = State.Elapsed;
+}
+
+void USkylineMovementComponent::StopVault()
+{
+	if (IsVaulting())
+		SetMovementMode(MOVE_Falling);
+}
+
+void USkylineMovementComponent::PhysCustom(float deltaTime, int32 Iterations)
+{
+	switch ((ESkylineMovementMode)CustomMovementMode)
+	{
+	case ESkylineMovementMode::WallRun:
+		PhysWallRun(deltaTime, Iterations);
+		break;
+	case ESkylineMovementMode::GrappleSwing:
+		PhysGrappleSwing(deltaTime, Iterations);
+		break;
+	case ESkylineMovementMode::Vault:
+		PhysVault(deltaTime, Iterations);
+		break;
+	default:
+		break;
+	}
+
+	//Still lets blueprints add their own custom modes
+	Super::PhysCustom(deltaTime, Iterations);
+}
+
+void USkylineMovementComponent::PhysicsRotation(float DeltaTime)
+{
+	//Wall running faces along the wall and vaulting keeps the facing it started with
+	if (IsWallRunning() || IsVaulting())
+		return;
+
+	Super::PhysicsRotation(DeltaTime);
+}
+
+void USkylineMovementComponent::OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode)
+{
+	Super::OnMovementModeChanged(PreviousMovementMode, PreviousCustomMode);
+
+	//Landing or being knocked out of the swing lets go of the rope
+	if (!IsGrappleSwinging())
+		GrappleRope.Detach();
+}
+
+void USkylineMovementComponent::OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity)
+{
+	Super::OnMovementUpdated(DeltaSeconds, OldLocation, OldVelocity);
+
+	//Momentum is simulated with each move so the client and server step it the same way,
+	//simulated proxies get it from the replicated parkour state instead
+	ASkylineShredderCharacter* character = GetSkylineCharacter();
+	if (character && character->GetLocalRole() != ROLE_SimulatedProxy)
+		character->AdvanceParkourSimulation(DeltaSeconds);
+
+	//Let the character finish the vault now the move is done, it changes the parkour state
+	if (bVaultFinished)
+	{
+		bVaultFinished = false;
+		if (character)
+			character->StopVaultOrGetUp();
+	}
+}
+
+void USkylineMovementComponent::UpdateCharacterStateBeforeMovement(float DeltaSeconds)
+{
+	Super::UpdateCharacterStateBeforeMovement(DeltaSeconds);
+
+	//Jumping and the parkour state change inside the move, so the owning client predicts them, the server
+	//runs them from the flags the client sent and corrections replay them
+	ASkylineShredderCharacter* character = GetSkylineCharacter();
+	if (character && character->GetLocalRole() != ROLE_SimulatedProxy)
+		character->UpdateParkourMove(DeltaSeconds);
+}
+
+void USkylineMovementComponent::UpdateFromCompressedFlags(uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	//Only the server acts on a remote client's flags, the client already did when it made the move
+	ASkylineShredderCharacter* character = GetSkylineCharacter();
+	if (!character || character->GetLocalRole() != ROLE_Authority || character->IsLocallyControlled())
+		return;
+
+	bNetworkHasInput = (Flags & FSavedMove_Skyline::FLAG_HasInput) != 0;
+
+	//The flag is the client's wall run state at the start of the move, before this move has changed the server's
+	bWallRunDiverged = ((Flags & FSavedMove_Skyline::FLAG_WallRunning) != 0) != character->IsWallRunning();
+	character->ApplyNetworkJump((Flags & FSavedMove_Skyline::FLAG_JumpHeld) != 0, ClientParkourState.JumpToggles);
+
+	const bool bGrappleAttached = (Flags & FSavedMove_Skyline::FLAG_GrappleAttached) != 0;
+	if (bGrappleAttached != character->GetGrapple()->IsHookAttached())
+		character->GetGrapple()->ApplyNetworkGrapple(bGrappleAttached, ClientParkourState.HookLocation);
+}
+
+void USkylineMovementComponent::ServerMove_PerformMovement(const FCharacterNetworkMoveData& MoveData)
+{
+	//Keep what the client sent so the flags and the error check can use it
+	const FSkylineNetworkMoveData& skylineMoveData = static_cast<const FSkylineNetworkMoveData&>(MoveData);
+	ClientParkourState.bWallRunning = (MoveData.CompressedMoveFlags & FSavedMove_Skyline::FLAG_WallRunning) != 0;
+	ClientParkourState.bGrappleAttached = (MoveData.CompressedMoveFlags & FSavedMove_Skyline::FLAG_GrappleAttached) != 0;
+	bWallRunDiverged = false;
+	ClientParkourState.Momentum = SkylineNetQuantize::DequantizeMomentum(skylineMoveData.QuantizedMomentum);
+	ClientParkourState.NumberOfJumps = skylineMoveData.NumberOfJumps;
+	ClientParkourState.JumpToggles = skylineMoveData.JumpToggles;
+	ClientParkourState.HookLocation = skylineMoveData.HookLocation;
+
+	Super::ServerMove_PerformMovement(MoveData);
+}
+
+bool USkylineMovementComponent::ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc,
+	UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode)
+{
+	if (Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientLoc, RelativeClientLoc, ClientMovementBase, ClientBaseBoneName, ClientMovementMode))
+		return true;
+
+	ASkylineShredderCharacter* character = GetSkylineCharacter();
+	if (!character)
+		return false;
+
+	bool bError = bWallRunDiverged
+		|| FMath::Abs(character->GetMomentum() - ClientParkourState.Momentum) > MomentumErrorTolerance
+		|| FMath::Clamp(character->NumberOfJumps, 0, 3) != ClientParkourState.NumberOfJumps
+		|| character->GetGrapple()->IsHookAttached() != ClientParkourState.bGrappleAttached
+		|| (character->GetGrapple()->IsHookAttached() && !character->GetGrapple()->GetHookLocation().Equals(ClientParkourState.HookLocation, HookLocationErrorTolerance));
+
+	if (bError)
+		PARKOUR_COUNTER_ADD(ParkourNetCorrections, 1);
+
+	return bError;
+}
+
+void USkylineMovementComponent::ServerMovePacked_ServerReceive(const FCharacterServerMovePackedBits& PackedBits)
+{
+	GParkourNetMoveBits += PackedBits.DataBits.Num();
+	Super::ServerMovePacked_ServerReceive(PackedBits);
+}
+
+void USkylineMovementComponent::ClientMoveResponsePacked_ServerSend(const FCharacterMoveResponsePackedBits& PackedBits)
+{
+	GParkourNetResponseBits += PackedBits.DataBits.Num();
+	Super::ClientMoveResponsePacked_ServerSend(PackedBits);
+}
+
+void USkylineMovementComponent::ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse)
+{
+	Super::ClientHandleMoveResponse(MoveResponse);
+
+	const FSkylineMoveResponseDataContainer& response = static_cast<const FSkylineMoveResponseDataContainer&>(MoveResponse);
+	ASkylineShredderCharacter* character = GetSkylineCharacter();
+	if (response.IsGoodMove() || !response.bHasParkourCorrection || !character)
+		return;
+
+	//The server sent how far off the acknowledged move was, so shift the current momentum and
+	//the moves still waiting to be acknowledged by the same amount before they are replayed
+	const float momentumError = response.QuantizedMomentumError / SkylineNetQuantize::MomentumScale;
+	character->SetMomentum(character->GetMomentum() + momentumError);
+	if (FNetworkPredictionData_Client_Character* clientData = GetPredictionData_Client_Character())
+	{
+		for (FSavedMovePtr& move : clientData->SavedMoves)
+		{
+			FParkourSimulationState& simulation = static_cast<FSavedMove_Skyline*>(move.Get())->SavedSimulation;
+			simulation.Momentum += momentumError;
+			simulation.PreviousMomentum += momentumError;
+		}
+	}
+
+	//The first move still waiting to be acknowledged starts where the acknowledged one ended on the server,
+	//so the replay starts from the server's parkour state
+	FSavedMove_Skyline* firstMove = nullptr;
+	if (FNetworkPredictionData_Client_Character* clientData = GetPredictionData_Client_Character())
+		firstMove = clientData->SavedMoves.Num() > 0 ? static_cast<FSavedMove_Skyline*>(clientData->SavedMoves[0].Get()) : nullptr;
+
+	if (firstMove)
+	{
+		firstMove->SavedParkourState = (EParkourState)response.ParkourState;
+		firstMove->SavedParkourFlags = response.ParkourFlags;
+		firstMove->SavedNumberOfJumps = response.NumberOfJumps;
+	}
+	else
+	{
+		character->RestoreParkourState((EParkourState)response.ParkourState, response.ParkourFlags, response.NumberOfJumps);
+	}
+
+	//The delta is from the hook the client sent with the acknowledged move
+	FVector hookLocation = response.HookLocation;
+	if (response.bHookIsDelta)
+	{
+		const FNetworkPredictionData_Client_Character* clientData = GetPredictionData_Client_Character();
+		const FSavedMove_Skyline* ackedMove = clientData ? static_cast<const FSavedMove_Skyline*>(clientData->LastAckedMove.Get()) : nullptr;
+		hookLocation = (ackedMove ? ackedMove->SavedHookLocation : character->GetGrapple()->GetHookLocation()) + response.HookDelta;
+	}
+	character->GetGrapple()->CorrectGrapple(response.bGrappleAttached, hookLocation, (float)response.RopeMaxLength);
+}
+
+bool USkylineMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	//Replaying starts from the parkour state, simulation and vault the first move waiting to be acknowledged started with,
+	//including the part of a step that was left over. The moves after it change them again as they are replayed
+	ASkylineShredderCharacter* character = GetSkylineCharacter();
+	FNetworkPredictionData_Client_Character* clientData = GetPredictionData_Client_Character();
+	if (bUpdatePosition && character && clientData && clientData->SavedMoves.Num() > 0)
+	{
+		const FSavedMove_Skyline* firstMove = static_cast<const FSavedMove_Skyline*>(clientData->SavedMoves[0].Get());
+		character->RestoreParkourState(firstMove->SavedParkourState, firstMove->SavedParkourFlags, firstMove->SavedNumberOfJumps);
+		character->SetSimulationState(firstMove->SavedSimulation);
+		SetVaultState(firstMove->SavedVault);
+	}
+
+	//The replayed moves jump with the presses they saved, the ones made since still belong to the next move
+	const uint8 pendingJumpToggles = character ? character->GetPendingJumpToggles() : 0;
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+	if (character)
+		character->SetPendingJumpToggles(pendingJumpToggles);
+
+	return bResult;
+}
+
+bool USkylineMovementComponent::CanRunCustomPhysics() const
+{
+	return CharacterOwner && (CharacterOwner->Controller || bRunPhysicsWithNoController || HasAnimRootMotion()
+		|| CurrentRootMotion.HasOverrideVelocity() || CharacterOwner->GetLocalRole() == ROLE_SimulatedProxy);
+}
+
+bool USkylineMovementComponent::MoveAndSlide(const FVector& Delta, const FQuat& Rotation, float timeTick, float remainingTime, int32 Iterations)
+{
+	FHitResult hit(1.0f);
+	SafeMoveUpdatedComponent(Delta, Rotation, true, hit);
+
+	if (hit.Time < 1.0f)
+	{
+		//Landing on a floor hands over to walking
+		if (Delta.Z < 0.0f && IsValidLandingSpot(UpdatedComponent->GetComponentLocation(), hit))
+		{
+			ProcessLanded(hit, remainingTime + timeTick * (1.0f - hit.Time), Iterations);
+			return true;
+		}
+
+		HandleImpact(hit, timeTick, Delta);
+		SlideAlongSurface(Delta, 1.0f - hit.Time, hit.Normal, hit, true);
+	}
+
+	return false;
+}
+
+void USkylineMovementComponent::PhysWallRun(float deltaTime, int32 Iterations)
+{
+	if (deltaTime < MIN_TICK_TIME)
+		return;
+
+	float remainingTime = deltaTime;
+	while (remainingTime >= MIN_TICK_TIME && Iterations < MaxSimulationIterations && CanRunCustomPhysics())
+	{
+		Iterations++;
+		const float timeTick = GetSimulationTimeStep(remainingTime, Iterations);
+		remainingTime -= timeTick;
+
+		//Run along the wall, keeping whatever speed the player has up to the wall run speed
+		FVector alongWall = FVector::VectorPlaneProject(Velocity, WallRunNormal);
+		alongWall.Z = 0.0f;
+		const float speed = FMath::Min(alongWall.Size(), WallRunMaxSpeed);
+		const FVector direction = alongWall.GetSafeNormal();
+
+		const float verticalSpeed = WallRunGravityScale > 0.0f ? Velocity.Z + GetGravityZ() * WallRunGravityScale * timeTick : 0.0f;
+		Velocity = direction * speed + FVector(0.0f, 0.0f, verticalSpeed);
+
+		const FVector oldLocation = UpdatedComponent->GetComponentLocation();
+		const FQuat rotation = direction.IsNearlyZero() ? UpdatedComponent->GetComponentQuat() : direction.ToOrientationQuat();
+		if (MoveAndSlide(Velocity * timeTick, rotation, timeTick, remainingTime, Iterations))
+			return;
+
+		//Keep the velocity the move actually managed, so running into something slows the player down
+		if (!bJustTeleported)
+			Velocity = (UpdatedComponent->GetComponentLocation() - oldLocation) / timeTick;
+
+		if (!IsWallRunning())
+			return;
+	}
+}
+
+void USkylineMovementComponent::PhysGrappleSwing(float deltaTime, int32 Iterations)
+{
+	if (deltaTime < MIN_TICK_TIME)
+		return;
+
+	//A correction can put the player into the swing after the rope let go or without it ever being hooked,
+	//there is no hook to swing from then
+	if (!GrappleRope.IsAttached())
+	{
+		SetMovementMode(MOVE_Falling);
+		StartNewPhysics(deltaTime, Iterations);
+		return;
+	}
+
+	//Wrap the rope around anything the player swung it into since the last move
+	FCollisionQueryParams ropeParams(SCENE_QUERY_STAT(GrappleRope), false, CharacterOwner);
+	GrappleRope.UpdateContacts(GetWorld(), UpdatedComponent->GetComponentLocation(), ropeParams);
+
+	float remainingTime = deltaTime;
+	while (remainingTime >= MIN_TICK_TIME && Iterations < MaxSimulationIterations && CanRunCustomPhysics())
+	{
+		Iterations++;
+		const float timeTick = GetSimulationTimeStep(remainingTime, Iterations);
+		remainingTime -= timeTick;
+
+		//Fall and steer like in the air
+		Velocity.Z += GetGravityZ() * timeTick;
+		Velocity += Acceleration * GrappleSwingControl * timeTick;
+
+		//A taut rope doesn't stretch, so the velocity away from the anchor is taken off. A slack rope lets the player fall until it goes taut
+		const FVector oldLocation = UpdatedComponent->GetComponentLocation();
+		const FVector anchor = GrappleRope.GetAnchor();
+		const float freeLength = GrappleRope.GetFreeLength();
+		const FVector ropeDirection = (anchor - oldLocation).GetSafeNormal();
+		const float speedAway = FVector::DotProduct(Velocity, -ropeDirection);
+		if (speedAway > 0.0f && FVector::DistSquared(anchor, oldLocation) >= FMath::Square(freeLength - 1.0f))
+			Velocity += ropeDirection * speedAway;
+
+		if (MoveAndSlide(Velocity * timeTick, UpdatedComponent->GetComponentQuat(), timeTick, remainingTime, Iterations))
+			return;
+
+		//Swinging along the rope drifts a little past its length, and reeling in shortens it, so pull the player back onto it
+		const FVector toAnchor = anchor - UpdatedComponent->GetComponentLocation();
+		const float overLength = toAnchor.Size() - freeLength;
+		if (overLength > 0.0f)
+		{
+			FHitResult hit;
+			SafeMoveUpdatedComponent(toAnchor.GetSafeNormal() * overLength, UpdatedComponent->GetComponentQuat(), true, hit);
+		}
+
+		if (!bJustTeleported)
+			Velocity = (UpdatedComponent->GetComponentLocation() - oldLocation) / timeTick;
+
+		if (!IsGrappleSwinging())
+			return;
+	}
+
+	//The rope nodes are only for showing the rope, so they aren't stepped on a dedicated server or for replayed moves
+	if (GetNetMode() != NM_DedicatedServer && !CharacterOwner->bClientUpdating)
+		GrappleRope.Simulate(UpdatedComponent->GetComponentLocation(), deltaTime, GetGravityZ());
+}
+
+void USkylineMovementComponent::PhysVault(float deltaTime, int32 Iterations)
+{
+	if (deltaTime < MIN_TICK_TIME)
+		return;
+
+	//The vault moves straight towards the target, sliding along anything in the way so the player doesn't catch on the ledge
+	VaultElapsed += deltaTime;
+	const float alpha = VaultDuration > 0.0f ? FMath::Min(VaultElapsed / VaultDuration, 1.0f) : 1.0f;
+	const FVector delta = FMath::Lerp(VaultStart, VaultTarget, alpha) - UpdatedComponent->GetComponentLocation();
+
+	FHitResult hit(1.0f);
+	SafeMoveUpdatedComponent(delta, UpdatedComponent->GetComponentQuat(), true, hit);
+	if (hit.IsValidBlockingHit())
+		SlideAlongSurface(delta, 1.0f - hit.Time, hit.Normal, hit, true);
+	Velocity = FVector::ZeroVector;
+
+	//Walking finds the floor on top of the wall, or starts falling if there isn't one
+	if (alpha >= 1.0f)
+	{
+		SetMovementMode(MOVE_Walking);
+		bVaultFinished = true;
+	}
+}
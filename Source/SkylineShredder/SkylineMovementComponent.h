@@ -0,0 +1,350 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "Engine/NetSerialization.h"
+#include "GrappleRope.h"
+#include "SkylineMovementComponent.generated.h"
+
+class ASkylineShredderCharacter;
+
+//The parkour movement modes, used as the custom movement mode with MOVE_Custom
+UENUM(BlueprintType)
+enum class ESkylineMovementMode : uint8
+{
+	None UMETA(Hidden),
+	WallRun,
+	GrappleSwing,
+	Vault
+};
+
+/// <summary>
+/// The parkour state other players see, replicated to simulated proxies. The booleans are packed into
+/// bits, momentum is quantized to 16 bits and the hook location is only sent while the grapple is attached.
+/// </summary>
+USTRUCT()
+struct SKYLINESHREDDER_API FSkylineParkourNetState
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 Flags = 0;
+
+	UPROPERTY()
+	uint8 NumberOfJumps = 0;
+
+	UPROPERTY()
+	uint16 QuantizedMomentum = 0;
+
+	UPROPERTY()
+	FVector_NetQuantize10 HookLocation = FVector::ZeroVector;
+
+	enum : uint8
+	{
+		FLAG_WallRunning = 1 << 0,
+		FLAG_LeftSide = 1 << 1,
+		FLAG_RightSide = 1 << 2,
+		FLAG_GrappleAttached = 1 << 3,
+		NumFlagBits = 4
+	};
+
+	void Set(bool bWallRunning, bool bLeftSide, bool bRightSide, bool bGrappleAttached, int32 Jumps, float Momentum, const FVector& Hook);
+
+	bool HasFlag(uint8 Flag) const { return (Flags & Flag) != 0; }
+	float GetMomentum() const;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSkylineParkourNetState> : public TStructOpsTypeTraitsBase2<FSkylineParkourNetState>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+//Momentum is sent in 1/8ths, which covers up to 8191 in 16 bits
+namespace SkylineNetQuantize
+{
+	static constexpr float MomentumScale = 8.0f;
+
+	inline uint16 QuantizeMomentum(float Momentum) { return (uint16)FMath::Clamp(FMath::RoundToInt(Momentum * MomentumScale), 0, (int32)MAX_uint16); }
+	inline float DequantizeMomentum(uint16 Quantized) { return Quantized / MomentumScale; }
+}
+
+//How far through a vault the movement is, saved with each move so replaying it picks the vault up where the move did
+struct FSkylineVaultState
+{
+	FVector Start = FVector::ZeroVector;
+	FVector Target = FVector::ZeroVector;
+	float Duration = 0.0f;
+	float Elapsed = 0.0f;
+};
+
+/// <summary>
+/// A saved move with the parkour state. The intent (movement input, jump held, wall running and grapple)
+/// goes in the compressed flags and the jump presses and releases made during the move go with the extra
+/// data, along with the quantized state at the end of the move so the server can check it.
+/// </summary>
+class SKYLINESHREDDER_API FSavedMove_Skyline : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	enum : uint8
+	{
+		FLAG_HasInput = FLAG_Custom_0,
+		FLAG_JumpHeld = FLAG_Custom_1,
+		FLAG_WallRunning = FLAG_Custom_2,
+		FLAG_GrappleAttached = FLAG_Custom_3
+	};
+
+	bool bSavedHasInput = false;
+	bool bSavedJumpHeld = false;
+	bool bSavedWallRunning = false;
+	bool bSavedGrappleAttached = false;
+	FVector SavedHookLocation = FVector::ZeroVector;
+
+	//The jump presses and releases the move starts with, so they are sent to the server and done again on a replay
+	uint8 SavedJumpToggles = 0;
+
+	//The parkour state, the momentum and gravity simulation and the vault at the start of the move. The first move replayed
+	//after a correction starts from them, and replaying saves them again for the moves after it
+	EParkourState SavedParkourState = EParkourState::None;
+	uint8 SavedParkourFlags = 0;
+	uint8 SavedNumberOfJumps = 0;
+	FParkourSimulationState SavedSimulation;
+	FSkylineVaultState SavedVault;
+
+	//State at the end of the move, sent to the server
+	float SavedEndMomentum = 0.0f;
+	uint8 SavedEndNumberOfJumps = 0;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* C) override;
+	virtual void PostUpdate(ACharacter* C, EPostUpdateMode PostUpdateMode) override;
+};
+
+class SKYLINESHREDDER_API FNetworkPredictionData_Client_Skyline : public FNetworkPredictionData_Client_Character
+{
+public:
+	FNetworkPredictionData_Client_Skyline(const UCharacterMovementComponent& ClientMovement) : FNetworkPredictionData_Client_Character(ClientMovement) {}
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
+
+//The move sent to the server with the quantized parkour state added
+struct SKYLINESHREDDER_API FSkylineNetworkMoveData : public FCharacterNetworkMoveData
+{
+	uint16 QuantizedMomentum = 0;
+	uint8 NumberOfJumps = 0;
+	uint8 JumpToggles = 0;
+	FVector_NetQuantize HookLocation = FVector::ZeroVector;
+
+	virtual void ClientFillNetworkMoveData(const FSavedMove_Character& ClientMove, ENetworkMoveType MoveType) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap, ENetworkMoveType MoveType) override;
+};
+
+struct SKYLINESHREDDER_API FSkylineNetworkMoveDataContainer : public FCharacterNetworkMoveDataContainer
+{
+	FSkylineNetworkMoveDataContainer();
+
+	FSkylineNetworkMoveData SkylineMoveData[3];
+};
+
+/// <summary>
+/// The server's reply to a move. Corrections carry the parkour state as deltas from what the client sent:
+/// the momentum error as a packed integer and the hook location as a small quantized offset, only falling
+/// back to a full location when the client didn't have the grapple attached.
+/// </summary>
+struct SKYLINESHREDDER_API FSkylineMoveResponseDataContainer : public FCharacterMoveResponseDataContainer
+{
+	bool bHasParkourCorrection = false;
+	int32 QuantizedMomentumError = 0;
+	uint8 ParkourState = 0;
+	uint8 ParkourFlags = 0;
+	uint8 NumberOfJumps = 0;
+	bool bGrappleAttached = false;
+	bool bHookIsDelta = false;
+	FVector_NetQuantize HookDelta = FVector::ZeroVector;
+	FVector_NetQuantize10 HookLocation = FVector::ZeroVector;
+	uint32 RopeMaxLength = 0;
+
+	virtual void ServerFillResponseData(const UCharacterMovementComponent& CharacterMovement, const FClientAdjustment& PendingAdjustment) override;
+	virtual bool Serialize(UCharacterMovementComponent& CharacterMovement, FArchive& Ar, UPackageMap* PackageMap) override;
+};
+
+/// <summary>
+/// Character movement with the parkour mechanics as native custom movement modes. Wall running,
+/// grapple swinging and vaulting are integrated in their own physics functions with the same
+/// substepping as the engine's modes, so the character only has to start and stop them.
+/// </summary>
+UCLASS()
+class SKYLINESHREDDER_API USkylineMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	//How much of the normal gravity pulls the player down a wall, 0 keeps them level for the whole wall run
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Parkour")
+	float WallRunGravityScale = 0.0f;
+
+	//How much the player can steer while swinging, like air control
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Parkour")
+	float GrappleSwingControl = 0.2f;
+
+	//How far the client's momentum can be from the server's before the move is corrected
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Parkour")
+	float MomentumErrorTolerance = 25.0f;
+
+	//How far the client's grapple hook can be from the server's before the move is corrected
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Character Movement: Parkour")
+	float HookLocationErrorTolerance = 10.0f;
+
+	USkylineMovementComponent();
+
+	/// <summary>
+	/// Starts wall running along a wall, or keeps wall running along it if already wall running
+	/// </summary>
+	/// <param name="WallNormal">the normal of the wall, pointing back at the player</param>
+	/// <param name="MaxSpeed">the fastest the player can run along the wall</param>
+	void SetWallRun(const FVector& WallNormal, float MaxSpeed);
+
+	/// <summary>
+	/// Drops off the wall into falling, does nothing if not wall running
+	/// </summary>
+	void StopWallRun();
+
+	/// <summary>
+	/// Starts swinging from a grapple hook on a rope as long as the distance to it
+	/// </summary>
+	/// <param name="HookLocation">where the grapple hooked onto</param>
+	/// <param name="MaxRopeLength">the longest the rope can be reeled out to</param>
+	void StartGrappleSwing(const FVector& HookLocation, float MaxRopeLength);
+
+	/// <summary>
+	/// Lets go of the grapple hook into falling, does nothing if not swinging
+	/// </summary>
+	void StopGrappleSwing();
+
+	/// <summary>
+	/// Moves the player to a location over a time, sliding over anything in the way, then lets them walk from there.
+	/// The character is told the vault is over once the move that finishes it is done
+	/// </summary>
+	void StartVault(const FVector& TargetLocation, float Duration);
+
+	/// <summary>
+	/// Ends the vault where the player is, does nothing if not vaulting
+	/// </summary>
+	void StopVault();
+
+	bool IsInSkylineMode(ESkylineMovementMode Mode) const { return MovementMode == MOVE_Custom && CustomMovementMode == (uint8)Mode; }
+	bool IsWallRunning() const { return IsInSkylineMode(ESkylineMovementMode::WallRun); }
+	bool IsGrappleSwinging() const { return IsInSkylineMode(ESkylineMovementMode::GrappleSwing); }
+	bool IsVaulting() const { return IsInSkylineMode(ESkylineMovementMode::Vault); }
+
+	const FVector& GetWallRunNormal() const { return WallRunNormal; }
+	const FVector& GetGrappleHookLocation() const { return GrappleRope.GetHookLocation(); }
+	const FGrappleRope& GetGrappleRope() const { return GrappleRope; }
+
+	//Gets or puts back how far through the vault the movement is, used to replay moves
+	FSkylineVaultState GetVaultState() const { return { VaultStart, VaultTarget, VaultDuration, VaultElapsed }; }
+	void SetVaultState(const FSkylineVaultState& State);
+
+	/// <summary>
+	/// Moves the grapple hook to where the server corrected it to, hooking the rope again if it moved,
+	/// and takes the server's rope length either way
+	/// </summary>
+	/// <param name="HookLocation">where the server has the grapple hooked</param>
+	/// <param name="MaxRopeLength">the longest the server's rope can be reeled out to</param>
+	void SetGrappleHookLocation(const FVector& HookLocation, float MaxRopeLength);
+
+	/// <summary>
+	/// Reels the grapple rope in with a negative amount or out with a positive one
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	void ReelGrappleRope(float Amount);
+
+	/// <summary>
+	/// Gets the grapple rope from the hook, around any corners, to the player, for drawing it
+	/// </summary>
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+	void GetGrappleRopePoints(TArray<FVector>& OutPoints) const { GrappleRope.GetPoints(OutPoints); }
+
+	//If the client that owns this character is holding movement input, only known on the server
+	bool HasNetworkMovementInput() const { return bNetworkHasInput; }
+
+	ASkylineShredderCharacter* GetSkylineCharacter() const;
+
+	//The parkour state the client sent with the move being handled, only valid on the server
+	struct FClientParkourState
+	{
+		bool bWallRunning = false;
+		bool bGrappleAttached = false;
+		float Momentum = 0.0f;
+		uint8 NumberOfJumps = 0;
+		uint8 JumpToggles = 0;
+		FVector HookLocation = FVector::ZeroVector;
+	};
+	const FClientParkourState& GetClientParkourState() const { return ClientParkourState; }
+
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+protected:
+	virtual void PhysCustom(float deltaTime, int32 Iterations) override;
+	virtual void PhysicsRotation(float DeltaTime) override;
+	virtual void OnMovementModeChanged(EMovementMode PreviousMovementMode, uint8 PreviousCustomMode) override;
+	virtual void OnMovementUpdated(float DeltaSeconds, const FVector& OldLocation, const FVector& OldVelocity) override;
+	virtual void UpdateCharacterStateBeforeMovement(float DeltaSeconds) override;
+
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual void ServerMove_PerformMovement(const FCharacterNetworkMoveData& MoveData) override;
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc,
+		UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+	virtual void ServerMovePacked_ServerReceive(const FCharacterServerMovePackedBits& PackedBits) override;
+	virtual void ClientMoveResponsePacked_ServerSend(const FCharacterMoveResponsePackedBits& PackedBits) override;
+	virtual void ClientHandleMoveResponse(const FCharacterMoveResponseDataContainer& MoveResponse) override;
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+
+private:
+	FSkylineNetworkMoveDataContainer SkylineMoveDataContainer;
+	FSkylineMoveResponseDataContainer SkylineMoveResponseDataContainer;
+
+	FClientParkourState ClientParkourState;
+	bool bNetworkHasInput = false;
+
+	//If the server was in a different wall run state than the client at the start of the move being handled
+	bool bWallRunDiverged = false;
+
+	FVector WallRunNormal = FVector::ZeroVector;
+	float WallRunMaxSpeed = 0.0f;
+
+	FGrappleRope GrappleRope;
+
+	FVector VaultStart = FVector::ZeroVector;
+	FVector VaultTarget = FVector::ZeroVector;
+	float VaultDuration = 0.0f;
+	float VaultElapsed = 0.0f;
+
+	//Set by the move that finishes the vault, the character is told after the move rather than in the middle of it
+	bool bVaultFinished = false;
+
+	void PhysWallRun(float deltaTime, int32 Iterations);
+	void PhysGrappleSwing(float deltaTime, int32 Iterations);
+	void PhysVault(float deltaTime, int32 Iterations);
+
+	/// <summary>
+	/// Moves by a delta, sliding along anything hit on the way
+	/// </summary>
+	/// <returns>true if the player landed on a walkable floor, the movement mode has changed if so</returns>
+	bool MoveAndSlide(const FVector& Delta, const FQuat& Rotation, float timeTick, float remainingTime, int32 Iterations);
+
+	bool CanRunCustomPhysics() const;
+};
@@ -1,7 +1,70 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SkylineShredder.h"
+#include "Misc/CoreDelegates.h"
 #include "Modules/ModuleManager.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, SkylineShredder, "SkylineShredder" );
- 
\ No newline at end of file
+DEFINE_LOG_CATEGORY(LogSkylineShredder);
+
+int32 GParkourSceneQueries = 0;
+int64 GParkourNetMoveBits = 0;
+int64 GParkourNetResponseBits = 0;
+
+DEFINE_STAT(STAT_ParkourTick);
+DEFINE_STAT(STAT_ParkourCheckForWallRunning);
+DEFINE_STAT(STAT_ParkourCheckForClimbing);
+DEFINE_STAT(STAT_ParkourUpdateLedgeProbe);
+DEFINE_STAT(STAT_ParkourCheckForGrapple);
+DEFINE_STAT(STAT_ParkourDoGrapple);
+DEFINE_STAT(STAT_ParkourCheckJump);
+DEFINE_STAT(STAT_ParkourFindGrapplePoint);
+DEFINE_STAT(STAT_ParkourFindLedge);
+DEFINE_STAT(STAT_ParkourPadCallbacks);
+DEFINE_STAT(STAT_ParkourCameraRig);
+
+DEFINE_STAT(STAT_ParkourSceneQueries);
+DEFINE_STAT(STAT_ParkourWallRunTransitions);
+DEFINE_STAT(STAT_ParkourGrappleAttaches);
+DEFINE_STAT(STAT_ParkourPadActivations);
+DEFINE_STAT(STAT_ParkourNetCorrections);
+DEFINE_STAT(STAT_ParkourLedgeProbeHits);
+DEFINE_STAT(STAT_ParkourLedgeProbeFallbacks);
+
+TRACE_DECLARE_INT_COUNTER(ParkourSceneQueries, TEXT("Parkour/SceneQueries"));
+TRACE_DECLARE_INT_COUNTER(ParkourWallRunTransitions, TEXT("Parkour/WallRunTransitions"));
+TRACE_DECLARE_INT_COUNTER(ParkourGrappleAttaches, TEXT("Parkour/GrappleAttaches"));
+TRACE_DECLARE_INT_COUNTER(ParkourPadActivations, TEXT("Parkour/PadActivations"));
+TRACE_DECLARE_INT_COUNTER(ParkourNetCorrections, TEXT("Parkour/NetCorrections"));
+TRACE_DECLARE_INT_COUNTER(ParkourLedgeProbeHits, TEXT("Parkour/LedgeProbeHits"));
+TRACE_DECLARE_INT_COUNTER(ParkourLedgeProbeFallbacks, TEXT("Parkour/LedgeProbeFallbacks"));
+
+class FSkylineShredderModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		//Counter stats clear themselves every frame, the Insights counters have to be cleared here
+		BeginFrameHandle = FCoreDelegates::OnBeginFrame.AddStatic(&FSkylineShredderModule::ResetFrameCounters);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FCoreDelegates::OnBeginFrame.Remove(BeginFrameHandle);
+	}
+
+private:
+	FDelegateHandle BeginFrameHandle;
+
+	static void ResetFrameCounters()
+	{
+		TRACE_COUNTER_SET(ParkourSceneQueries, 0);
+		TRACE_COUNTER_SET(ParkourWallRunTransitions, 0);
+		TRACE_COUNTER_SET(ParkourGrappleAttaches, 0);
+		TRACE_COUNTER_SET(ParkourPadActivations, 0);
+		TRACE_COUNTER_SET(ParkourNetCorrections, 0);
+		TRACE_COUNTER_SET(ParkourLedgeProbeHits, 0);
+		TRACE_COUNTER_SET(ParkourLedgeProbeFallbacks, 0);
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FSkylineShredderModule, SkylineShredder, "SkylineShredder" );
@@ -3,3 +3,62 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "ProfilingDebugging/CountersTrace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_LOG_CATEGORY_EXTERN(LogSkylineShredder, Log, All);
+
+//The number of scene queries the parkour code has issued, sampled and reset by the load benchmark
+extern SKYLINESHREDDER_API int32 GParkourSceneQueries;
+
+//The bits of movement moves received and move responses sent by the server, sampled by the net report
+extern SKYLINESHREDDER_API int64 GParkourNetMoveBits;
+extern SKYLINESHREDDER_API int64 GParkourNetResponseBits;
+
+//Cost of each parkour mechanic, shown with "stat Parkour"
+DECLARE_STATS_GROUP(TEXT("Parkour"), STATGROUP_Parkour, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Tick"), STAT_ParkourTick, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Check For Wall Running"), STAT_ParkourCheckForWallRunning, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Check For Climbing"), STAT_ParkourCheckForClimbing, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Ledge Probe"), STAT_ParkourUpdateLedgeProbe, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Check For Grapple"), STAT_ParkourCheckForGrapple, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Do Grapple"), STAT_ParkourDoGrapple, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Check Jump"), STAT_ParkourCheckJump, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Find Grapple Point"), STAT_ParkourFindGrapplePoint, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Find Baked Ledge"), STAT_ParkourFindLedge, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pad Callbacks"), STAT_ParkourPadCallbacks, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Camera Rig"), STAT_ParkourCameraRig, STATGROUP_Parkour, SKYLINESHREDDER_API);
+
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Scene Queries"), STAT_ParkourSceneQueries, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Wall Run Transitions"), STAT_ParkourWallRunTransitions, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Grapple Attaches"), STAT_ParkourGrappleAttaches, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pad Activations"), STAT_ParkourPadActivations, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Corrections"), STAT_ParkourNetCorrections, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledge Probe Hits"), STAT_ParkourLedgeProbeHits, STATGROUP_Parkour, SKYLINESHREDDER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Ledge Probe Fallbacks"), STAT_ParkourLedgeProbeFallbacks, STATGROUP_Parkour, SKYLINESHREDDER_API);
+
+//The same counters as Insights counters, set back to 0 at the start of every frame
+TRACE_DECLARE_INT_COUNTER_EXTERN(ParkourSceneQueries);
+TRACE_DECLARE_INT_COUNTER_EXTERN(ParkourWallRunTransitions);
+TRACE_DECLARE_INT_COUNTER_EXTERN(ParkourGrappleAttaches);
+TRACE_DECLARE_INT_COUNTER_EXTERN(ParkourPadActivations);
+TRACE_DECLARE_INT_COUNTER_EXTERN(ParkourNetCorrections);
+TRACE_DECLARE_INT_COUNTER_EXTERN(ParkourLedgeProbeHits);
+TRACE_DECLARE_INT_COUNTER_EXTERN(ParkourLedgeProbeFallbacks);
+
+//Scopes a parkour cycle stat. Cycle stats already show up as Insights CPU events when stats are compiled in,
+//builds without stats still get the named CPU event so production captures show the same scopes
+#if STATS
+#define PARKOUR_SCOPE_CYCLE_COUNTER(Stat) SCOPE_CYCLE_COUNTER(Stat)
+#else
+#define PARKOUR_SCOPE_CYCLE_COUNTER(Stat) TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+#endif
+
+//Adds to a per frame parkour counter, in both the stat and the Insights counter
+#define PARKOUR_COUNTER_ADD(Counter, Amount) \
+	do { INC_DWORD_STAT_BY(STAT_##Counter, Amount); TRACE_COUNTER_ADD(Counter, Amount); } while (0)
+
+//Counts scene queries issued by the parkour code
+#define PARKOUR_SCENE_QUERIES(Amount) \
+	do { GParkourSceneQueries += (Amount); PARKOUR_COUNTER_ADD(ParkourSceneQueries, Amount); } while (0)
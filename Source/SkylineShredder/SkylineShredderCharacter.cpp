@@ -1,6 +1,7 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SkylineShredderCharacter.h"
+#include "SkylineShredder.h"
 #include "HeadMountedDisplayFunctionLibrary.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -12,12 +13,24 @@
 #include "Kismet/KismetMathLibrary.h"
 #include <Kismet/KismetSystemLibrary.h>
 #include "Kismet/GameplayStatics.h"
+#include "GrappleComponent.h"
+#include "CameraRigComponent.h"
+#include "GrappleTargetingComponent.h"
+#include "LedgeSubsystem.h"
+#include "WallRunSurfaceSubsystem.h"
+#include "MovementModifierComponent.h"
+#include "SkylineMovementComponent.h"
+#include "RunnerSignificanceSubsystem.h"
+#include "ParkourInputRecording.h"
+#include "ParkourTelemetry.h"
+#include "Net/UnrealNetwork.h"
 #include <Math/Vector.h>
 
 //////////////////////////////////////////////////////////////////////////
 // ATestComplexSystemCharacter
 
-ASkylineShredderCharacter::ASkylineShredderCharacter()
+ASkylineShredderCharacter::ASkylineShredderCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<USkylineMovementComponent>(ACharacter::CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -37,10 +50,9 @@ ASkylineShredderCharacter::ASkylineShredderCharacter()
 	GetCharacterMovement()->JumpZVelocity = 600.f;
 	GetCharacterMovement()->AirControl = 0.2f;
 
-	// Create a camera boom (pulls in towards the player if there is a collision)
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
+	// Create a camera boom (pulls in towards the player if there is a collision, sweeping async, and pulls back and leads further the faster the player goes)
+	CameraBoom = CreateDefaultSubobject<UCameraRigComponent>(TEXT("CameraBoom"));
 	CameraBoom->SetupAttachment(RootComponent);
-	CameraBoom->TargetArmLength = 300.0f; // The camera follows at this distance behind the character	
 	CameraBoom->bUsePawnControlRotation = true; // Rotate the arm based on the controller
 
 	// Create a follow camera
@@ -48,7 +60,17 @@ ASkylineShredderCharacter::ASkylineShredderCharacter()
 	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName); // Attach the camera to the end of the boom and let the boom adjust to match the controller orientation
 	FollowCamera->bUsePawnControlRotation = false; // Camera does not rotate relative to arm
 
+	// Create the movement modifier stack, all speed and gravity changes go through it
+	MovementModifiers = CreateDefaultSubobject<UMovementModifierComponent>(TEXT("MovementModifiers"));
+
+	// Score the grapple points in the background so grappling attaches straight away
+	GrappleTargeting = CreateDefaultSubobject<UGrappleTargetingComponent>(TEXT("GrappleTargeting"));
+	Grapple = CreateDefaultSubobject<UGrappleComponent>(TEXT("Grapple"));
+
 	BaseSpeed = GetCharacterMovement()->MaxWalkSpeed;
+	SkylineMovement = Cast<USkylineMovementComponent>(GetCharacterMovement());
+
+	_simulationStep = 1.0f / ParkourSimulationRate;
 
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named MyCharacter (to avoid direct content references in C++)
@@ -60,66 +82,35 @@ ASkylineShredderCharacter::ASkylineShredderCharacter()
 /// <param name="deltaTime"></param>
 void ASkylineShredderCharacter::Tick(float deltaTime)
 {
-	Super::Tick(deltaTime);
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourTick);
 
-	if (DoubleJumped)
-		DoubleJumped = false;
-
-	//Gets the forward velocity of the player
-	float ForwardVelocity = FVector::DotProduct(GetVelocity(), GetActorForwardVector());
+	//The controller has processed this frame's input by now
+	if (_inputTape)
+		_inputTape->CharacterTick(*this, deltaTime);
 
-	// If Player is not moving at all, decrease momentum drastically.
-	if (!InAction && GetCharacterMovement()->Velocity.Size() <= 0 && _momentum > 0)
-		_momentum -= 5.0f;
-	// If the Player is running on the ground, increase momentum to a point.
-	else if (!InAction && GetCharacterMovement()->IsMovingOnGround() && _momentum <= 600)
-		_momentum += 1.0f;
-	// If the Player is wall running, increase momentum to a point.
-	else if (IsWallRunning)
-		_momentum += 1.0f;
+	Super::Tick(deltaTime);
 
-	// If the Player is running, but not in action, decrease momentum to a point.
-	if (!InAction && GetCharacterMovement()->IsMovingOnGround() && _momentum > 600)
-		_momentum -= 3.0f;
+	//Other players' characters only show the parkour state the server replicates
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+	{
+		PublishAnimSnapshot();
+		return;
+	}
 
-	// If momentum begins to go above this point, set it back to this point.
-	if (_momentum > 1500)
-		_momentum = 1500;
+	SetParkourFlag(PARKOUR_DoubleJumped, false);
 
-	GetCharacterMovement()->MaxWalkSpeed = BaseSpeed + _momentum;
+	//Gets the forward velocity of the player
+	float ForwardVelocity = FVector::DotProduct(GetVelocity(), GetActorForwardVector());
 
-	//Sets the current height of the player for wall running
-	_currentFrameHeight = GetActorLocation().Z;
+	//Jumping, wall running and vaulting are updated by the movement component with each move, see UpdateParkourMove,
+	//and momentum and gravity are stepped with each move too, see AdvanceParkourSimulation
 
-	if (_jumping)
-		CustomJump();
+	//The movement uses the stepped state, so the server and clients get the same speed whatever their framerate.
+	//The interpolated state is only for what is shown, the movement is only written to when the modified speed changes
+	MovementModifiers->SetBaseSpeed(BaseSpeed + _momentum);
 
-	//If the character is falling, check for wallrunning
-	if (GetCharacterMovement()->IsFalling())
-	{
-		CheckForWallRunning();
-		if (!IsWallRunning && !InAction)
-		{
-			_gravity += .05;
-			if (_gravity >= 3.0f)
-				_gravity = 3.0f;
-			GetCharacterMovement()->GravityScale = _gravity;
-		}
-			
-	}
-	//Else...
-	else
-	{
-		//...set wallrunning, inaction, rightside and leftside to be false
-		//to turn off wall running
-		IsWallRunning = false;
-		RightSide = false;
-		LeftSide = false;
-		//Set the gravity scale and plane constraint back to normal
-		_gravity = 0;
-		GetCharacterMovement()->GravityScale = 1.0f;
-		GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, 0.0f, 0.0f));
-	}
+	if (GetCharacterMovement()->IsFalling() && !IsInAction())
+		MovementModifiers->SetBaseGravityScale(_gravity);
 
 	//If the forward velocity is less than 100 and the player is still wallrunning...
 	/*if (ForwardVelocity <= 100.0f && _isWallRunning)
@@ -136,15 +127,6 @@ void ASkylineShredderCharacter::Tick(float deltaTime)
 		//GetWorldTimerManager().SetTimer(timerHandle, this, &ATestComplexSystemCharacter::TurnOffJumpOffWall, 1.5f, false);
 	}
 	*/
-	//Handles grapple and constantly applies Grapple logic
-	if (GrappleHookAttached) {
-		DoGrapple();
-	}
-	//The cooldown timer for boosting currently 2 seconds
-	if (HasAppliedBoost && (GetWorld()->TimeSeconds - LastBoostTime > BoostCooldownTime)) {
-		HasAppliedBoost = false;
-	}
-
 	/*if (IsDashing)
 	{
 		DashTimeRemaining -= deltaTime;
@@ -157,10 +139,384 @@ void ASkylineShredderCharacter::Tick(float deltaTime)
 		}
 	}*/
 
+	//Send the parkour state to the other players
+	if (GetLocalRole() == ROLE_Authority)
+		ParkourNetState.Set(IsWallRunning(), IsWallOnLeft(), IsWallOnRight(), Grapple->IsHookAttached(), NumberOfJumps, _momentum, Grapple->GetHookLocation());
+
+	PublishAnimSnapshot();
+
+	if (_telemetry)
+		RecordTelemetry(deltaTime);
+}
+
+/// <summary>
+/// Pushes this frame's telemetry sample, the file is written on the telemetry writer's own thread
+/// </summary>
+void ASkylineShredderCharacter::RecordTelemetry(float deltaTime)
+{
+	FParkourTelemetrySample sample;
+	sample.Time = GetWorld()->GetTimeSeconds() - _telemetry->GetStartTime();
+	sample.FrameTime = deltaTime;
+	sample.Position = FVector3f(GetActorLocation());
+	sample.Speed = GetVelocity().Size();
+	sample.Momentum = _momentum;
+	sample.Gravity = _gravity;
+	sample.State = ParkourState;
+	sample.Events = _telemetryEvents;
+	_telemetryEvents = 0;
+
+	_telemetry->Record(sample);
+}
+
+/// <summary>
+/// Packs what the animation needs into the snapshot the animation isn't reading and publishes it
+/// </summary>
+void ASkylineShredderCharacter::PublishAnimSnapshot()
+{
+	const uint8 writeIndex = _animSnapshotIndex.load(std::memory_order_relaxed) ^ 1;
+	FParkourAnimSnapshot& snapshot = _animSnapshots[writeIndex];
+
+	const UCharacterMovementComponent* movement = GetCharacterMovement();
+	const FVector velocity = GetVelocity();
+	const bool grappleAttached = Grapple->IsHookAttached();
+
+	snapshot.State = ParkourState;
+	snapshot.Flags = (IsInAction() ? FParkourAnimSnapshot::FLAG_InAction : 0)
+		| (IsWallOnLeft() ? FParkourAnimSnapshot::FLAG_WallOnLeft : 0)
+		| (IsWallOnRight() ? FParkourAnimSnapshot::FLAG_WallOnRight : 0)
+		| (HasDoubleJumped() ? FParkourAnimSnapshot::FLAG_DoubleJumped : 0)
+		| (grappleAttached ? FParkourAnimSnapshot::FLAG_GrappleAttached : 0)
+		| (movement->IsFalling() ? FParkourAnimSnapshot::FLAG_Falling : 0)
+		| (movement->IsMovingOnGround() ? FParkourAnimSnapshot::FLAG_OnGround : 0)
+		| (ShouldPlayerClimb ? FParkourAnimSnapshot::FLAG_ShouldClimb : 0)
+		| (HasMovementInput() ? FParkourAnimSnapshot::FLAG_HasMovementInput : 0);
+	snapshot.NumberOfJumps = (uint8)FMath::Clamp(NumberOfJumps, 0, 255);
+	snapshot.GroundSpeed = velocity.Size2D();
+	snapshot.VerticalSpeed = velocity.Z;
+	snapshot.Momentum = GetInterpolatedMomentum();
+	snapshot.HookLocation = grappleAttached ? Grapple->GetHookLocation() : FVector::ZeroVector;
+
+	_animSnapshotIndex.store(writeIndex, std::memory_order_release);
+}
+
+void ASkylineShredderCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	//The owner predicts its own parkour state through the movement component
+	DOREPLIFETIME_CONDITION(ASkylineShredderCharacter, ParkourNetState, COND_SimulatedOnly);
+}
+
+/// <summary>
+/// Shows the parkour state the server sent for another player
+/// </summary>
+void ASkylineShredderCharacter::OnRep_ParkourNetState()
+{
+	//Set straight to what the server has, other players' characters don't run the state handlers
+	ParkourState = ParkourNetState.HasFlag(FSkylineParkourNetState::FLAG_WallRunning) ? EParkourState::WallRun : EParkourState::None;
+	SetParkourFlag(PARKOUR_WallOnLeft, ParkourNetState.HasFlag(FSkylineParkourNetState::FLAG_LeftSide));
+	SetParkourFlag(PARKOUR_WallOnRight, ParkourNetState.HasFlag(FSkylineParkourNetState::FLAG_RightSide));
+	NumberOfJumps = ParkourNetState.NumberOfJumps;
+	Grapple->SetReplicatedGrapple(ParkourNetState.HasFlag(FSkylineParkourNetState::FLAG_GrappleAttached), ParkourNetState.HookLocation);
+	_previousMomentum = _momentum = ParkourNetState.GetMomentum();
+}
+
+/// <summary>
+/// Picks the parkour simulation rate for this instance
+/// </summary>
+void ASkylineShredderCharacter::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//Dedicated servers can simulate at a cheaper rate since the simulation no longer depends on the framerate
+	float rate = ParkourSimulationRate;
+	if (IsRunningDedicatedServer() && DedicatedServerParkourSimulationRate > 0.0f)
+		rate = DedicatedServerParkourSimulationRate;
+
+	_simulationStep = 1.0f / FMath::Max(rate, 1.0f);
+	_simulationAccumulator = 0.0f;
+
+	//Far away and off screen runners tick less often
+	if (URunnerSignificanceSubsystem* significance = GetWorld()->GetSubsystem<URunnerSignificanceSubsystem>())
+		significance->RegisterRunner(this);
+}
+
+/// <summary>
+/// Stops the runner significance from managing this character
+/// </summary>
+void ASkylineShredderCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (URunnerSignificanceSubsystem* significance = GetWorld()->GetSubsystem<URunnerSignificanceSubsystem>())
+		significance->UnregisterRunner(this);
+
+	//Finish the telemetry session with the run
+	ParkourTelemetry::StopSession(*this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASkylineShredderCharacter::PossessedBy(AController* NewController)
+{
+	Super::PossessedBy(NewController);
+	UpdateTelemetrySession();
+}
+
+void ASkylineShredderCharacter::UnPossessed()
+{
+	Super::UnPossessed();
+	UpdateTelemetrySession();
+}
+
+void ASkylineShredderCharacter::OnRep_Controller()
+{
+	Super::OnRep_Controller();
+	UpdateTelemetrySession();
+}
+
+/// <summary>
+/// Starts a telemetry session when a player on this machine takes control of the character, if sessions are
+/// recorded for every run, and finishes it when they let go
+/// </summary>
+void ASkylineShredderCharacter::UpdateTelemetrySession()
+{
+	const bool localPlayer = IsLocallyControlled() && IsPlayerControlled();
+	if (!localPlayer)
+	{
+		ParkourTelemetry::StopSession(*this);
+		return;
+	}
+
+	if (bRecordTelemetry && !_telemetry)
+	{
+		//Named by the map and the time the run started so every run is its own file
+		const FString sessionName = UWorld::RemovePIEPrefix(GetWorld()->GetMapName()) + TEXT("_") + FDateTime::Now().ToString();
+		ParkourTelemetry::StartSession(*this, sessionName);
+	}
+}
+
+/// <summary>
+/// Advances momentum and gravity by one fixed simulation step.
+/// The rates are per second, tuned so a 60Hz step matches the old per frame amounts
+/// </summary>
+/// <param name="step">the length of the step in seconds</param>
+void ASkylineShredderCharacter::SimulateParkourStep(float step)
+{
+	_previousMomentum = _momentum;
+	_previousGravity = _gravity;
+
+	// If Player is not moving at all, decrease momentum drastically.
+	if (!IsInAction() && GetCharacterMovement()->Velocity.Size() <= 0 && _momentum > 0)
+		_momentum -= 300.0f * step;
+	// If the Player is running on the ground, increase momentum to a point.
+	else if (!IsInAction() && GetCharacterMovement()->IsMovingOnGround() && _momentum <= 600)
+		_momentum += 60.0f * step;
+	// If the Player is wall running, increase momentum to a point.
+	else if (IsWallRunning())
+		_momentum += 60.0f * step;
+
+	// If the Player is running, but not in action, decrease momentum to a point.
+	if (!IsInAction() && GetCharacterMovement()->IsMovingOnGround() && _momentum > 600)
+		_momentum -= 180.0f * step;
+
+	// If momentum begins to go above this point, set it back to this point.
+	if (_momentum > 1500)
+		_momentum = 1500;
+
+	//If the player is falling and not wall running, gravity slowly increases
+	if (GetCharacterMovement()->IsFalling() && !IsInAction())
+	{
+		_gravity += 3.0f * step;
+		if (_gravity >= 3.0f)
+			_gravity = 3.0f;
+	}
+}
+
+/// <summary>
+/// Runs as many fixed simulation steps as the time covers so momentum and
+/// gravity build up at the same rate no matter the framerate or move length
+/// </summary>
+/// <param name="deltaTime">the length of the move</param>
+void ASkylineShredderCharacter::AdvanceParkourSimulation(float deltaTime)
+{
+	_simulationAccumulator += deltaTime;
+	int steps = 0;
+	while (_simulationAccumulator >= _simulationStep && steps < MaxParkourSimulationSteps)
+	{
+		SimulateParkourStep(_simulationStep);
+		_simulationAccumulator -= _simulationStep;
+		steps++;
+	}
+
+	//If the move was too long to catch up on, drop the time that is left over
+	if (_simulationAccumulator >= _simulationStep)
+		_simulationAccumulator = FMath::Fmod(_simulationAccumulator, _simulationStep);
+}
+
+/// <summary>
+/// Gets the whole fixed step simulation, momentum and gravity with their values from the last step and the
+/// time left over towards the next step. It is saved with each move so replaying the move starts from it
+/// </summary>
+/// <returns>the simulation state</returns>
+FParkourSimulationState ASkylineShredderCharacter::GetSimulationState() const
+{
+	FParkourSimulationState state;
+	state.Momentum = _momentum;
+	state.PreviousMomentum = _previousMomentum;
+	state.Gravity = _gravity;
+	state.PreviousGravity = _previousGravity;
+	state.Accumulator = _simulationAccumulator;
+	return state;
+}
+
+void ASkylineShredderCharacter::SetSimulationState(const FParkourSimulationState& state)
+{
+	_momentum = state.Momentum;
+	_previousMomentum = state.PreviousMomentum;
+	_gravity = state.Gravity;
+	_previousGravity = state.PreviousGravity;
+	_simulationAccumulator = state.Accumulator;
+}
+
+void ASkylineShredderCharacter::UpdateParkourMove(float deltaTime)
+{
+	//Sets the current height of the player for wall running
+	_currentFrameHeight = GetActorLocation().Z;
+
+	//Jump presses and releases since the last move, they are sent with the move and replayed with it
+	for (; _pendingJumpToggles > 0; _pendingJumpToggles--)
+		CheckJump();
+
+	if (IsJumpHeld())
+		CustomJump();
+
+	//Only what the current parkour state does is updated
+	(this->*ParkourStateHandlers[(uint8)ParkourState].Update)(deltaTime);
+
 	//Set the last frame height to be the current frame height
 	_lastFrameHeight = _currentFrameHeight;
 }
 
+void ASkylineShredderCharacter::RestoreParkourState(EParkourState state, uint8 flags, int32 jumps)
+{
+	ParkourState = state;
+	_parkourFlags = flags;
+	NumberOfJumps = jumps;
+
+	//Jumping off a wall only lasts as long as its timer
+	if (state != EParkourState::WallJump)
+		GetWorldTimerManager().ClearTimer(timerHandle);
+	else if (!GetWorldTimerManager().IsTimerActive(timerHandle))
+		GetWorldTimerManager().SetTimer(timerHandle, this, &ASkylineShredderCharacter::TurnOffJumpOffWall, .5f, false);
+}
+
+float ASkylineShredderCharacter::GetInterpolatedMomentum() const
+{
+	return FMath::Lerp(_previousMomentum, _momentum, _simulationAccumulator / _simulationStep);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Parkour state
+
+const ASkylineShredderCharacter::FParkourStateHandlers ASkylineShredderCharacter::ParkourStateHandlers[] =
+{
+	/* None */     { nullptr, nullptr, &ASkylineShredderCharacter::UpdateFreeState },
+	/* WallRun */  { &ASkylineShredderCharacter::EnterWallRun, &ASkylineShredderCharacter::ExitWallRun, &ASkylineShredderCharacter::UpdateActionState },
+	/* WallJump */ { &ASkylineShredderCharacter::EnterWallJump, &ASkylineShredderCharacter::ExitWallJump, &ASkylineShredderCharacter::UpdateFreeState },
+	/* Vault */    { nullptr, &ASkylineShredderCharacter::ExitVaultOrClimb, &ASkylineShredderCharacter::UpdateActionState },
+	/* Climb */    { nullptr, &ASkylineShredderCharacter::ExitVaultOrClimb, &ASkylineShredderCharacter::UpdateActionState },
+};
+
+/// <summary>
+/// Leaves the current parkour state and enters a new one, if the parkour state table allows it
+/// </summary>
+/// <returns>true if the player is in the new state</returns>
+bool ASkylineShredderCharacter::SetParkourState(EParkourState state)
+{
+	if (state == ParkourState)
+		return true;
+
+	if (!ParkourStateTable::CanTransition(ParkourState, state))
+		return false;
+
+	if (ParkourStateHandlers[(uint8)ParkourState].Exit)
+		(this->*ParkourStateHandlers[(uint8)ParkourState].Exit)();
+
+	ParkourState = state;
+
+	if (ParkourStateHandlers[(uint8)ParkourState].Enter)
+		(this->*ParkourStateHandlers[(uint8)ParkourState].Enter)();
+
+	return true;
+}
+
+void ASkylineShredderCharacter::EnterWallRun()
+{
+	//Count the frames wall running starts or stops on, whether from a wall or from a jump
+	PARKOUR_COUNTER_ADD(ParkourWallRunTransitions, 1);
+}
+
+void ASkylineShredderCharacter::ExitWallRun()
+{
+	PARKOUR_COUNTER_ADD(ParkourWallRunTransitions, 1);
+
+	//Drop off the wall if the movement is still on it
+	SkylineMovement->StopWallRun();
+}
+
+void ASkylineShredderCharacter::EnterWallJump()
+{
+	//Set a timer to call the turn off wall run function
+	GetWorldTimerManager().SetTimer(timerHandle, this, &ASkylineShredderCharacter::TurnOffJumpOffWall, .5f, false);
+}
+
+void ASkylineShredderCharacter::ExitWallJump()
+{
+	GetWorldTimerManager().ClearTimer(timerHandle);
+}
+
+void ASkylineShredderCharacter::ExitVaultOrClimb()
+{
+	//Stop the vault movement if it is stopped early
+	SkylineMovement->StopVault();
+}
+
+void ASkylineShredderCharacter::UpdateFreeState(float deltaTime)
+{
+	//Keep the ledge probe up to date so climbing doesn't have to trace on the frame it is needed. Only players climb
+	//from it, on their own client and on the server, and replayed moves don't trace again
+	if (bAsyncLedgeDetection && !bClientUpdating && IsPlayerControlled() && (IsLocallyControlled() || HasAuthority()))
+		UpdateLedgeProbe();
+
+	UpdateWallContact();
+}
+
+void ASkylineShredderCharacter::UpdateActionState(float deltaTime)
+{
+	UpdateWallContact();
+}
+
+/// <summary>
+/// Checks for wall running while the character is falling or already wall running, and lets go
+/// of the walls and puts the gravity back to normal otherwise
+/// </summary>
+void ASkylineShredderCharacter::UpdateWallContact()
+{
+	if (GetCharacterMovement()->IsFalling() || SkylineMovement->IsWallRunning())
+	{
+		CheckForWallRunning();
+		return;
+	}
+
+	if (IsWallRunning())
+		SetParkourState(EParkourState::None);
+	SetParkourFlag(PARKOUR_WallOnLeft | PARKOUR_WallOnRight, false);
+
+	//Set the gravity scale back to normal
+	_gravity = 0;
+	_previousGravity = 0;
+	MovementModifiers->SetBaseGravityScale(1.0f);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Input
 
@@ -168,8 +524,8 @@ void ASkylineShredderCharacter::SetupPlayerInputComponent(class UInputComponent*
 {
 	// Set up gameplay key bindings
 	check(PlayerInputComponent);
-	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ASkylineShredderCharacter::CheckJump);
-	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ASkylineShredderCharacter::CheckJump);
+	PlayerInputComponent->BindAction("Jump", IE_Pressed, this, &ASkylineShredderCharacter::InputJumpPressed);
+	PlayerInputComponent->BindAction("Jump", IE_Released, this, &ASkylineShredderCharacter::InputJumpReleased);
 
 	//PlayerInputComponent->BindAction("Grapple", EInputEvent::IE_Pressed, this, &ASkylineShredderCharacter::CheckForGrapple);
 	//PlayerInputComponent->BindAction("Grapple", EInputEvent::IE_Released, this, &ASkylineShredderCharacter::EndGrapple);
@@ -182,9 +538,9 @@ void ASkylineShredderCharacter::SetupPlayerInputComponent(class UInputComponent*
 	// We have 2 versions of the rotation bindings to handle different kinds of devices differently
 	// "turn" handles devices that provide an absolute delta, such as a mouse.
 	// "turnrate" is for devices that we choose to treat as a rate of change, such as an analog joystick
-	PlayerInputComponent->BindAxis("Turn", this, &APawn::AddControllerYawInput);
+	PlayerInputComponent->BindAxis("Turn", this, &ASkylineShredderCharacter::InputTurn);
 	PlayerInputComponent->BindAxis("TurnRate", this, &ASkylineShredderCharacter::TurnAtRate);
-	PlayerInputComponent->BindAxis("LookUp", this, &APawn::AddControllerPitchInput);
+	PlayerInputComponent->BindAxis("LookUp", this, &ASkylineShredderCharacter::InputLookUp);
 	PlayerInputComponent->BindAxis("LookUpRate", this, &ASkylineShredderCharacter::LookUpAtRate);
 
 	// handle touch devices
@@ -201,7 +557,7 @@ void ASkylineShredderCharacter::SetupPlayerInputComponent(class UInputComponent*
 /// <param name="speed">the speed to set the player to</param>
 void ASkylineShredderCharacter::SetMoveSpeed(float speed)
 {
-	GetCharacterMovement()->MaxWalkSpeed = speed;
+	MovementModifiers->SetBaseSpeed(speed);
 }
 
 /// <summary>
@@ -210,28 +566,40 @@ void ASkylineShredderCharacter::SetMoveSpeed(float speed)
 /// <returns>true if the player can climb</returns>
 bool ASkylineShredderCharacter::CheckForClimbing()
 {
-	//Hit result and collision params for use in line tracing
-	FHitResult out;
-	FCollisionQueryParams TraceParams;
-	//Ignores the player for line tracing
-	TraceParams.AddIgnoredActor(this);
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourCheckForClimbing);
 
-	//Get the actor location and forward
-	FVector actorLocation = GetActorLocation();
-	FVector actorForward = GetActorForwardVector();
+	//If the pipelined ledge probe has a result for where the player is now, use it without tracing at all.
+	//The fallbacks to tracing here are counted so the probe can be tuned
+	if (bAsyncLedgeDetection)
+	{
+		if (IsLedgeProbeCurrent())
+		{
+			PARKOUR_COUNTER_ADD(ParkourLedgeProbeHits, 1);
+			return _canClimb;
+		}
+		PARKOUR_COUNTER_ADD(ParkourLedgeProbeFallbacks, 1);
+	}
 
-	//Sets the actor location and forward to what it needs to be to climb
-	actorLocation.Z -= 44.0f;
-	actorForward = actorForward * 70.0f;
+	//Static walls are looked up in the baked ledge data, so only the wall itself needs to be traced to check it is still there
+	bool bakedCanClimb = false;
+	if (CheckForBakedLedge(bakedCanClimb))
+		return bakedCanClimb;
+
+	//Hit result and collision params for use in line tracing
+	FHitResult out;
+	FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(LedgeTrace), false, this);
 
 	//Sets the start location and end location for line tracing
-	FVector startLocation = actorLocation;
-	FVector endLocation = actorLocation + actorForward;
+	FVector startLocation;
+	FVector endLocation;
+	GetLedgeWallTrace(GetActorLocation(), GetActorForwardVector(), startLocation, endLocation);
 
 	//Line traces to the object to climb
 	bool hasHit = GetWorld()->LineTraceSingleByChannel(out, startLocation, endLocation, ECC_Visibility, TraceParams);
+	PARKOUR_SCENE_QUERIES(1);
 
 	//If the line trace hits nothing, return
+	_canClimb = false;
 	if (!hasHit)
 		return false;
 
@@ -239,77 +607,270 @@ bool ASkylineShredderCharacter::CheckForClimbing()
 	_wallLocation = out.Location;
 	_wallNormal = out.Normal;
 
-	//Creates a rotator from the wall normal and gets the forward vector from the wall
-	FRotator rotator = UKismetMathLibrary::MakeRotFromX(_wallNormal);
-	FVector wallForward = UKismetMathLibrary::GetForwardVector(rotator);
-
-	//Sets the start and end location for line tracing using the walls forward and location.
-	//line traces to get the height of the wall to see if the player can vault or climb that high
-	wallForward *= -10.0f;
-	startLocation = (wallForward + _wallLocation);
-	startLocation.Z += 200.0f;
-	endLocation = startLocation;
-	endLocation.Z -= 200.0f;
+	//Line traces to get the height of the wall to see if the player can vault or climb that high
+	//and to get the thickness of the wall
+	FVector heightStart, heightEnd, thicknessStart, thicknessEnd;
+	GetLedgeHeightTraces(_wallLocation, _wallNormal, heightStart, heightEnd, thicknessStart, thicknessEnd);
 
 	//Line trace the wall
-	hasHit = GetWorld()->LineTraceSingleByChannel(out, startLocation, endLocation, ECC_Visibility, TraceParams);
+	FHitResult heightHit;
+	bool heightHasHit = GetWorld()->LineTraceSingleByChannel(heightHit, heightStart, heightEnd, ECC_Visibility, TraceParams);
+	PARKOUR_SCENE_QUERIES(1);
 
 	//If the line trace hits nothing, return
-	if (!hasHit)
+	if (!heightHasHit)
 		return false;
 
-	//Wall height is the out location of the line trace
-	_wallHeight = out.Location;
-	//Sets if the player should climb based off the height of the wall
+	//Line trace the wall to check the thickness
+	FHitResult thicknessHit;
+	GetWorld()->LineTraceSingleByChannel(thicknessHit, thicknessStart, thicknessEnd, ECC_Visibility, TraceParams);
+	PARKOUR_SCENE_QUERIES(1);
+
+	return EvaluateLedge(heightHit, thicknessHit);
+}
+
+/// <summary>
+/// Looks for the wall in front of the player in the baked ledge data and fills in the
+/// same values the climbing traces would
+/// </summary>
+/// <param name="outCanClimb">true if the player can climb the baked wall</param>
+/// <returns>true if a baked wall was found and the wall trace agrees with it, false if the wall needs to be traced</returns>
+bool ASkylineShredderCharacter::CheckForBakedLedge(bool& outCanClimb)
+{
+	ULedgeSubsystem* ledges = GetWorld()->GetSubsystem<ULedgeSubsystem>();
+	if (!ledges)
+		return false;
+
+	FVector startLocation;
+	FVector endLocation;
+	GetLedgeWallTrace(GetActorLocation(), GetActorForwardVector(), startLocation, endLocation);
+
+	FLedgeHit hit;
+	if (!ledges->FindLedge(startLocation, GetActorForwardVector(), 70.0f, hit))
+		return false;
+
+	//Something that isn't baked, like a moving or spawned wall, can be in front of the baked one or the baked wall can
+	//be gone, so the wall trace has to hit the same face or the full traces are used instead
+	FHitResult wallHit;
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(LedgeTrace), false, this);
+	const bool wallHasHit = GetWorld()->LineTraceSingleByChannel(wallHit, startLocation, endLocation, ECC_Visibility, traceParams);
+	PARKOUR_SCENE_QUERIES(1);
+	if (!wallHasHit || FVector::DistSquared(wallHit.Location, hit.WallLocation) > FMath::Square(5.0f) || FVector::DotProduct(wallHit.Normal, hit.WallNormal) < 0.98f)
+		return false;
+
+	_wallLocation = hit.WallLocation;
+	_wallNormal = hit.WallNormal;
+
+	//The height trace only reaches 200 above where the wall was hit, anything taller can't be climbed
+	_canClimb = hit.TopZ - _wallLocation.Z <= 200.0f;
+	outCanClimb = _canClimb;
+	if (!_canClimb)
+		return true;
+
+	//The top of the wall just inside the face, where the height trace would have hit
+	_wallHeight = _wallLocation - _wallNormal * 10.0f;
+	_wallHeight.Z = hit.TopZ;
 	ShouldPlayerClimb = _wallHeight.Z - _wallLocation.Z > 50.0f;
 
+	//The thickness trace lands 50 inside the face, on top of the wall if it is thick enough or on the ground behind it
+	_isWallThick = hit.Thickness > 50.0f;
+	_otherWallHeight = _wallLocation - _wallNormal * 50.0f;
+	_otherWallHeight.Z = _isWallThick ? hit.TopZ : hit.BottomZ;
+
+	return true;
+}
+
+/// <summary>
+/// Gets the trace that looks for a wall in front of the player
+/// </summary>
+void ASkylineShredderCharacter::GetLedgeWallTrace(const FVector& location, const FVector& forward, FVector& outStart, FVector& outEnd) const
+{
+	//Sets the actor location and forward to what it needs to be to climb
+	outStart = location;
+	outStart.Z -= 44.0f;
+	outEnd = outStart + forward * 70.0f;
+}
+
+/// <summary>
+/// Gets the traces that find the height and the thickness of a wall that was hit
+/// </summary>
+void ASkylineShredderCharacter::GetLedgeHeightTraces(const FVector& wallLocation, const FVector& wallNormal, FVector& outHeightStart, FVector& outHeightEnd, FVector& outThicknessStart, FVector& outThicknessEnd) const
+{
 	//Creates a rotator from the wall normal and gets the forward vector from the wall
-	rotator = UKismetMathLibrary::MakeRotFromX(_wallNormal);
-	wallForward = UKismetMathLibrary::GetForwardVector(rotator);
+	FRotator rotator = UKismetMathLibrary::MakeRotFromX(wallNormal);
+	FVector wallForward = UKismetMathLibrary::GetForwardVector(rotator);
 
 	//Sets the start and end location for line tracing using the walls forward and location.
-	//Line traces to get the thickness of the wall
-	wallForward *= -50.0f;
-	startLocation = (wallForward + _wallLocation);
-	startLocation.Z += 250.0f;
-	endLocation = startLocation;
-	endLocation.Z -= 300.0f;
-
-	//Line trace the wall to check the thickness 
-	hasHit = GetWorld()->LineTraceSingleByChannel(out, startLocation, endLocation, ECC_Visibility, TraceParams);
+	//The height trace is just inside the wall, from above down to where the wall was hit
+	outHeightStart = wallForward * -10.0f + wallLocation;
+	outHeightStart.Z += 200.0f;
+	outHeightEnd = outHeightStart;
+	outHeightEnd.Z -= 200.0f;
+
+	//The thickness trace is further into the wall and goes below where the wall was hit
+	outThicknessStart = wallForward * -50.0f + wallLocation;
+	outThicknessStart.Z += 250.0f;
+	outThicknessEnd = outThicknessStart;
+	outThicknessEnd.Z -= 300.0f;
+}
 
-	//If the line trace hits nothing, the wall is not thick
-	if (!hasHit)
-		_isWallThick = false;
+/// <summary>
+/// Works out if the wall can be climbed or vaulted from the height and thickness traces.
+/// The height trace must have hit, a missed thickness trace is passed in as an empty hit result
+/// </summary>
+/// <returns>true if the player can climb</returns>
+bool ASkylineShredderCharacter::EvaluateLedge(const FHitResult& heightHit, const FHitResult& thicknessHit)
+{
+	//Wall height is the out location of the line trace
+	_wallHeight = heightHit.Location;
+	//Sets if the player should climb based off the height of the wall
+	ShouldPlayerClimb = _wallHeight.Z - _wallLocation.Z > 50.0f;
 
 	//The height of the other wall is the line traces hit location
-	_otherWallHeight = out.Location;
+	_otherWallHeight = thicknessHit.Location;
 
 	float wallThickness = _wallHeight.Z - _otherWallHeight.Z;
-	FString debugMessage = FString::SanitizeFloat(_otherWallHeight.Z);
-	//GEngine->AddOnScreenDebugMessage(1, 2.5f, FColor::Blue, debugMessage);
 
 	//Sets if the wall is too thick based off the width of the walls hit
 	_isWallThick = !(_wallHeight.Z - _otherWallHeight.Z > 10.0f);
 	if (wallThickness == 0.0f)
 		_isWallThick = false;
 
+	_canClimb = true;
 	return true;
 }
 
+/// <summary>
+/// Advances the pipelined ledge probe. The wall trace is issued asynchronously from where the player
+/// will be when its results are published, whenever that has moved or turned enough, and once it comes
+/// back the height and thickness traces are issued together. The finished result is what CheckForClimbing
+/// hands to StartVaultOrGetUp
+/// </summary>
+void ASkylineShredderCharacter::UpdateLedgeProbe()
+{
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourUpdateLedgeProbe);
+
+	UWorld* world = GetWorld();
+	FTraceDatum heightData;
+	FTraceDatum thicknessData;
+
+	//Publish the height and thickness traces once they are both back, unless a wall trace issued after theirs
+	//has already published that there is nothing in front of the player
+	if (_ledgeProbe.HeightTrace.IsValid() && world->QueryTraceData(_ledgeProbe.HeightTrace, heightData) && world->QueryTraceData(_ledgeProbe.ThicknessTrace, thicknessData))
+	{
+		if (IsLedgeProbeRequestNewer(_ledgeProbe.LedgeRequestFrame))
+		{
+			_wallLocation = _ledgeProbe.WallLocation;
+			_wallNormal = _ledgeProbe.WallNormal;
+
+			_canClimb = false;
+			if (heightData.OutHits.Num() > 0 && heightData.OutHits[0].bBlockingHit)
+				EvaluateLedge(heightData.OutHits[0], thicknessData.OutHits.Num() > 0 && thicknessData.OutHits[0].bBlockingHit ? thicknessData.OutHits[0] : FHitResult());
+
+			PublishLedgeProbe(_ledgeProbe.LedgeTraceLocation, _ledgeProbe.LedgeTraceForward, _ledgeProbe.LedgeRequestFrame);
+		}
+
+		_ledgeProbe.HeightTrace = FTraceHandle();
+		_ledgeProbe.ThicknessTrace = FTraceHandle();
+	}
+	//Trace results only live for one frame, so give up on traces that were missed
+	else if (_ledgeProbe.HeightTrace.IsValid() && GFrameCounter > _ledgeProbe.LedgeTraceFrame + 1)
+	{
+		_ledgeProbe.HeightTrace = FTraceHandle();
+		_ledgeProbe.ThicknessTrace = FTraceHandle();
+	}
+
+	FCollisionQueryParams traceParams(SCENE_QUERY_STAT(LedgeTrace), false, this);
+
+	//When the wall trace comes back, issue the height and thickness traces from where it hit
+	FTraceDatum wallData;
+	if (_ledgeProbe.WallTrace.IsValid() && world->QueryTraceData(_ledgeProbe.WallTrace, wallData))
+	{
+		_ledgeProbe.WallTrace = FTraceHandle();
+
+		if (wallData.OutHits.Num() > 0 && wallData.OutHits[0].bBlockingHit)
+		{
+			_ledgeProbe.WallLocation = wallData.OutHits[0].Location;
+			_ledgeProbe.WallNormal = wallData.OutHits[0].Normal;
+			_ledgeProbe.LedgeTraceLocation = _ledgeProbe.WallTraceLocation;
+			_ledgeProbe.LedgeTraceForward = _ledgeProbe.WallTraceForward;
+			_ledgeProbe.LedgeTraceFrame = GFrameCounter;
+			_ledgeProbe.LedgeRequestFrame = _ledgeProbe.WallTraceFrame;
+
+			FVector heightStart, heightEnd, thicknessStart, thicknessEnd;
+			GetLedgeHeightTraces(_ledgeProbe.WallLocation, _ledgeProbe.WallNormal, heightStart, heightEnd, thicknessStart, thicknessEnd);
+			_ledgeProbe.HeightTrace = world->AsyncLineTraceByChannel(EAsyncTraceType::Single, heightStart, heightEnd, ECC_Visibility, traceParams);
+			_ledgeProbe.ThicknessTrace = world->AsyncLineTraceByChannel(EAsyncTraceType::Single, thicknessStart, thicknessEnd, ECC_Visibility, traceParams);
+			PARKOUR_SCENE_QUERIES(2);
+		}
+		//Nothing in front of the player, so there is nothing to climb
+		else if (IsLedgeProbeRequestNewer(_ledgeProbe.WallTraceFrame))
+		{
+			_canClimb = false;
+			PublishLedgeProbe(_ledgeProbe.WallTraceLocation, _ledgeProbe.WallTraceForward, _ledgeProbe.WallTraceFrame);
+		}
+	}
+	else if (_ledgeProbe.WallTrace.IsValid() && GFrameCounter > _ledgeProbe.WallTraceFrame + 1)
+	{
+		_ledgeProbe.WallTrace = FTraceHandle();
+	}
+
+	//The results are published two frames after the wall trace is issued, so trace from where the velocity
+	//takes the player by then. Only issue a new wall trace when that has moved or turned past the thresholds
+	const FVector location = GetActorLocation() + GetVelocity() * (2.0f * world->GetDeltaSeconds());
+	const FVector forward = GetActorForwardVector();
+	if (!_ledgeProbe.WallTrace.IsValid() && !IsLedgePoseClose(_ledgeProbe.WallTraceLocation, _ledgeProbe.WallTraceForward, location, forward))
+	{
+		_ledgeProbe.WallTraceLocation = location;
+		_ledgeProbe.WallTraceForward = forward;
+		_ledgeProbe.WallTraceFrame = GFrameCounter;
+
+		FVector startLocation;
+		FVector endLocation;
+		GetLedgeWallTrace(location, forward, startLocation, endLocation);
+		_ledgeProbe.WallTrace = world->AsyncLineTraceByChannel(EAsyncTraceType::Single, startLocation, endLocation, ECC_Visibility, traceParams);
+		PARKOUR_SCENE_QUERIES(1);
+	}
+}
+
+/// <summary>
+/// Marks the ledge values as belonging to the pose the probe was issued from
+/// </summary>
+void ASkylineShredderCharacter::PublishLedgeProbe(const FVector& location, const FVector& forward, uint64 requestFrame)
+{
+	_ledgeProbe.bHasResult = true;
+	_ledgeProbe.ResultFrame = requestFrame;
+	_ledgeProbe.ResultLocation = location;
+	_ledgeProbe.ResultForward = forward;
+}
+
+/// <summary>
+/// Checks if the last published ledge result can still be used. It can for as long as the player is
+/// within the move and turn thresholds of where its traces expected the player to be, however old it is
+/// </summary>
+bool ASkylineShredderCharacter::IsLedgeProbeCurrent() const
+{
+	return _ledgeProbe.bHasResult
+		&& IsLedgePoseClose(_ledgeProbe.ResultLocation, _ledgeProbe.ResultForward, GetActorLocation(), GetActorForwardVector());
+}
+
+/// <summary>
+/// Checks if two poses are within the ledge probe move and turn thresholds
+/// </summary>
+bool ASkylineShredderCharacter::IsLedgePoseClose(const FVector& locationA, const FVector& forwardA, const FVector& locationB, const FVector& forwardB) const
+{
+	return FVector::DistSquared(locationA, locationB) <= FMath::Square(LedgeProbeMoveThreshold)
+		&& FVector::DotProduct(forwardA, forwardB) >= FMath::Cos(FMath::DegreesToRadians(LedgeProbeTurnThreshold));
+}
+
 /// <summary>
 /// Starts vaulting functionality
 /// </summary>
 void ASkylineShredderCharacter::StartVaultOrGetUp()
 {
-	//If already in action, return then set in action  and is climbing to be true
-	if (InAction || IsClimbing || IsVaulting)
+	//If the wall is too thick to vault over climb on top of it, if already in action return
+	if (!SetParkourState(_isWallThick ? EParkourState::Climb : EParkourState::Vault))
 		return;
-	InAction = true;
-
-	//Set the player collision to be off and movement mode to be none
-	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-	GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_Flying);
 
 	//Make a new vector for use in setting the actors location
 	FVector actorNewLocation;
@@ -317,8 +878,6 @@ void ASkylineShredderCharacter::StartVaultOrGetUp()
 	//If the wall is too thick to vault over, then climb on top of the object
 	if (_isWallThick)
 	{
-		//Set climing to be true
-		IsClimbing = true;
 		//Create a rotator from the walls normal and get the wall forward based off of that
 		FRotator rotator = UKismetMathLibrary::MakeRotFromX(_wallNormal);
 		FVector wallForward = UKismetMathLibrary::GetForwardVector(rotator);
@@ -327,27 +886,23 @@ void ASkylineShredderCharacter::StartVaultOrGetUp()
 		//Set the new location to be where the player is plus the wall forward
 		//This is so the animation can play smoothly
 		actorNewLocation = wallForward + GetActorLocation();
-		SetActorLocation(actorNewLocation);
 	}
 
 	//If the wall is not too thick then the player can vault
 	else
 	{
-		//Set is vaulting to be true
-		IsVaulting = true;
 		//Set the new location to be the players location
 		//And the height is equal to the wall height minus 20
 		//This si so the animation can play smoothly
 		actorNewLocation = GetActorLocation();
 		actorNewLocation.Z = _wallHeight.Z - 20.0f;
-		SetActorLocation(actorNewLocation);
-
 	}
 
-	_momentum += 200.0f;
+	SetMomentum(GetMomentum() + 200.0f);
 
-	//Set a timer so after the animation plays the collision, movement, and consequent booleans are set off
-	GetWorldTimerManager().SetTimer(timerHandle, this, &ASkylineShredderCharacter::StopVaultOrGetUp, .15f, false);
+	//Move the player there in the vault movement mode, it slides over the ledge so the player can't catch on it
+	//and calls StopVaultOrGetUp after the move that gets the player there
+	SkylineMovement->StartVault(actorNewLocation, .15f);
 }
 
 /// <summary>
@@ -355,15 +910,9 @@ void ASkylineShredderCharacter::StartVaultOrGetUp()
 /// </summary>
 void ASkylineShredderCharacter::StopVaultOrGetUp()
 {
-	//Set the movement and collision back to normal
-	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
-	GetCharacterMovement()->SetMovementMode(EMovementMode::MOVE_Walking);
+	//The action is done, leaving it stops the vault movement if it is stopped early
+	SetParkourState(EParkourState::None);
 	TurnOffJumpOffWall();
-
-	//Set the booleans to be false since the action is done
-	InAction = false;
-	IsClimbing = false;
-	IsVaulting = false;
 }
 
 /// <summary>
@@ -373,18 +922,20 @@ void ASkylineShredderCharacter::StopVaultOrGetUp()
 /// </summary>
 void ASkylineShredderCharacter::CheckForWallRunning()
 {
-	if (GrappleHookAttached)
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourCheckForWallRunning);
+
+	if (Grapple->IsHookAttached())
 		return;
-	if (GetInputAxisValue("MoveForward") == 0.0f && GetInputAxisValue("MoveRight") == 0.0f && IsWallRunning)
+	if (!HasMovementInput() && IsWallRunning())
 	{ 
-		//Set the gravity scale and plane constraints back to normal
-		GetCharacterMovement()->GravityScale = 1.0f;
-		GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, 0.0f, 0.0f));
+		//Drop off the wall
+		SetParkourState(EParkourState::None);
+		SetParkourFlag(PARKOUR_WallOnLeft | PARKOUR_WallOnRight, false);
 
 		//Get the right vector and select if the player launches to the right or the left
 		//based off if the player is on the right side of a wall or not
 		FVector actorRightVector = GetActorRightVector();
-		FVector launchVelocity = UKismetMathLibrary::SelectVector(actorRightVector * -250.0f, actorRightVector * 250.0f, _onRightSide);
+		FVector launchVelocity = UKismetMathLibrary::SelectVector(actorRightVector * -250.0f, actorRightVector * 250.0f, HasParkourFlag(PARKOUR_LastWallOnRight));
 
 		//Set the launch velocity z to be higher
 		launchVelocity.Z = 0.0f;
@@ -393,188 +944,152 @@ void ASkylineShredderCharacter::CheckForWallRunning()
 		LaunchCharacter(launchVelocity, false, false);
 
 		NumberOfJumps = 1;
-
-		IsWallRunning = false;
-		InAction = false;
-		LeftSide = false;
-		RightSide = false;
-
 		return;
 	}
 		
-	//If the player is not on the left side of the wall
-	if (!LeftSide)
-	{
-
-		//Hit result and collision params for use in line tracing
-		FHitResult out;
-		//FCollisionQueryParams TraceParams;
-
-		TArray<AActor*> Actors;
-		//Ignores the player for line tracing
-		//TraceParams.AddIgnoredActor(this);
+	//Probe both sides of the player once, the result is shared by both sides below
+	FWallRunContact rightContact;
+	FWallRunContact leftContact;
+	ProbeWallRunContacts(rightContact, leftContact);
 
-		//Create a start location and end location for use in line tracing
-		//The start location is the actors location and the end location is to the right of the player
-		FVector startLocation = GetActorLocation();
-		FVector endLocation = (GetActorRightVector() * 50.0f) + startLocation;
+	//The player can only take hold of a wall while falling downwards and not on the ground
+	const bool canHoldWall = _currentFrameHeight - _lastFrameHeight <= 0.0f && !GetCharacterMovement()->IsMovingOnGround();
 
-		//Line trace to the right
-		//bool hasHit = GetWorld()->LineTraceSingleByChannel(out, startLocation, endLocation, ECC_Visibility, TraceParams);
-		bool hasHit = UKismetSystemLibrary::SphereTraceSingle(GetWorld(), startLocation, endLocation, 30.0f, ObjectType, false, Actors, EDrawDebugTrace::None, out, true);
-
-		//If the line trace has hit a wall, and the player is falling downwards, and the player is on the ground
-		if (hasHit && _currentFrameHeight - _lastFrameHeight <= 0.0f && !GetCharacterMovement()->IsMovingOnGround())
+	//If the player is not on the left side of the wall
+	if (!IsWallOnLeft())
+	{
+		//If the probe has found a wall on the right
+		if (rightContact.bHit && canHoldWall)
 		{
-			if (!out.GetActor())
-			{
-				//GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, out.GetComponent()->GetFName().ToString());
-				for (int i = 0; i < out.GetComponent()->ComponentTags.Num(); i++)
-				{
-					
-					//GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString("hi"));
-					//GEngine->AddOnScreenDebugMessage(-1, 15.0f, FColor::Yellow, FString(out.GetComponent()->ComponentTags[i].ToString()));
-				}
-				
-				
+			//If the wall has no actor or is tagged not to wall run on, return
+			if (!rightContact.bWallRunnable)
 				return;
-			}
-				
-			//If the wall is tagged not to wall run on, return
-			if (out.GetActor()->ActorHasTag("NoWallrun"))
-				return;
-
-			//Set right side and on right side to be true
-			RightSide = true;
-			_onRightSide = true;
 
-			//If the player is not jumping off of the wall
-			if (!_isJumpingOffWall)
-			{
-				//Set in action to be true
-				InAction = true;
-
-				//Create a new rotator from the walls normal
-				FRotator newRotation = UKismetMathLibrary::MakeRotFromX(out.Normal);
-				//Set the rotation to be exactly 90 degrees
-				newRotation.Yaw += 90.0f;
-				newRotation.Roll = 0.0f;
-				newRotation.Pitch = 0.0f;
-				//Set the players rotation
-				SetActorRotation(newRotation);
-
-				//Get the actors forward
-				FVector actorForward = GetActorForwardVector();
-				//Set it to be straight ahead with no up or down movement
-				actorForward.X *= FMath::Clamp(GetVelocity().Size(), 0.0f, 1200.0f + GetMomentum());
-				
-				actorForward.Y *= FMath::Clamp(GetVelocity().Size(), 0.0f, 1200.0f + GetMomentum());
-				actorForward.Z = 0.0f;
-
-				//Set the gravity scale to be higher than normal to slowly fall off the wall
-				//Set the velocity to be the actors forward
-				//Set the plane constraint to be 1 on the z to lock the player
-				GetCharacterMovement()->GravityScale = 15.0f;
-				GetCharacterMovement()->Velocity = actorForward;
-				GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, 0.0f, 1.0f));
-
-				//Set is wall running to be true
-				IsWallRunning = true;
-				_gravity = 0;
-			}
+			StartWallRun(rightContact, true);
 		}
-
-		//If none of the if statements are true
 		else
 		{
-			//Set the booleans to be false
-			IsWallRunning = false;
-			InAction = false;
-			RightSide = false;
-			//Set the gravity scale and plane constraints back to normal
-			GetCharacterMovement()->GravityScale = 1.0f;
-			GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, 0.0f, 0.0f));
+			LeaveWall(PARKOUR_WallOnRight);
 		}
 	}
 
 	//If the player is not on the right side
-	if (!RightSide)
+	if (!IsWallOnRight())
 	{
-		//Hit result and collision params for use in line tracing
-		FHitResult out;
-		FCollisionQueryParams TraceParams;
-		//Ignores the player for line tracing
-		TraceParams.AddIgnoredActor(this);
-		TArray<AActor*> Actors;
-
-		//Create a start location and end location for use in line tracing
-		//The start location is the actors location and the end location is to the left of the player
-		FVector startLocation = GetActorLocation();
-		FVector endLocation = (GetActorRightVector() * -50.0f) + startLocation;
-
-		//Line trace to the left
-		//bool hasHit = GetWorld()->LineTraceSingleByChannel(out, startLocation, endLocation, ECC_Visibility, TraceParams);
-		bool hasHit = UKismetSystemLibrary::SphereTraceSingle(GetWorld(), startLocation, endLocation, 30.0f, ObjectType, false, Actors, EDrawDebugTrace::None, out, true);
-
-		//If the line trace has hit a wall, and the player is falling downwards, and the player is on the ground
-		if (hasHit && _currentFrameHeight - _lastFrameHeight <= 0.0f && !GetCharacterMovement()->IsMovingOnGround())
+		//If the probe has found a wall on the left
+		if (leftContact.bHit && canHoldWall)
 		{
-			if (!out.GetActor())
-				return;
-			//If the wall is tagged not to wall run on, return
-			if (out.GetActor()->ActorHasTag("NoWallrun"))
+			//If the wall has no actor or is tagged not to wall run on, return
+			if (!leftContact.bWallRunnable)
 				return;
 
-			//Set left side to be true and on right side to be false
-			LeftSide = true;
-			_onRightSide = false;
-
-			//If the player is not jumping off the wall
-			if (!_isJumpingOffWall)
-			{
-				//Set in action to be true
-				InAction = true;
-
-				//Create a new rotator from the walls normal
-				FRotator newRotation = UKismetMathLibrary::MakeRotFromX(out.Normal);
-				//Set the rotation to be exactly negative 90 degrees
-				newRotation.Yaw -= 90.0f;
-				newRotation.Roll = 0.0f;
-				newRotation.Pitch = 0.0f;
-				//Set the players rotation
-				SetActorRotation(newRotation);
-
-				//Get the actors forward
-				FVector actorForward = GetActorForwardVector();
-				//Set it to be straight ahead with no up or down movement
-				actorForward.X *= FMath::Clamp(GetVelocity().Size(), 0.0f, 1200.0f + GetMomentum());
-				actorForward.Y *= FMath::Clamp(GetVelocity().Size(), 0.0f, 1200.0f + GetMomentum());
-				actorForward.Z = 0.0f;
-
-				//Set the gravity scale to be higher than normal to slowly fall off the wall
-				//Set the velocity to be the actors forward
-				//Set the plane constraint to be 1 on the z to lock the player
-				GetCharacterMovement()->GravityScale = 15.0f;
-				GetCharacterMovement()->Velocity = actorForward;
-				GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, 0.0f, 1.0f));
-
-				//Set is wallrunning to be true
-				IsWallRunning = true;
-				_gravity = 0;
-			}
+			StartWallRun(leftContact, false);
 		}
-
-		//If none of the if statements are true
 		else
 		{
-			//Set the booleans to be false
-			IsWallRunning = false;
-			InAction = false;
-			LeftSide = false;
-			//Set the gravity scale and plane constraints back to normal
-			GetCharacterMovement()->GravityScale = 1.0f;
-			GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, 0.0f, 0.0f));
+			LeaveWall(PARKOUR_WallOnLeft);
+		}
+	}
+}
+
+/// <summary>
+/// Holds onto a wall the probe found and runs on it, unless the player is jumping off a wall
+/// </summary>
+/// <param name="contact">the wall</param>
+/// <param name="bOnRight">if the wall is on the right of the player</param>
+void ASkylineShredderCharacter::StartWallRun(const FWallRunContact& contact, bool bOnRight)
+{
+	SetParkourFlag(bOnRight ? PARKOUR_WallOnRight : PARKOUR_WallOnLeft, true);
+	SetParkourFlag(PARKOUR_LastWallOnRight, bOnRight);
+
+	//When the wall run starts, turn the player to run exactly along the wall
+	if (!IsWallRunning())
+	{
+		if (!SetParkourState(EParkourState::WallRun))
+			return;
+
+		//Create a new rotator from the walls normal
+		FRotator newRotation = UKismetMathLibrary::MakeRotFromX(contact.Normal);
+		//Set the rotation to be exactly 90 degrees to the wall
+		newRotation.Yaw += bOnRight ? 90.0f : -90.0f;
+		newRotation.Roll = 0.0f;
+		newRotation.Pitch = 0.0f;
+		//Set the players rotation
+		SetActorRotation(newRotation);
+	}
+
+	//The wall run movement mode keeps the player level and running along the wall
+	SkylineMovement->SetWallRun(contact.Normal, 1200.0f + GetMomentum());
+	_gravity = 0;
+}
+
+/// <summary>
+/// Lets go of the wall on one side, and drops off it if the player was running on it
+/// </summary>
+void ASkylineShredderCharacter::LeaveWall(uint8 sideFlag)
+{
+	SetParkourFlag(sideFlag, false);
+	if (IsWallRunning())
+		SetParkourState(EParkourState::None);
+}
+
+/// <summary>
+/// Finds the closest wall on each side of the player. A single capsule lying along the
+/// players right vector covers the same space as a radius 30 sphere swept 50 units to
+/// either side, and each overlapped wall is put on a side using its closest point
+/// </summary>
+/// <param name="outRight">the wall on the right of the player</param>
+/// <param name="outLeft">the wall on the left of the player</param>
+void ASkylineShredderCharacter::ProbeWallRunContacts(FWallRunContact& outRight, FWallRunContact& outLeft) const
+{
+	const FVector location = GetActorLocation();
+	const FVector rightVector = GetActorRightVector();
+
+	//Capsules are built along Z so rotate it to lie along the right vector
+	const FQuat orientation = FRotationMatrix::MakeFromZ(rightVector).ToQuat();
+	const FCollisionShape shape = FCollisionShape::MakeCapsule(30.0f, 80.0f);
+
+	FCollisionQueryParams params(SCENE_QUERY_STAT(WallRunProbe), false, this);
+	UWallRunSurfaceSubsystem* surfaces = GetWorld()->GetSubsystem<UWallRunSurfaceSubsystem>();
+	TArray<FOverlapResult> overlaps;
+	GetWorld()->OverlapMultiByChannel(overlaps, location, orientation, UEngineTypes::ConvertToCollisionChannel(ObjectType), shape, params);
+	PARKOUR_SCENE_QUERIES(1);
+
+	for (const FOverlapResult& overlap : overlaps)
+	{
+		//Only walls that block the channel can be run on, touching ones are triggers and the like
+		UPrimitiveComponent* component = overlap.GetComponent();
+		if (!component || !overlap.bBlockingHit)
+			continue;
+
+		//Find the point on the wall closest to the player, falling back to the bounds for complex only collision
+		FVector closestPoint;
+		float distance = component->GetClosestPointOnCollision(location, closestPoint);
+		if (distance < 0.0f)
+		{
+			closestPoint = component->Bounds.GetBox().GetClosestPointTo(location);
+			distance = FVector::Distance(closestPoint, location);
 		}
+
+		//The side of the wall is the side its closest point is on
+		const FVector offset = closestPoint - location;
+		const bool onRight = FVector::DotProduct(offset, rightVector) >= 0.0f;
+		FWallRunContact& contact = onRight ? outRight : outLeft;
+		if (contact.bHit && contact.Distance <= distance)
+			continue;
+
+		//The wall normal points from the wall back towards the player
+		contact.bHit = true;
+		contact.Distance = distance;
+		contact.Normal = distance > KINDA_SMALL_NUMBER ? -offset / distance : (onRight ? -rightVector : rightVector);
+		contact.Actor = overlap.GetActor();
+		contact.Component = component;
+
+		//Look up if the wall can be run on, and use its cached face so the run direction is stable.
+		//Worlds without the subsystem work the surface out each time
+		const FWallRunSurface surface = surfaces ? surfaces->GetSurface(component) : UWallRunSurfaceSubsystem::BuildSurface(component);
+		contact.bWallRunnable = surface.bWallRunnable;
+		contact.Normal = surface.SnapNormal(contact.Normal);
 	}
 }
 
@@ -589,7 +1104,7 @@ void ASkylineShredderCharacter::Landed(const FHitResult& Hit)
 
 	//Sets number of jumps to 0 amd double jumped to false to reset the double jump
 	NumberOfJumps = 0;
-	DoubleJumped = false;
+	SetParkourFlag(PARKOUR_DoubleJumped, false);
 	TurnOffJumpOffWall();
 }
 
@@ -598,22 +1113,27 @@ void ASkylineShredderCharacter::Landed(const FHitResult& Hit)
 /// </summary>
 void ASkylineShredderCharacter::CheckJump()
 {
+	PARKOUR_SCOPE_CYCLE_COUNTER(STAT_ParkourCheckJump);
+
+	//Only pressing jump jumps off a wall, letting go of it doesn't
+	const bool pressed = !IsJumpHeld();
+
 	//if currently jumping, set it to false
-	if (_jumping)
+	if (IsJumpHeld())
 	{
-		_jumping = false;
+		SetParkourFlag(PARKOUR_JumpHeld, false);
 	}
 	//If the player presses jump and is not currently jumping
 	else
 	{
 		//Set jumping to true and add one to the number of jumps variable
-		_jumping = true;
+		SetParkourFlag(PARKOUR_JumpHeld, true);
 		NumberOfJumps++;
 		//If the player is able to double jump and is not grappling
-		if (NumberOfJumps == 2 && GetCharacterMovement()->IsFalling() && !GrappleHookAttached)
+		if (NumberOfJumps == 2 && GetCharacterMovement()->IsFalling() && !Grapple->IsHookAttached())
 		{	
 			//Double jump
-			DoubleJumped = true;
+			SetParkourFlag(PARKOUR_DoubleJumped, true);
 
 			//Get the players current velocity and then set it to 0
 			FVector currentVelocity = GetCharacterMovement()->Velocity;
@@ -621,8 +1141,8 @@ void ASkylineShredderCharacter::CheckJump()
 			GetCharacterMovement()->Velocity = FVector{ 0.0f, 0.0f, 0.0f };
 
 			//If the player is not moving then the double jump is straight up
-			if (GetInputAxisValue("MoveForward") == 0.0f && GetInputAxisValue("MoveRight") == 0.0f)
-				GetCharacterMovement()->AddImpulse(FVector{ 0.0f, 0.0f, 150000.0f });
+			if (!HasMovementInput())
+				MovementModifiers->AddImpulse(FVector{ 0.0f, 0.0f, 150000.0f });
 			//If the player is moving
 			else
 			{
@@ -630,24 +1150,22 @@ void ASkylineShredderCharacter::CheckJump()
 				float newYForward = GetVelocity().GetSafeNormal().Y;
 				//Make the player double jump in the direction they are facing, with respect to momentum and the original velocity
 				FVector doubleJumpForce = FVector{ (GetActorForwardVector().X + newXForward) * (50000.0f + GetMomentum() * 50.0f), (GetActorForwardVector().Y + newYForward) * (50000.0f + GetMomentum() * 50.0f), 150000.0f };
-				GetCharacterMovement()->AddImpulse(doubleJumpForce + (currentVelocity * 50.0f));
+				MovementModifiers->AddImpulse(doubleJumpForce + (currentVelocity * 50.0f));
 			}
 				
 		}
 	}
 
 
-	//If the player is wall running
-	if (IsWallRunning)
+	//If the player is wall running, jump off the wall. Jumping off it stops the wall run and
+	//keeps the player from running on a wall again until TurnOffJumpOffWall
+	if (pressed && IsWallRunning() && SetParkourState(EParkourState::WallJump))
 	{
-		//Set is wall running to be false and is jumping off wall to be true
-		IsWallRunning = false;
-		_isJumpingOffWall = true;
 
 		//Get the right vector and select if the player launches to the right or the left
 		//based off if the player is on the right side of a wall or not
 		FVector actorRightVector = GetActorRightVector();
-		FVector launchVelocity = UKismetMathLibrary::SelectVector(actorRightVector * (- 450.0f - (GetMomentum() / 10.0f)), actorRightVector * (450.0f + (GetMomentum() / 10.0f)), _onRightSide);
+		FVector launchVelocity = UKismetMathLibrary::SelectVector(actorRightVector * (- 450.0f - (GetMomentum() / 10.0f)), actorRightVector * (450.0f + (GetMomentum() / 10.0f)), HasParkourFlag(PARKOUR_LastWallOnRight));
 
 		//Set the launch velocity z to be higher
 		launchVelocity.Z = 850.0f + (GetMomentum() / 10.0f);
@@ -656,9 +1174,6 @@ void ASkylineShredderCharacter::CheckJump()
 		LaunchCharacter(launchVelocity, false, false); 
 
 		NumberOfJumps = 1;
-
-		//Set a timer to call the turn off wall run function
-		GetWorldTimerManager().SetTimer(timerHandle, this, &ASkylineShredderCharacter::TurnOffJumpOffWall, .5f, false);
 	}
 }
 
@@ -668,148 +1183,60 @@ void ASkylineShredderCharacter::CheckJump()
 void ASkylineShredderCharacter::CustomJump()
 {
 	//If the player can jump
-	if (_jumping && GetCharacterMovement()->IsMovingOnGround()) {
+	if (IsJumpHeld() && GetCharacterMovement()->IsMovingOnGround()) {
 		//Add impulse to the player in the direction they are facing with respect to momentum
 		float newXForward = GetVelocity().GetSafeNormal().X;
 		float newYForward = GetVelocity().GetSafeNormal().Y;
-		GetCharacterMovement()->AddImpulse(FVector{ (GetActorForwardVector().X + newXForward) * (10000.0f + GetMomentum() * 10.0f), (GetActorForwardVector().Y + newYForward) * (10000.0f + GetMomentum() * 10.0f), 125000.0f });
+		MovementModifiers->AddImpulse(FVector{ (GetActorForwardVector().X + newXForward) * (10000.0f + GetMomentum() * 10.0f), (GetActorForwardVector().Y + newYForward) * (10000.0f + GetMomentum() * 10.0f), 125000.0f });
 	}
 }
 
-//This Function checks to see if the player is able to do a grapple by using a sphere trace to find if a grapple point is in range and is called when left click has been pressed
-void ASkylineShredderCharacter::CheckForGrapple()
+/// <summary>
+/// Checks if the player is holding movement input. The server doesn't get a remote player's
+/// input axes, so it uses the input flag the client sent with its moves
+/// </summary>
+bool ASkylineShredderCharacter::HasMovementInput() const
 {
-	//Initialize variables
-	bool bHit = false;
-	FHitResult HitResult;
-
-	//If already in action return
-	if (InAction)
-		return;
-
-	//Checks to see if the player not currently on the ground and that a grapple is not already attached to a point
-	if (!GetCharacterMovement()->GetCharacterOwner()->GetMovementComponent()->IsMovingOnGround() && !GrappleHookAttached) {
-
-		//Sets the start location of the trace to be the actors location
-		FVector Start = GetActorLocation();
+	if (!IsLocallyControlled() && GetLocalRole() == ROLE_Authority && SkylineMovement)
+		return SkylineMovement->HasNetworkMovementInput();
 
-		//The end point is the actors location and the camera direction being multiplied by a value
-		FVector End = Start + (UGameplayStatics::GetPlayerCameraManager(GetWorld(), 0)->GetCameraRotation().Vector() * 6000.0f);
-
-		//The raidus of the sphere
-		float radius = 2500.0f;
-
-		//Make an array of actors to ignore
-		TArray<AActor*> ActorsToIgnore;
-
-		//ingore the character during the check
-		ActorsToIgnore.Add(this);
-
-		//Establish an array of what object type to search for
-		TArray<TEnumAsByte<EObjectTypeQuery>> ObjectTypesArray;
-
-		//Set the object to looked for in the array in this case it is Game trace channel 2 because that it where the collision to check for is happening
-		ObjectTypesArray.Add(UEngineTypes::ConvertToObjectType(ECollisionChannel::ECC_GameTraceChannel2));
-
-		//Perform the sphere trace in this case it is searching for the specific object 
-		bHit = UKismetSystemLibrary::SphereTraceSingleForObjects(GetWorld(), Start, End, radius, ObjectTypesArray,
-			false, ActorsToIgnore, EDrawDebugTrace::None, HitResult, true);
-		//if the sphere trace has hit...
-		if (bHit) {
-			//...Set the grapple hook to be attached
-			GrappleHookAttached = true;
-			//Set the location of the where the hand model will be placed
-			HookLocation = HitResult.ImpactPoint;
-		}
-	}
-	else
-	{
-		//else set grapple to be false
-		GrappleHookAttached = false;
-	}
-	
+	return axisForward != 0.0f || axisRight != 0.0f;
 }
 
-//this function called when the player is using the grapple hook and calculates the logic of the grapple and swinging perameters
-void ASkylineShredderCharacter::DoGrapple()
+void ASkylineShredderCharacter::QueueJumpToggle()
 {
-	//Calculate character and hook direction and the direction between them
-	FVector CharacterLocation = GetActorLocation();
-	FVector HookDirection = (HookLocation - CharacterLocation).GetSafeNormal();
-
-	//Calculate the direction of the swing perpendicular to the hook direction
-	FVector SwingDirection = FVector::CrossProduct(HookDirection, FVector::UpVector).GetSafeNormal();
-
-	//Calculate the speed of the swing
-	float SwingSpeed = FVector::DotProduct(GetVelocity(), SwingDirection);
-
-	//Calculate the swing velocity vector
-	FVector SwingVelocity = SwingSpeed * SwingDirection;
-
-	//Calculate the direction of radial velocity perpendicular to both the hook and swinging directions
-	FVector RadialDirection = FVector::CrossProduct(SwingDirection, HookDirection).GetSafeNormal();
-
-	//Calculate the speed of radial velocity
-	float RadialSpeed = FVector::DotProduct(GetVelocity(), RadialDirection);
-
-	//Calculate the radial velocity vector
-	FVector RadialVelocity = RadialSpeed * RadialDirection;
-
-	//Calculate the total velocity vector by combining the swing and radial velocity vectors
-	FVector TotalVelocity = SwingVelocity + RadialVelocity;
+	//A move carries up to three, a press and release that don't fit are dropped together
+	_pendingJumpToggles = _pendingJumpToggles < 3 ? _pendingJumpToggles + 1 : 2;
+}
 
-	//Set the characters velocity to the total velocity vector
-	GetCharacterMovement()->Velocity = TotalVelocity;
+/// <summary>
+/// Starts the move on the server holding jump the way the owning client was, and queues the presses and releases it made during the move
+/// </summary>
+void ASkylineShredderCharacter::ApplyNetworkJump(bool bHeld, uint8 toggles)
+{
+	SetParkourFlag(PARKOUR_JumpHeld, bHeld);
+	_pendingJumpToggles = toggles;
+}
 
-	//Check if the player is touching the ground
-	if (GetCharacterMovement()->IsMovingOnGround())
-	{
-		//If the player is touching the ground, end the grapple
-		EndGrapple();
-	}
-	
+//The grapple is done by the grapple component, which any runner can have. These are kept for the input bindings and the blueprints
+void ASkylineShredderCharacter::CheckForGrapple()
+{
+	Grapple->CheckForGrapple();
 }
 
-//This function is called to end the grappling proccess and is called when left click has been released
 void ASkylineShredderCharacter::EndGrapple()
 {
-	//force variable created to apply a force once the grapple has been let go
-	FVector Force = GetActorForwardVector() * 200000.0f;
-
-	//If the grapple hook is not attached do nothing
-	if (!GrappleHookAttached) {
-		return;
-	}
-
-	//set the grapple hook to be not attached and reset the boost state
-	GrappleHookAttached = false;
-	HasAppliedBoost = false;
-	
-	_momentum += 300.0f;
-
-	//Apply the calculated impulse to the character
-	GetCharacterMovement()->AddImpulse(FVector(Force.X, Force.Y, 450.0f));
-	
+	Grapple->EndGrapple();
 }
 
-//this function is called to give the player the ability to apply an impulse once per grapple it is called when right click is pressed during the grapple
 void ASkylineShredderCharacter::GrappleBoost()
 {
-	//check to see if the grapple hook is attached and the player is not on the ground
-	if (GrappleHookAttached && !GetCharacterMovement()->IsMovingOnGround()) {
-		//if the boost not been applied yet
-		if (!HasAppliedBoost) {
-			//calculate the boost force
-			FVector BoostForce = GetActorForwardVector() * 150000;
-			//apply the boost to the character
-			GetCharacterMovement()->AddImpulse(FVector(BoostForce.X, BoostForce.Y, 0.0f));
-			//set the boost state to applied
-			HasAppliedBoost = true;
-			LastBoostTime = GetWorld()->TimeSeconds;
-			
-			
-		}
-	}
+	Grapple->GrappleBoost();
+}
+
+bool ASkylineShredderCharacter::IsGrappleHookAttached() const
+{
+	return Grapple->IsHookAttached();
 }
 
 ////Unused dash mechanic
@@ -843,12 +1270,11 @@ void ASkylineShredderCharacter::GrappleBoost()
 /// </summary>
 void ASkylineShredderCharacter::TurnOffJumpOffWall()
 {
-	//Set the booleans to be false
-	_isJumpingOffWall = false;
-	InAction = false;
-	//Set the gravity scale and plane constraints back to normal
-	GetCharacterMovement()->GravityScale = 1.0f;
-	GetCharacterMovement()->SetPlaneConstraintNormal(FVector(0.0f, 0.0f, 0.0f));
+	//The player can run on walls again
+	if (ParkourState == EParkourState::WallJump)
+		SetParkourState(EParkourState::None);
+	//Set the gravity scale back to normal
+	MovementModifiers->SetBaseGravityScale(1.0f);
 }
 
 /// <summary>
@@ -856,7 +1282,7 @@ void ASkylineShredderCharacter::TurnOffJumpOffWall()
 /// </summary>
 void ASkylineShredderCharacter::DoubleJumpOff()
 {
-	DoubleJumped = false;
+	SetParkourFlag(PARKOUR_DoubleJumped, false);
 }
 
 void ASkylineShredderCharacter::OnResetVR()
@@ -880,20 +1306,81 @@ void ASkylineShredderCharacter::TouchStopped(ETouchIndex::Type FingerIndex, FVec
 	StopJumping();
 }
 
+void ASkylineShredderCharacter::InputJumpPressed()
+{
+	if (_inputTape)
+		_inputTape->RecordJump(true);
+
+	QueueJumpToggle();
+}
+
+void ASkylineShredderCharacter::InputJumpReleased()
+{
+	if (_inputTape)
+		_inputTape->RecordJump(false);
+
+	QueueJumpToggle();
+}
+
+void ASkylineShredderCharacter::InputTurn(float Value)
+{
+	if (_inputTape)
+		_inputTape->RecordAxis(EParkourInputAxis::Turn, Value);
+
+	AddControllerYawInput(Value);
+}
+
+void ASkylineShredderCharacter::InputLookUp(float Value)
+{
+	if (_inputTape)
+		_inputTape->RecordAxis(EParkourInputAxis::LookUp, Value);
+
+	AddControllerPitchInput(Value);
+}
+
+/// <summary>
+/// Feeds a recorded frame of input through the same handlers the bindings call
+/// </summary>
+void ASkylineShredderCharacter::ApplyRecordedInput(const FParkourInputFrame& frame)
+{
+	//The controller applies look input before the character ticks, so put back the rotation it
+	//left rather than replaying the look input a frame late
+	if (Controller)
+		Controller->SetControlRotation(frame.ControlRotation);
+
+	//The player input calls action bindings before axis bindings, and both jump bindings toggle the jump
+	for (int32 i = 0; i < frame.NumJumpEvents; i++)
+		QueueJumpToggle();
+
+	MoveForward(frame.MoveForward);
+	MoveRight(frame.MoveRight);
+}
+
 void ASkylineShredderCharacter::TurnAtRate(float Rate)
 {
+	if (_inputTape)
+		_inputTape->RecordAxis(EParkourInputAxis::TurnRate, Rate);
+
 	// calculate delta for this frame from the rate information
 	AddControllerYawInput(Rate * BaseTurnRate * GetWorld()->GetDeltaSeconds());
 }
 
 void ASkylineShredderCharacter::LookUpAtRate(float Rate)
 {
+	if (_inputTape)
+		_inputTape->RecordAxis(EParkourInputAxis::LookUpRate, Rate);
+
 	// calculate delta for this frame from the rate information
 	AddControllerPitchInput(Rate * BaseLookUpRate * GetWorld()->GetDeltaSeconds());
 }
 
 void ASkylineShredderCharacter::MoveForward(float Value)
 {
+	if (_inputTape)
+		_inputTape->RecordAxis(EParkourInputAxis::MoveForward, Value);
+
+	axisForward = Value;
+
 	if ((Controller != nullptr) && (Value != 0.0f))
 	{
 		// find out which way is forward
@@ -908,6 +1395,11 @@ void ASkylineShredderCharacter::MoveForward(float Value)
 
 void ASkylineShredderCharacter::MoveRight(float Value)
 {
+	if (_inputTape)
+		_inputTape->RecordAxis(EParkourInputAxis::MoveRight, Value);
+
+	axisRight = Value;
+
 	if ((Controller != nullptr) && (Value != 0.0f))
 	{
 		// find out which way is right
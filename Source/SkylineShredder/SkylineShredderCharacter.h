@@ -4,8 +4,17 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
+#include "WorldCollision.h"
+#include "SkylineMovementComponent.h"
+#include "ParkourState.h"
+#include "ParkourAnimSnapshot.h"
+#include <atomic>
 #include "SkylineShredderCharacter.generated.h"
 
+class FParkourInputTape;
+class FParkourTelemetryWriter;
+struct FParkourInputFrame;
+
 UCLASS(config=Game)
 class ASkylineShredderCharacter : public ACharacter
 {
@@ -19,6 +28,21 @@ class ASkylineShredderCharacter : public ACharacter
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 		class UCameraComponent* FollowCamera;
 
+	/** Character movement with the wall run, grapple swing and vault movement modes */
+	class USkylineMovementComponent* SkylineMovement;
+
+	/** Speed, gravity and impulse modifiers from pads and other sources */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour, meta = (AllowPrivateAccess = "true"))
+		class UMovementModifierComponent* MovementModifiers;
+
+	/** Keeps the best grapple point in sight scored in the background */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Grapple, meta = (AllowPrivateAccess = "true"))
+		class UGrappleTargetingComponent* GrappleTargeting;
+
+	/** Hooks, swings and lets go of the grapple, only ticks while hooked */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Grapple, meta = (AllowPrivateAccess = "true"))
+		class UGrappleComponent* Grapple;
+
 
 private:
 	//Variables for setting up timers
@@ -26,11 +50,62 @@ private:
 	float _delayTimer;
 	ETraceTypeQuery ObjectType{};
 
-	//Axis variables
+	//Axis variables, snapshot of this frame's movement input
 	float axisForward;
 	float axisRight;
+
+	//The closest wall on one side of the player found by the wall run probe
+	struct FWallRunContact
+	{
+		bool bHit = false;
+		bool bWallRunnable = false;
+		float Distance = 0.0f;
+		FVector Normal = FVector::ZeroVector;
+		AActor* Actor = nullptr;
+		UPrimitiveComponent* Component = nullptr;
+	};
+
+	/// <summary>
+	/// Finds the closest wall on each side of the player with a single overlap
+	/// </summary>
+	/// <param name="outRight">the wall on the right of the player</param>
+	/// <param name="outLeft">the wall on the left of the player</param>
+	void ProbeWallRunContacts(FWallRunContact& outRight, FWallRunContact& outLeft) const;
+
+	//The parkour state sent to other players, set by the server every tick
+	UPROPERTY(ReplicatedUsing = OnRep_ParkourNetState)
+	FSkylineParkourNetState ParkourNetState;
+
+	UFUNCTION()
+	void OnRep_ParkourNetState();
+
+	//Records the input coming through the bindings, or replays a recording, while set
+	TSharedPtr<FParkourInputTape> _inputTape;
+
+	//Records a sample every frame while set, with the pad hits and grapple attaches since the last one
+	TSharedPtr<FParkourTelemetryWriter> _telemetry;
+	uint8 _telemetryEvents = 0;
+
+	void RecordTelemetry(float deltaTime);
+	void UpdateTelemetrySession();
+
+	//The animation snapshots, written at the end of Tick into the one the animation isn't reading and then
+	//published by flipping the index. The animation update of a frame is done before the next frame's Tick
+	FParkourAnimSnapshot _animSnapshots[2];
+	std::atomic<uint8> _animSnapshotIndex{ 0 };
+
+	void PublishAnimSnapshot();
+
+	//The jump and look bindings, these go through the input tape before doing what they did before
+	void InputJumpPressed();
+	void InputJumpReleased();
+	void InputTurn(float Value);
+	void InputLookUp(float Value);
+
+	//Jump presses and releases waiting for the next move, see QueueJumpToggle
+	uint8 _pendingJumpToggles = 0;
 public:
-	ASkylineShredderCharacter();
+	ASkylineShredderCharacter(const FObjectInitializer& ObjectInitializer);
 
 	/// <summary>
 	/// Update which handles all logic for the player
@@ -38,12 +113,29 @@ public:
 	/// <param name="deltaTime"></param>
 	virtual void Tick(float deltaTime) override;
 
+	/// <summary>
+	/// Picks the parkour simulation rate for this instance
+	/// </summary>
+	virtual void BeginPlay() override;
+
+	/// <summary>
+	/// Stops the runner significance from managing this character
+	/// </summary>
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//A player taking control of the character or letting go of it starts or finishes its telemetry session
+	virtual void PossessedBy(AController* NewController) override;
+	virtual void UnPossessed() override;
+	virtual void OnRep_Controller() override;
+
 	/// <summary>
 	/// When the player lands on the ground
 	/// </summary>
 	/// <param name="Hit"></param>
 	virtual void Landed(const FHitResult& Hit) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	/** Base turn rate, in deg/sec. Other scaling may affect final turn rate. */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
 		float BaseTurnRate;
@@ -52,52 +144,17 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera)
 		float BaseLookUpRate;
 
-	//Booleans used for animations in the blueprint and to check if the player 
-	//is in a certain action or not
+	//What the player is doing, used for animations in the blueprint and to check if the player is in an action.
+	//Only changed through SetParkourState, so the transitions follow the parkour state table
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool IsSprinting = false;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool IsSliding = false;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool IsClimbing = false;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool IsCrouching = false;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool IsVaulting = false;
-	UPROPERTY(VisibleAnywhere, BlueprintReadwrite, Category = Parkour)
-		bool InAction = false;
+		EParkourState ParkourState = EParkourState::None;
 
 public:
 	//Variable used for checking for climbing
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
 		bool ShouldPlayerClimb;
 
-	//Variables used for wall running
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool IsWallRunning;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool LeftSide;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool RightSide;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
-		bool DoubleJumped;
-
-	//Variables for Grappling
-	UPROPERTY(VisibleAnywhere, BlueprintReadWrite, Category = Grapple)
-	bool GrappleHookAttached = false;
-	float GrappleHookLength = 3000.0f;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Grapple)
-	FVector HookLocation;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Grapple)
-	bool HasAppliedBoost;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Grapple)
-	AActor* HookHitActor;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Grapple)
-	float LastBoostTime = 0.0f;
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Grapple)
-	float BoostCooldownTime = 2.0f;
 	float ForceMultiplier = 100.0f;
-	float GrappleImpulseMultiplier = 100.0f;
 
 	////Unused code for dashing
 	//float DashDistance = 1000.0f;
@@ -108,6 +165,35 @@ public:
 	//The base speed of the player
 	float BaseSpeed;
 
+	//The rate in Hz momentum and gravity are simulated at, independent of the framerate
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Parkour)
+	float ParkourSimulationRate = 60.0f;
+
+	//The parkour simulation rate used on dedicated servers, 0 uses ParkourSimulationRate
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Parkour)
+	float DedicatedServerParkourSimulationRate = 30.0f;
+
+	//The most simulation steps run in one frame before the remaining time is dropped
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Parkour)
+	int32 MaxParkourSimulationSteps = 8;
+
+	//If every run of a player on this machine is recorded as a telemetry session in Saved/Telemetry,
+	//the Parkour.Telemetry console command can still start and stop sessions by hand
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Parkour)
+	bool bRecordTelemetry = false;
+
+	//If the ledge traces are issued asynchronously ahead of time instead of when climbing is checked
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Parkour)
+	bool bAsyncLedgeDetection = true;
+
+	//How far the player can move before the ledge traces are issued again
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Parkour)
+	float LedgeProbeMoveThreshold = 10.0f;
+
+	//How far in degrees the player can turn before the ledge traces are issued again
+	UPROPERTY(Config, EditAnywhere, BlueprintReadOnly, Category = Parkour)
+	float LedgeProbeTurnThreshold = 5.0f;
+
 	//The number of jumps the player is currently at
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Parkour)
 	int NumberOfJumps;
@@ -122,21 +208,120 @@ private:
 	FVector _wallHeight;
 	FVector _otherWallHeight;
 
+	//State of the pipelined ledge probe. The wall trace comes back a frame after it is issued,
+	//then the height and thickness traces are issued from where it hit. The results are two frames
+	//old by the time they are published, so the traces are issued from where the player will be then
+	struct FLedgeProbe
+	{
+		FTraceHandle WallTrace;
+		FTraceHandle HeightTrace;
+		FTraceHandle ThicknessTrace;
+		uint64 WallTraceFrame = 0;
+		uint64 LedgeTraceFrame = 0;
+
+		//The frame the wall trace the height and thickness traces came from was issued on
+		uint64 LedgeRequestFrame = 0;
+
+		//Where the player was expected to be when the results of the wall trace are published
+		FVector WallTraceLocation = FVector(BIG_NUMBER);
+		FVector WallTraceForward = FVector::ForwardVector;
+
+		//The wall hit the height and thickness traces were issued from, and where the player was expected to be for it
+		FVector WallLocation;
+		FVector WallNormal;
+		FVector LedgeTraceLocation;
+		FVector LedgeTraceForward;
+
+		//Where the player was expected to be for the published ledge values, and the frame its wall trace was issued on
+		bool bHasResult = false;
+		uint64 ResultFrame = 0;
+		FVector ResultLocation;
+		FVector ResultForward;
+	};
+	FLedgeProbe _ledgeProbe;
+
+	bool CheckForBakedLedge(bool& outCanClimb);
+	void GetLedgeWallTrace(const FVector& location, const FVector& forward, FVector& outStart, FVector& outEnd) const;
+	void GetLedgeHeightTraces(const FVector& wallLocation, const FVector& wallNormal, FVector& outHeightStart, FVector& outHeightEnd, FVector& outThicknessStart, FVector& outThicknessEnd) const;
+	bool EvaluateLedge(const FHitResult& heightHit, const FHitResult& thicknessHit);
+	void UpdateLedgeProbe();
+	void PublishLedgeProbe(const FVector& location, const FVector& forward, uint64 requestFrame);
+	bool IsLedgeProbeRequestNewer(uint64 requestFrame) const { return !_ledgeProbe.bHasResult || requestFrame >= _ledgeProbe.ResultFrame; }
+	bool IsLedgeProbeCurrent() const;
+	bool IsLedgePoseClose(const FVector& locationA, const FVector& forwardA, const FVector& locationB, const FVector& forwardB) const;
+
 	//Momentum variable which affects the speed of the player
 	float _momentum;
 
+	//Momentum and gravity before the last simulation step, used to interpolate between steps
+	float _previousMomentum;
+	float _previousGravity;
+
+	//Time that has not been simulated yet and the length of a simulation step
+	float _simulationAccumulator;
+	float _simulationStep;
+
+	/// <summary>
+	/// Advances momentum and gravity by one fixed simulation step
+	/// </summary>
+	/// <param name="step">the length of the step in seconds</param>
+	void SimulateParkourStep(float step);
+
 	//Variables used for checking the height of the player frame by frame
 	float _lastFrameHeight;
 	float _currentFrameHeight;
 
-	//Variables used for wall running
-	bool _onRightSide;
-	bool _isJumpingOffWall;
-	bool _isJumping;
+	//What is true alongside the parkour state, a bit each
+	enum : uint8
+	{
+		PARKOUR_WallOnLeft = 1 << 0,
+		PARKOUR_WallOnRight = 1 << 1,
+		//The side of the last wall run, which way jumping or dropping off the wall launches
+		PARKOUR_LastWallOnRight = 1 << 2,
+		PARKOUR_DoubleJumped = 1 << 3,
+		PARKOUR_JumpHeld = 1 << 4
+	};
+	uint8 _parkourFlags = 0;
+
+	bool HasParkourFlag(uint8 flag) const { return (_parkourFlags & flag) != 0; }
+	void SetParkourFlag(uint8 flag, bool bSet) { _parkourFlags = bSet ? (_parkourFlags | flag) : (_parkourFlags & ~flag); }
+
+	//What each parkour state does when it is entered, left and every frame, indexed by the state
+	struct FParkourStateHandlers
+	{
+		void (ASkylineShredderCharacter::*Enter)();
+		void (ASkylineShredderCharacter::*Exit)();
+		void (ASkylineShredderCharacter::*Update)(float);
+	};
+	static const FParkourStateHandlers ParkourStateHandlers[(int32)EParkourState::Count];
+
+	/// <summary>
+	/// Leaves the current parkour state and enters a new one, if the parkour state table allows it
+	/// </summary>
+	/// <returns>true if the player is in the new state</returns>
+	bool SetParkourState(EParkourState state);
+
+	void EnterWallRun();
+	void ExitWallRun();
+	void EnterWallJump();
+	void ExitWallJump();
+	void ExitVaultOrClimb();
+
+	//Running, falling or jumping off a wall, keeps the ledge probe up to date and looks for walls to run on
+	void UpdateFreeState(float deltaTime);
+
+	//Wall running, vaulting or climbing, only keeps the wall contact up to date
+	void UpdateActionState(float deltaTime);
+
+	//Runs on the walls the player is next to while in the air, or lets go of them on the ground
+	void UpdateWallContact();
+
+	//Holds onto a wall the probe found and starts running on it if the player can
+	void StartWallRun(const FWallRunContact& contact, bool bOnRight);
+
+	//Lets go of the wall on one side
+	void LeaveWall(uint8 sideFlag);
 
-	//If the player is jumping
-	bool _jumping;
-	
 	//The amount of gravity on the player
 	float _gravity;
 
@@ -193,6 +378,14 @@ public:
 	FORCEINLINE class USpringArmComponent* GetCameraBoom() const { return CameraBoom; }
 	/** Returns FollowCamera subobject **/
 	FORCEINLINE class UCameraComponent* GetFollowCamera() const { return FollowCamera; }
+	/** Returns the character movement as the parkour movement component **/
+	FORCEINLINE class USkylineMovementComponent* GetSkylineMovement() const { return SkylineMovement; }
+	/** Returns MovementModifiers subobject **/
+	FORCEINLINE class UMovementModifierComponent* GetMovementModifiers() const { return MovementModifiers; }
+	/** Returns GrappleTargeting subobject **/
+	FORCEINLINE class UGrappleTargetingComponent* GetGrappleTargeting() const { return GrappleTargeting; }
+	/** Returns Grapple subobject **/
+	FORCEINLINE class UGrappleComponent* GetGrapple() const { return Grapple; }
 
 	//These functions and variables can be called in blueprint in case the user would like to change when they are used
 	UFUNCTION(BlueprintCallable, Category = "Parkour")
@@ -216,23 +409,121 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "Parkour")
 		void CustomJump();
 
+	//The grapple lives in the grapple component, these are kept for the input bindings and the blueprints
 	UFUNCTION(BlueprintCallable, Category = "Grapple")
 		void CheckForGrapple();
 
-	UFUNCTION(BlueprintCallable, Category = "Grapple")
-		void DoGrapple();
-
 	UFUNCTION(BlueprintCallable, Category = "Grapple")
 		void EndGrapple();
 
 	UFUNCTION(BlueprintCallable, Category = "Grapple")
 		void GrappleBoost();
 
+	UFUNCTION(BlueprintCallable, Category = "Grapple")
+		bool IsGrappleHookAttached() const;
+
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool IsInAction() const { return ParkourStateTable::IsInAction(ParkourState); }
+
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool IsWallRunning() const { return ParkourState == EParkourState::WallRun; }
+
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool IsVaulting() const { return ParkourState == EParkourState::Vault; }
+
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool IsClimbing() const { return ParkourState == EParkourState::Climb; }
+
+	//If there is a wall the player can run on to the left or right, whether or not they are running on it
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool IsWallOnLeft() const { return HasParkourFlag(PARKOUR_WallOnLeft); }
+
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool IsWallOnRight() const { return HasParkourFlag(PARKOUR_WallOnRight); }
+
+	//True for the frame the player double jumps on
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	bool HasDoubleJumped() const { return HasParkourFlag(PARKOUR_DoubleJumped); }
+
 	UFUNCTION(BlueprintCallable, Category = "Parkour")
 	float GetMomentum() { return _momentum; }
 
+	//Momentum is capped the same as when it builds up, and the interpolated momentum is moved by the same amount
+	//so a pad or a correction shows up at once instead of easing in
+	UFUNCTION(BlueprintCallable, Category = "Parkour")
+	void SetMomentum(float momentum) { momentum = FMath::Min(momentum, 1500.0f); _previousMomentum += momentum - _momentum; _momentum = momentum; }
+
+	//Momentum interpolated between the last two simulation steps, use this for anything displayed
 	UFUNCTION(BlueprintCallable, Category = "Parkour")
-	void SetMomentum(float momentum) { _momentum = momentum; }
+	float GetInterpolatedMomentum() const;
+
+	//Gets or puts back the whole momentum and gravity simulation, used to replay moves
+	FParkourSimulationState GetSimulationState() const;
+	void SetSimulationState(const FParkourSimulationState& state);
+
+	//Feeds movement input from a script instead of the input component, used to drive bots
+	void AddScriptedInput(float forward, float right) { MoveForward(forward); MoveRight(right); }
+
+	//Starts recording or replaying input with a tape, or stops with null
+	void SetInputTape(TSharedPtr<FParkourInputTape> tape) { _inputTape = MoveTemp(tape); }
+
+	//Records telemetry of the character while set, see bRecordTelemetry and Parkour.Telemetry
+	void SetTelemetry(TSharedPtr<FParkourTelemetryWriter> telemetry) { _telemetry = MoveTemp(telemetry); _telemetryEvents = 0; }
+	TSharedPtr<FParkourTelemetryWriter> GetTelemetry() const { return _telemetry; }
+
+	//Adds an event to the next telemetry sample, one of the FParkourTelemetrySample events. Nothing is kept while not recording
+	void AddTelemetryEvent(uint8 event) { if (_telemetry) _telemetryEvents |= event; }
+
+	/// <summary>
+	/// Feeds a recorded frame of input through the handlers the bindings call, in the order the player input calls them
+	/// </summary>
+	void ApplyRecordedInput(const FParkourInputFrame& frame);
+
+	//If the player is holding movement input, on the server this is what the owning client sent
+	bool HasMovementInput() const;
+
+	//Gets the animation snapshot published at the end of the last Tick, safe to call from the animation worker threads
+	FParkourAnimSnapshot GetAnimSnapshot() const { return _animSnapshots[_animSnapshotIndex.load(std::memory_order_acquire)]; }
+
+	//If the jump button is held
+	bool IsJumpHeld() const { return HasParkourFlag(PARKOUR_JumpHeld); }
+
+	/// <summary>
+	/// Presses jump if it is let go or lets go of it if it is held. It is done at the start of the next move,
+	/// so the owning client predicts it with the move and the server and replayed moves do it at the same point
+	/// </summary>
+	void QueueJumpToggle();
+
+	//The jump presses and releases waiting for the next move, saved with each move so replaying it jumps again
+	uint8 GetPendingJumpToggles() const { return _pendingJumpToggles; }
+	void SetPendingJumpToggles(uint8 toggles) { _pendingJumpToggles = toggles; }
+
+	/// <summary>
+	/// Runs as many fixed simulation steps as the time covers, called by the movement component for each move
+	/// </summary>
+	/// <param name="deltaTime">the length of the move</param>
+	void AdvanceParkourSimulation(float deltaTime);
+
+	/// <summary>
+	/// Jumps and takes the parkour state on by one move, called by the movement component before each move so the
+	/// owning client predicts it, the server runs it with the flags the client sent and corrections replay it
+	/// </summary>
+	/// <param name="deltaTime">the length of the move</param>
+	void UpdateParkourMove(float deltaTime);
+
+	/// <summary>
+	/// Starts the move on the server holding jump the way the owning client was, and queues the presses and releases it made during the move
+	/// </summary>
+	void ApplyNetworkJump(bool bHeld, uint8 toggles);
+
+	//The parkour flags, saved with each move
+	uint8 GetParkourFlags() const { return _parkourFlags; }
+
+	/// <summary>
+	/// Puts the parkour state back to what it was at the start of a move, without entering or leaving any state.
+	/// The movement mode is put back by the movement component
+	/// </summary>
+	void RestoreParkourState(EParkourState state, uint8 flags, int32 jumps);
 
 	/*UFUNCTION(BlueprintCallable, Category = "Dash")
 	void StartDash();*/
@@ -1,15 +1,74 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "SkylineShredderGameMode.h"
+#include "SkylineShredder.h"
 #include "SkylineShredderCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
 
 ASkylineShredderGameMode::ASkylineShredderGameMode()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnBPClass(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter"));
-	if (PlayerPawnBPClass.Class != NULL)
+	// set default pawn class to our Blueprinted character, only by path so loading the game mode doesn't load it
+	RunnerPawnClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/ThirdPersonCPP/Blueprints/ThirdPersonCharacter.ThirdPersonCharacter_C")));
+
+	// the native character is only used if the blueprint is missing
+	DefaultPawnClass = ASkylineShredderCharacter::StaticClass();
+}
+
+void ASkylineShredderGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	LoadStartTime = FPlatformTime::Seconds();
+
+	//Players are spawned as soon as the runner is in. The map's preloaded assets are only for drawing it,
+	//so they are loaded by the preload subsystem on the machines that draw it, not here
+	if (RunnerPawnClass.IsNull())
+	{
+		HandleRunnerLoaded();
+		return;
+	}
+
+	RunnerHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(RunnerPawnClass.ToSoftObjectPath(),
+		FStreamableDelegate::CreateUObject(this, &ASkylineShredderGameMode::HandleRunnerLoaded), FStreamableManager::AsyncLoadHighPriority);
+}
+
+bool ASkylineShredderGameMode::PlayerCanRestart_Implementation(APlayerController* Player)
+{
+	//Players joining while the runner is loading are spawned once it has
+	return bRunnerLoaded && Super::PlayerCanRestart_Implementation(Player);
+}
+
+UClass* ASkylineShredderGameMode::GetDefaultPawnClassForController_Implementation(AController* InController)
+{
+	//Anything spawning a pawn before the runner has loaded has to wait for it
+	if (!bRunnerLoaded && !RunnerPawnClass.IsNull())
+	{
+		UE_LOG(LogSkylineShredder, Warning, TEXT("Preload: a pawn was needed before the runner loaded, loading it now"));
+		if (UClass* RunnerClass = RunnerPawnClass.LoadSynchronous())
+			DefaultPawnClass = RunnerClass;
+	}
+
+	return Super::GetDefaultPawnClassForController_Implementation(InController);
+}
+
+void ASkylineShredderGameMode::HandleRunnerLoaded()
+{
+	if (UClass* RunnerClass = RunnerPawnClass.Get())
+		DefaultPawnClass = RunnerClass;
+	else if (!RunnerPawnClass.IsNull())
+		UE_LOG(LogSkylineShredder, Error, TEXT("Preload: could not load the runner %s"), *RunnerPawnClass.ToString());
+
+	bRunnerLoaded = true;
+	UE_LOG(LogSkylineShredder, Log, TEXT("Preload: runner loaded in %.1f ms"), (FPlatformTime::Seconds() - LoadStartTime) * 1000.0);
+
+	//Spawn everyone who joined while it was loading
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
 	{
-		DefaultPawnClass = PlayerPawnBPClass.Class;
+		APlayerController* Controller = It->Get();
+		if (Controller && !Controller->GetPawn() && PlayerCanRestart(Controller))
+			RestartPlayer(Controller);
 	}
 }
@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "SkylineShredderGameMode.generated.h"
 
+struct FStreamableHandle;
+
 UCLASS(minimalapi)
 class ASkylineShredderGameMode : public AGameModeBase
 {
@@ -13,6 +15,27 @@ class ASkylineShredderGameMode : public AGameModeBase
 
 public:
 	ASkylineShredderGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual bool PlayerCanRestart_Implementation(APlayerController* Player) override;
+	virtual UClass* GetDefaultPawnClassForController_Implementation(AController* InController) override;
+
+	//The runner blueprint, loaded in the background when the map starts instead of with the game mode.
+	//Clients and listen servers also load it with the map's preload manifest, see UPreloadSubsystem
+	UPROPERTY(EditDefaultsOnly, Category = Classes)
+	TSoftClassPtr<APawn> RunnerPawnClass;
+
+	//If the runner has loaded, players are only spawned once it has
+	bool IsRunnerLoaded() const { return bRunnerLoaded; }
+
+private:
+	//Kept so the runner stays loaded while the map is running
+	TSharedPtr<FStreamableHandle> RunnerHandle;
+
+	bool bRunnerLoaded = false;
+	double LoadStartTime = 0.0;
+
+	void HandleRunnerLoaded();
 };
 
 
@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WallRunSurfaceSubsystem.h"
+#include "Components/BoxComponent.h"
+#include "Components/PrimitiveComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/Level.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "PhysicsEngine/BodySetup.h"
+
+const FName UWallRunSurfaceSubsystem::NoWallrunTag(TEXT("NoWallrun"));
+
+FVector FWallRunSurface::SnapNormal(const FVector& ContactNormal) const
+{
+	if (!bHasFaceNormals)
+		return ContactNormal;
+
+	//Pick the face the contact normal is closest to
+	const FVector3f Normal(ContactNormal);
+	const float DotX = FVector3f::DotProduct(Normal, FaceNormalX);
+	const float DotY = FVector3f::DotProduct(Normal, FaceNormalY);
+	const FVector3f Face = FMath::Abs(DotX) >= FMath::Abs(DotY) ? FaceNormalX * FMath::Sign(DotX) : FaceNormalY * FMath::Sign(DotY);
+
+	//Contacts near a corner or on a bevel don't belong to either face
+	return FVector3f::DotProduct(Normal, Face) >= 0.98f ? FVector(Face) : ContactNormal;
+}
+
+void UWallRunSurfaceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UWallRunSurfaceSubsystem::HandleLevelAdded);
+	LevelRemovedHandle = FWorldDelegates::LevelRemovedFromWorld.AddUObject(this, &UWallRunSurfaceSubsystem::HandleLevelRemoved);
+}
+
+void UWallRunSurfaceSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(LevelAddedHandle);
+	FWorldDelegates::LevelRemovedFromWorld.Remove(LevelRemovedHandle);
+
+	if (UWorld* World = GetWorld())
+		World->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+
+	Surfaces.Empty();
+
+	Super::Deinitialize();
+}
+
+void UWallRunSurfaceSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	//Work out every surface in the loaded levels up front
+	for (TActorIterator<AActor> It(&InWorld); It; ++It)
+		RefreshActor(*It);
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &UWallRunSurfaceSubsystem::HandleActorSpawned));
+}
+
+const FWallRunSurface& UWallRunSurfaceSubsystem::GetSurface(UPrimitiveComponent* Component)
+{
+	if (const FWallRunSurface* Surface = Surfaces.Find(Component))
+		return *Surface;
+
+	//Surfaces that were missed when loading are worked out the first time they are touched
+	return Surfaces.Add(Component, BuildSurface(Component));
+}
+
+void UWallRunSurfaceSubsystem::RefreshActor(AActor* Actor)
+{
+	if (!Actor)
+		return;
+
+	TInlineComponentArray<UPrimitiveComponent*> Primitives(Actor);
+	for (UPrimitiveComponent* Primitive : Primitives)
+	{
+		if (Primitive->IsQueryCollisionEnabled())
+			Surfaces.Add(Primitive, BuildSurface(Primitive));
+	}
+}
+
+FWallRunSurface UWallRunSurfaceSubsystem::BuildSurface(const UPrimitiveComponent* Component)
+{
+	FWallRunSurface Surface;
+	if (!Component)
+		return Surface;
+
+	//Surfaces without an actor, or tagged not to wall run on, can't be wall run on
+	const AActor* Owner = Component->GetOwner();
+	Surface.bWallRunnable = Owner && !Owner->ActorHasTag(NoWallrunTag) && !Component->ComponentHasTag(NoWallrunTag);
+
+	//Static surfaces never turn, so the faces of box shaped ones can be cached. Anything else, like a cylinder
+	//or a slanted wall, has faces that don't line up with its axes
+	if (Component->Mobility == EComponentMobility::Static && HasBoxCollision(Component))
+	{
+		const FTransform& Transform = Component->GetComponentTransform();
+		FVector AxisX = Transform.GetUnitAxis(EAxis::X);
+		FVector AxisY = Transform.GetUnitAxis(EAxis::Y);
+		AxisX.Z = 0.0f;
+		AxisY.Z = 0.0f;
+
+		Surface.bHasFaceNormals = AxisX.Normalize() && AxisY.Normalize();
+		Surface.FaceNormalX = FVector3f(AxisX);
+		Surface.FaceNormalY = FVector3f(AxisY);
+	}
+
+	return Surface;
+}
+
+bool UWallRunSurfaceSubsystem::HasBoxCollision(const UPrimitiveComponent* Component)
+{
+	if (Component->IsA<UBoxComponent>())
+		return true;
+
+	const UStaticMeshComponent* StaticMeshComponent = Cast<UStaticMeshComponent>(Component);
+	const UStaticMesh* StaticMesh = StaticMeshComponent ? StaticMeshComponent->GetStaticMesh() : nullptr;
+	const UBodySetup* BodySetup = StaticMesh ? StaticMesh->GetBodySetup() : nullptr;
+	if (!BodySetup || BodySetup->CollisionTraceFlag == CTF_UseComplexAsSimple)
+		return false;
+
+	//Only boxes, and only ones turned in steps of 90 degrees around the up axis
+	const FKAggregateGeom& AggGeom = BodySetup->AggGeom;
+	if (AggGeom.BoxElems.Num() == 0 || AggGeom.SphereElems.Num() > 0 || AggGeom.SphylElems.Num() > 0 || AggGeom.ConvexElems.Num() > 0 || AggGeom.TaperedCapsuleElems.Num() > 0)
+		return false;
+
+	for (const FKBoxElem& Box : AggGeom.BoxElems)
+	{
+		const float YawRemainder = FMath::Fmod(FMath::Abs(Box.Rotation.Yaw), 90.0f);
+		if (!FMath::IsNearlyZero(Box.Rotation.Pitch, 1.0f) || !FMath::IsNearlyZero(Box.Rotation.Roll, 1.0f) || FMath::Min(YawRemainder, 90.0f - YawRemainder) > 1.0f)
+			return false;
+	}
+
+	return true;
+}
+
+void UWallRunSurfaceSubsystem::HandleActorSpawned(AActor* Actor)
+{
+	RefreshActor(Actor);
+}
+
+void UWallRunSurfaceSubsystem::HandleLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (!Level || World != GetWorld())
+		return;
+
+	for (AActor* Actor : Level->Actors)
+		RefreshActor(Actor);
+}
+
+void UWallRunSurfaceSubsystem::HandleLevelRemoved(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld())
+		return;
+
+	//Drop the surfaces that go away with the level, a null level means every level is going away
+	for (auto It = Surfaces.CreateIterator(); It; ++It)
+	{
+		const UPrimitiveComponent* Component = It.Key().ResolveObjectPtr();
+		if (!Component || !Level || Component->GetComponentLevel() == Level)
+			It.RemoveCurrent();
+	}
+}
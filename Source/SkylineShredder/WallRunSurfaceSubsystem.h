@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WallRunSurfaceSubsystem.generated.h"
+
+//Wall running data worked out once for a surface
+struct FWallRunSurface
+{
+	//If the player can wall run on the surface
+	bool bWallRunnable = false;
+	//If the face normals below are known, only for static surfaces with box collision
+	bool bHasFaceNormals = false;
+	//The horizontal face normals of the surface, a box shaped wall faces along these or their opposites
+	FVector3f FaceNormalX = FVector3f::ZeroVector;
+	FVector3f FaceNormalY = FVector3f::ZeroVector;
+
+	/// <summary>
+	/// Snaps a contact normal onto the closest cached face normal so the wall run direction
+	/// stays stable, returns the contact normal if no face is close enough
+	/// </summary>
+	FVector SnapNormal(const FVector& ContactNormal) const;
+};
+
+/// <summary>
+/// Works out which surfaces can be wall run on when the level loads, so the wall run check
+/// only has to do a single hash lookup instead of resolving the actor and comparing tags
+/// </summary>
+UCLASS()
+class SKYLINESHREDDER_API UWallRunSurfaceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	/// <summary>
+	/// Gets the wall run data for a surface, working it out if it hasn't been seen before
+	/// </summary>
+	const FWallRunSurface& GetSurface(UPrimitiveComponent* Component);
+
+	/// <summary>
+	/// Works out the wall run data for an actor's surfaces again, call this after changing its tags
+	/// </summary>
+	void RefreshActor(AActor* Actor);
+
+	//The tag that stops an actor or component from being wall run on
+	static const FName NoWallrunTag;
+
+	/// <summary>
+	/// Works out the wall run data for a surface without caching it
+	/// </summary>
+	static FWallRunSurface BuildSurface(const UPrimitiveComponent* Component);
+
+private:
+	TMap<TObjectKey<UPrimitiveComponent>, FWallRunSurface> Surfaces;
+
+	FDelegateHandle ActorSpawnedHandle;
+	FDelegateHandle LevelAddedHandle;
+	FDelegateHandle LevelRemovedHandle;
+
+	//If the collision of a surface is boxes lined up with it, so its sides face along its axes
+	static bool HasBoxCollision(const UPrimitiveComponent* Component);
+
+	void HandleActorSpawned(AActor* Actor);
+	void HandleLevelAdded(ULevel* Level, UWorld* World);
+	void HandleLevelRemoved(ULevel* Level, UWorld* World);
+};